@@ -59,6 +59,9 @@ void R5xxXAADestroy(ScrnInfoPtr pScrn);
 Bool R5xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen);
 void R5xxEXACloseScreen(ScreenPtr pScreen);
 void R5xxEXADestroy(ScrnInfoPtr pScrn);
+#ifdef USE_DRI
+void R5xxEXAUploadReset(ScrnInfoPtr pScrn);
+#endif
 
 /* radeon_exa_render.c */
 void R5xxExaCompositeFuncs(int scrnIndex, struct _ExaDriver *Exa);
@@ -52,6 +52,8 @@
 
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_prof.h"
+#include "rhd_swap.h"
 #include "r5xx_accel.h"
 #include "r5xx_regs.h"
 
@@ -68,6 +70,16 @@ struct R5xxExaPrivate {
     CARD8 *Buffer;
     unsigned int BufferIntAddress;
     CARD32 BufferSize;
+
+    /* For Upload: two more, so that we can fill one while the other is blitted. */
+    struct {
+	CARD8 *Buffer;
+	unsigned int IntAddress;
+	CARD32 Fence;
+	Bool Busy;
+    } Upload[2];
+    CARD32 UploadSize;
+    int UploadCurrent;
 #endif
 
     int exaSyncMarker;
@@ -124,8 +136,7 @@ R5xxEXASync(ScreenPtr pScreen, int marker)
     if (ExaPrivate->exaMarkerSynced != marker) {
 	struct RhdCS *CS = RHDPTR(pScrn)->CS;
 
-	RHDCSFlush(CS);
-	RHDCSIdle(CS);
+	RHDCSFenceWait(CS, RHDCSFenceEmit(CS));
 	R5xx2DIdle(pScrn);
 
 	ExaPrivate->exaMarkerSynced = marker;
@@ -180,6 +191,9 @@ R5xxEXAPrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
 
     RHDCSAdvance(CS);
 
+    RHDProfBegin(xf86Screens[rhdPtr->scrnIndex], RHD_PROF_SOLID, alu,
+		 pPix->drawable.bitsPerPixel);
+
     return TRUE;
 }
 
@@ -191,10 +205,11 @@ R5xxEXASolid(PixmapPtr pPix, int x1, int y1, int x2, int y2)
 {
     struct RhdCS *CS = RHDPTRE(pPix->drawable.pScreen)->CS;
 
-    RHDCSGrab(CS, 2 * 2);
+    RHDCSGrab(CS, 1 + 2);
 
-    RHDCSRegWrite(CS, R5XX_DST_Y_X, (y1 << 16) | x1);
-    RHDCSRegWrite(CS, R5XX_DST_HEIGHT_WIDTH, ((y2 - y1) << 16) | (x2 - x1));
+    RHDCSRegWriteRun(CS, R5XX_DST_Y_X, 2);
+    RHDCSWrite(CS, (y1 << 16) | x1); /* R5XX_DST_Y_X */
+    RHDCSWrite(CS, ((y2 - y1) << 16) | (x2 - x1)); /* R5XX_DST_HEIGHT_WIDTH */
 
     RHDCSAdvance(CS);
 }
@@ -207,6 +222,8 @@ R5xxEXADoneSolid(PixmapPtr pPix)
 {
     struct RhdCS *CS = RHDPTRE(pPix->drawable.pScreen)->CS;
     R5xxEngineWaitIdle2D(CS);
+
+    RHDProfEnd(xf86Screens[pPix->drawable.pScreen->myNum]);
 }
 
 /*
@@ -279,6 +296,9 @@ R5xxEXAPrepareCopy(PixmapPtr pSrc, PixmapPtr pDst, int xdir, int ydir, int rop,
 
     RHDCSAdvance(CS);
 
+    RHDProfBegin(xf86Screens[rhdPtr->scrnIndex], RHD_PROF_COPY, rop,
+		 pDst->drawable.bitsPerPixel);
+
     return TRUE;
 }
 
@@ -301,11 +321,12 @@ R5xxEXACopy(PixmapPtr pDst, int srcX, int srcY, int dstX, int dstY, int w, int h
 	dstY += h - 1;
     }
 
-    RHDCSGrab(CS, 2 * 3);
+    RHDCSGrab(CS, 1 + 3);
 
-    RHDCSRegWrite(CS, R5XX_SRC_Y_X, (srcY << 16) | srcX);
-    RHDCSRegWrite(CS, R5XX_DST_Y_X, (dstY << 16) | dstX);
-    RHDCSRegWrite(CS, R5XX_DST_HEIGHT_WIDTH, (h << 16) | w);
+    RHDCSRegWriteRun(CS, R5XX_SRC_Y_X, 3);
+    RHDCSWrite(CS, (srcY << 16) | srcX); /* R5XX_SRC_Y_X */
+    RHDCSWrite(CS, (dstY << 16) | dstX); /* R5XX_DST_Y_X */
+    RHDCSWrite(CS, (h << 16) | w); /* R5XX_DST_HEIGHT_WIDTH */
 
     RHDCSAdvance(CS);
 }
@@ -318,58 +339,10 @@ R5xxEXADoneCopy(PixmapPtr pDst)
 {
     struct RhdCS *CS = RHDPTRE(pDst->drawable.pScreen)->CS;
     R5xxEngineWaitIdle2D(CS);
-}
-
-/*
- * Buffer swaps for big endian.
- */
-#if X_BYTE_ORDER == X_BIG_ENDIAN
-static inline void
-R5xxCopySwap32(CARD8 *dst, CARD8 *src, unsigned int size)
-{
-    unsigned int *d = (unsigned int *)dst;
-    unsigned int *s = (unsigned int *)src;
-    unsigned int nwords = size >> 2;
-
-    for (; nwords > 0; --nwords, ++d, ++s)
-#ifdef __powerpc__
-	asm volatile("stwbrx %0,0,%1" : : "r" (*s), "r" (d));
-#else
-        *d = ((*s >> 24) & 0xff) | ((*s >> 8) & 0xff00)
-	    | ((*s & 0xff00) << 8) | ((*s & 0xff) << 24);
-#endif
-}
-
-static inline void
-R5xxCopySwapHDW(CARD8 *dst, CARD8 *src, unsigned int size)
-{
-    unsigned int *d = (unsigned int *)dst;
-    unsigned int *s = (unsigned int *)src;
-    unsigned int nwords = size >> 2;
 
-    for (; nwords > 0; --nwords, ++d, ++s)
-	*d = ((*s & 0xffff) << 16) | ((*s >> 16) & 0xffff);
+    RHDProfEnd(xf86Screens[pDst->drawable.pScreen->myNum]);
 }
 
-#ifdef USE_DRI
-static inline void
-R5xxCopySwap16(CARD8 *dst, CARD8 *src, unsigned int size)
-{
-    unsigned short *d = (unsigned short *)dst;
-    unsigned short *s = (unsigned short *)src;
-    unsigned int nwords = size >> 1;
-
-    for (; nwords > 0; --nwords, ++d, ++s)
-#ifdef __powerpc__
-	asm volatile("stwbrx %0,0,%1" : : "r" (*s), "r" (d));
-#else
-        *d = ((*s >> 24) & 0xff) | ((*s >> 8) & 0xff00)
-	    | ((*s & 0xff00) << 8) | ((*s & 0xff) << 24);
-#endif
-}
-#endif /* USE_DRI */
-
-#endif /* X_BYTE_ORDER */
 
 /* Copies a single pass worth of data for a hostdata blit set up by
  * R5XXHostDataBlit().
@@ -380,10 +353,10 @@ R5xxBufCopyUpload(CARD8 *dst, CARD8 *src, unsigned int size, CARD8 bpp)
 #if X_BYTE_ORDER == X_BIG_ENDIAN
     switch (bpp) {
     case 8:
-	R5xxCopySwap32(dst, src, size);
+	RHDCopySwap32(dst, src, size);
 	return;
     case 16:
-	R5xxCopySwapHDW(dst, src, size);
+	RHDCopySwapHDW(dst, src, size);
 	return;
     default:
 	memcpy(dst, src, size);
@@ -437,6 +410,9 @@ R5xxEXAUploadToScreenCP(PixmapPtr pDst, int x, int y, int w, int h,
 
     R5xxEngineWaitIdle3D(CS);
 
+    RHDProfBegin(xf86Screens[rhdPtr->scrnIndex], RHD_PROF_UPLOAD, 0,
+		 pDst->drawable.bitsPerPixel);
+
     for (; h; ) {
 	hpass = min((unsigned int) h, hpass);
 	dwords = hpass * bufpitch / 4;
@@ -484,6 +460,8 @@ R5xxEXAUploadToScreenCP(PixmapPtr pDst, int x, int y, int w, int h,
 
     exaMarkSync(pDst->drawable.pScreen);
     R5xxEngineWaitIdle2D(CS);
+
+    RHDProfEnd(xf86Screens[rhdPtr->scrnIndex]);
     return TRUE;
 }
 
@@ -502,6 +480,9 @@ R5xxEXAUploadToScreenManual(PixmapPtr pDst, int x, int y, int w, int h,
     if (pDst->drawable.bitsPerPixel < 8)
 	return FALSE;
 
+    RHDProfBegin(xf86Screens[rhdPtr->scrnIndex], RHD_PROF_UPLOAD, 0,
+		 pDst->drawable.bitsPerPixel);
+
     /* Do we need that sync here ? probably not .... */
     exaWaitSync(pDst->drawable.pScreen);
 
@@ -514,6 +495,8 @@ R5xxEXAUploadToScreenManual(PixmapPtr pDst, int x, int y, int w, int h,
 	dst += dst_pitch;
     }
 
+    RHDProfEnd(xf86Screens[rhdPtr->scrnIndex]);
+
     return TRUE;
 }
 
@@ -529,6 +512,9 @@ R5xxEXADownloadFromScreenManual(PixmapPtr pSrc, int x, int y, int w, int h,
 	rhdPtr->FbScanoutStart + exaGetPixmapOffset(pSrc);
     int	src_pitch = exaGetPixmapPitch(pSrc);
 
+    RHDProfBegin(xf86Screens[rhdPtr->scrnIndex], RHD_PROF_DOWNLOAD, 0,
+		 pSrc->drawable.bitsPerPixel);
+
     /* Can't accelerate download */
     exaWaitSync(pSrc->drawable.pScreen);
 
@@ -541,23 +527,27 @@ R5xxEXADownloadFromScreenManual(PixmapPtr pSrc, int x, int y, int w, int h,
 	dst += dst_pitch;
     }
 
+    RHDProfEnd(xf86Screens[rhdPtr->scrnIndex]);
+
     return TRUE;
 }
 
 #ifdef USE_DRI
 /*
- *
+ * Copies between system memory and a GART buffer. Unlike hostdata, the engine
+ * accesses the GART as little endian memory, so both directions need the
+ * same swapping.
  */
 static inline void
-R5xxBufCopyDownload(CARD8 *dst, CARD8 *src, unsigned int size, CARD8 bpp)
+R5xxBufCopyGART(CARD8 *dst, CARD8 *src, unsigned int size, CARD8 bpp)
 {
 #if X_BYTE_ORDER == X_BIG_ENDIAN
     switch (bpp) {
     case 16:
-	R5xxCopySwap16(dst, src, size);
+	RHDCopySwap16(dst, src, size);
 	return;
     case 32:
-	R5xxCopySwap32(dst, src, size);
+	RHDCopySwap32(dst, src, size);
 	return;
     default:
 	memcpy(dst, src, size);
@@ -572,10 +562,10 @@ R5xxBufCopyDownload(CARD8 *dst, CARD8 *src, unsigned int size, CARD8 bpp)
  * Emit blit with arbitrary source and destination offsets and pitches
  */
 static inline void
-R5xxEXADownloadBlit(struct RhdCS *CS, CARD32 datatype,
-		    CARD32 srcPitch, CARD32 srcOffset,
-		    CARD32 dstPitch, CARD32 dstOffset,
-		    int srcX, int srcY, int w, int h)
+R5xxEXABufferBlit(struct RhdCS *CS, CARD32 datatype,
+		  CARD32 srcPitch, CARD32 srcOffset,
+		  CARD32 dstPitch, CARD32 dstOffset,
+		  int srcX, int srcY, int dstX, int dstY, int w, int h)
 {
     RHDCSGrab(CS, 2 * 6);
 
@@ -592,7 +582,7 @@ R5xxEXADownloadBlit(struct RhdCS *CS, CARD32 datatype,
     RHDCSRegWrite(CS, R5XX_SRC_PITCH_OFFSET, (srcPitch << 16) | (srcOffset >> 10));
     RHDCSRegWrite(CS, R5XX_DST_PITCH_OFFSET, (dstPitch << 16) | (dstOffset >> 10));
     RHDCSRegWrite(CS, R5XX_SRC_Y_X, (srcY << 16) | srcX);
-    RHDCSRegWrite(CS, R5XX_DST_Y_X, 0);
+    RHDCSRegWrite(CS, R5XX_DST_Y_X, (dstY << 16) | dstX);
     RHDCSRegWrite(CS, R5XX_DST_HEIGHT_WIDTH, (h << 16) | w);
 
     RHDCSFlush(CS);
@@ -646,21 +636,22 @@ R5xxEXADownloadFromScreenCP(PixmapPtr pSrc, int x, int y, int w, int h,
 
     R5xxEngineWaitIdle3D(CS);
 
+    RHDProfBegin(pScrn, RHD_PROF_DOWNLOAD, 0, pSrc->drawable.bitsPerPixel);
+
     while (h) {
 	hpass = min((unsigned int) h, hpass);
-	R5xxEXADownloadBlit(CS, datatype, srcpitch, srcoffset, BufferPitch,
-			    ExaPrivate->BufferIntAddress, x, y, w, hpass);
+	R5xxEXABufferBlit(CS, datatype, srcpitch, srcoffset, BufferPitch,
+			  ExaPrivate->BufferIntAddress, x, y, 0, 0, w, hpass);
 	y += hpass;
 	h -= hpass;
 
 	/* this is quite a big hammer, but we have no other option here */
-	RHDCSFlush(CS);
-	RHDCSIdle(CS);
+	RHDCSFenceWait(CS, RHDCSFenceEmit(CS));
 	R5xx2DIdle(pScrn);
 
 	/* Copy out data from previous blit */
 	if ((wpass == BufferPitch) && (wpass == (unsigned int) dstpitch)) {
-	    R5xxBufCopyDownload((CARD8*)dst, ExaPrivate->Buffer, wpass * hpass,
+	    R5xxBufCopyGART((CARD8*)dst, ExaPrivate->Buffer, wpass * hpass,
 				pSrc->drawable.bitsPerPixel);
 	    dst += dstpitch * hpass;
 	} else {
@@ -668,7 +659,7 @@ R5xxEXADownloadFromScreenCP(PixmapPtr pSrc, int x, int y, int w, int h,
 	    unsigned int i;
 
 	    for (i = 0; i < hpass; i++) {
-		R5xxBufCopyDownload((CARD8*)dst, buf, wpass,
+		R5xxBufCopyGART((CARD8*)dst, buf, wpass,
 				    pSrc->drawable.bitsPerPixel);
 		buf += BufferPitch;
 		dst += dstpitch;
@@ -681,6 +672,105 @@ R5xxEXADownloadFromScreenCP(PixmapPtr pSrc, int x, int y, int w, int h,
     ExaPrivate->exaMarkerSynced = ExaPrivate->exaSyncMarker;
     R5xxEngineWaitIdle2D(CS);
 
+    RHDProfEnd(pScrn);
+
+    return TRUE;
+}
+
+/*
+ * Copy the data into one of the upload buffers in gart space, and blit it
+ * from there into the destination pixmap. The ring only carries the blits,
+ * and we only wait for the engine when we need to refill a buffer that is
+ * still being read from.
+ */
+static Bool
+R5xxEXAUploadToScreenGART(PixmapPtr pDst, int x, int y, int w, int h,
+			  char *src, int srcpitch)
+{
+    ScrnInfoPtr pScrn = xf86Screens[pDst->drawable.pScreen->myNum];
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct RhdCS *CS = rhdPtr->CS;
+    struct R5xxExaPrivate *ExaPrivate = rhdPtr->TwoDPrivate;
+    CARD32 datatype, dstpitch, dstoffset;
+    CARD32 BufferPitch;
+    CARD32 wpass, hpass;
+
+    /* Why does EXA even bother to pass us this? */
+    if (!w || !h || !srcpitch)
+	return FALSE;
+
+    wpass = w * pDst->drawable.bitsPerPixel / 8;
+    BufferPitch = (wpass + 63) & ~63;
+    hpass = ExaPrivate->UploadSize / BufferPitch;
+    if (!hpass) /* can't happen with a 64kB buffer and our maxPitchBytes */
+	return R5xxEXAUploadToScreenCP(pDst, x, y, w, h, src, srcpitch);
+
+    datatype = R5xxEXADatatypeGet(pDst->drawable.bitsPerPixel);
+    if (!datatype) {
+	xf86DrvMsg(rhdPtr->scrnIndex, X_ERROR, "%s: Unsupported bitdepth %d\n",
+		   __func__, pDst->drawable.bitsPerPixel);
+	return FALSE;
+    }
+
+    dstpitch = exaGetPixmapPitch(pDst);
+    if (R5XX_EXA_PITCH_CHECK(dstpitch)) {
+	xf86DrvMsg(rhdPtr->scrnIndex, X_ERROR, "%s: Invalid destination pitch: %d\n",
+		   __func__, (unsigned int) dstpitch);
+	return FALSE;
+    }
+
+    dstoffset = exaGetPixmapOffset(pDst);
+    if (R5XX_EXA_OFFSET_CHECK(dstoffset)) {
+	xf86DrvMsg(rhdPtr->scrnIndex, X_ERROR, "%s: Invalid destination offset: %d\n",
+		   __func__, (unsigned int) dstoffset);
+	return FALSE;
+    }
+    dstoffset += rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
+
+    R5xxEngineWaitIdle3D(CS);
+
+    RHDProfBegin(pScrn, RHD_PROF_UPLOAD, 0, pDst->drawable.bitsPerPixel);
+
+    while (h) {
+	int i = ExaPrivate->UploadCurrent;
+	CARD8 *buf = ExaPrivate->Upload[i].Buffer;
+	unsigned int j;
+
+	hpass = min((unsigned int) h, hpass);
+
+	/* wait for the last blit out of this buffer */
+	if (ExaPrivate->Upload[i].Busy)
+	    RHDCSFenceWait(CS, ExaPrivate->Upload[i].Fence);
+
+	for (j = 0; j < hpass; j++) {
+	    R5xxBufCopyGART(buf, (CARD8 *) src, wpass,
+			    pDst->drawable.bitsPerPixel);
+	    buf += BufferPitch;
+	    src += srcpitch;
+	}
+
+	R5xxEXABufferBlit(CS, datatype, BufferPitch, ExaPrivate->Upload[i].IntAddress,
+			  dstpitch, dstoffset, 0, 0, x, y, w, hpass);
+
+	/* the fence is only an interrupt; make the cp wait for the blit to
+	 * have finished reading from the buffer before it is signalled. */
+	RHDCSGrab(CS, 2);
+	RHDCSRegWrite(CS, R5XX_WAIT_UNTIL,
+		      R5XX_WAIT_2D_IDLECLEAN | R5XX_WAIT_DMA_GUI_IDLE);
+
+	ExaPrivate->Upload[i].Fence = RHDCSFenceEmit(CS);
+	ExaPrivate->Upload[i].Busy = TRUE;
+	ExaPrivate->UploadCurrent = !i;
+
+	y += hpass;
+	h -= hpass;
+    }
+
+    exaMarkSync(pDst->drawable.pScreen);
+    R5xxEngineWaitIdle2D(CS);
+
+    RHDProfEnd(pScrn);
+
     return TRUE;
 }
 #endif /* USE_DRI */
@@ -761,6 +851,40 @@ R5xxEXAFinishAccess(PixmapPtr pPix, int index)
 
 #endif /* X_BYTE_ORDER == X_BIG_ENDIAN */
 
+#ifdef USE_DRI
+/*
+ *
+ */
+static void
+R5xxEXABuffersDiscard(int scrnIndex, struct R5xxExaPrivate *ExaPrivate)
+{
+    int i;
+
+    if (ExaPrivate->Buffer)
+	RHDDRMIndirectBufferDiscard(scrnIndex, ExaPrivate->Buffer);
+
+    for (i = 0; i < 2; i++)
+	if (ExaPrivate->Upload[i].Buffer)
+	    RHDDRMIndirectBufferDiscard(scrnIndex, ExaPrivate->Upload[i].Buffer);
+}
+
+/*
+ * The engine has been idled: nothing is left to wait for, and the fences
+ * do not carry over a VT switch.
+ */
+void
+R5xxEXAUploadReset(ScrnInfoPtr pScrn)
+{
+    struct R5xxExaPrivate *ExaPrivate = RHDPTR(pScrn)->TwoDPrivate;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+	ExaPrivate->Upload[i].Busy = FALSE;
+	ExaPrivate->Upload[i].Fence = 0;
+    }
+}
+#endif /* USE_DRI */
+
 /*
  *
  */
@@ -832,6 +956,22 @@ R5xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
 		       "Failed to get an indirect buffer for fast download.\n");
 	    EXAInfo->DownloadFromScreen = R5xxEXADownloadFromScreenManual;
 	}
+
+	if (ExaPrivate->Buffer) {
+	    ExaPrivate->Upload[0].Buffer =
+		RHDDRMIndirectBufferGet(CS->scrnIndex, &ExaPrivate->Upload[0].IntAddress,
+					&ExaPrivate->UploadSize);
+	    if (ExaPrivate->Upload[0].Buffer)
+		ExaPrivate->Upload[1].Buffer =
+		    RHDDRMIndirectBufferGet(CS->scrnIndex, &ExaPrivate->Upload[1].IntAddress,
+					    &ExaPrivate->UploadSize);
+	}
+
+	if (ExaPrivate->Upload[1].Buffer)
+	    EXAInfo->UploadToScreen = R5xxEXAUploadToScreenGART;
+	else
+	    xf86DrvMsg(CS->scrnIndex, X_INFO,
+		       "Failed to get indirect buffers for fast upload.\n");
     } else
 #endif /* USE_DRI */
 	EXAInfo->DownloadFromScreen = R5xxEXADownloadFromScreenManual;
@@ -847,8 +987,7 @@ R5xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
 
     if (!exaDriverInit(pScreen, EXAInfo)) {
 #ifdef USE_DRI
-	if (ExaPrivate->Buffer)
-	    RHDDRMIndirectBufferDiscard(CS->scrnIndex, ExaPrivate->Buffer);
+	R5xxEXABuffersDiscard(CS->scrnIndex, ExaPrivate);
 #endif
 	xfree(ExaPrivate);
 	xfree(EXAInfo);
@@ -892,10 +1031,7 @@ R5xxEXADestroy(ScrnInfoPtr pScrn)
 
     if (rhdPtr->TwoDPrivate) {
 #ifdef USE_DRI
-	struct R5xxExaPrivate *ExaPrivate = rhdPtr->TwoDPrivate;
-
-	if (ExaPrivate->Buffer)
-	    RHDDRMIndirectBufferDiscard(rhdPtr->scrnIndex, ExaPrivate->Buffer);
+	R5xxEXABuffersDiscard(rhdPtr->scrnIndex, rhdPtr->TwoDPrivate);
 #endif
 
 	xfree(rhdPtr->TwoDPrivate);
@@ -257,6 +257,9 @@
 #define R5XX_DP_SRC_BKGD_CLR              0x15dc
 #define R5XX_DP_SRC_FRGD_CLR              0x15d8
 
+/* the DRM ages its dma buffers through this one */
+#define R5XX_SCRATCH_REG1                 0x15e4
+
 #define R5XX_DST_LINE_START               0x1600
 #define R5XX_DST_LINE_END                 0x1604
 #define R5XX_DST_LINE_PATCOUNT            0x1608
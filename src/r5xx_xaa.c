@@ -74,6 +74,7 @@
 
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_swap.h"
 #include "r5xx_accel.h"
 #include "r5xx_regs.h"
 
@@ -113,8 +114,7 @@ R5xxXAAIdle(ScrnInfoPtr pScrn)
 {
     struct RhdCS *CS = RHDPTR(pScrn)->CS;
 
-    RHDCSFlush(CS);
-    RHDCSIdle(CS);
+    RHDCSFenceWait(CS, RHDCSFenceEmit(CS));
     R5xx2DIdle(pScrn);
 }
 
@@ -382,13 +382,15 @@ R5xxXAASubsequentScreenToScreenCopy(ScrnInfoPtr pScrn, int xa, int ya,
 	yb += h - 1;
     }
 
-    RHDCSGrab(CS, 2 * 5);
+    RHDCSGrab(CS, 1 + 2 + 1 + 3);
 
-    RHDCSRegWrite(CS, R5XX_SRC_PITCH_OFFSET, XaaPrivate->dst_pitch_offset);
-    RHDCSRegWrite(CS, R5XX_DST_PITCH_OFFSET, XaaPrivate->dst_pitch_offset);
-    RHDCSRegWrite(CS, R5XX_SRC_Y_X, (ya << 16) | xa);
-    RHDCSRegWrite(CS, R5XX_DST_Y_X, (yb << 16) | xb);
-    RHDCSRegWrite(CS, R5XX_DST_HEIGHT_WIDTH, (h << 16) | w);
+    RHDCSRegWriteRun(CS, R5XX_SRC_PITCH_OFFSET, 2);
+    RHDCSWrite(CS, XaaPrivate->dst_pitch_offset); /* R5XX_SRC_PITCH_OFFSET */
+    RHDCSWrite(CS, XaaPrivate->dst_pitch_offset); /* R5XX_DST_PITCH_OFFSET */
+    RHDCSRegWriteRun(CS, R5XX_SRC_Y_X, 3);
+    RHDCSWrite(CS, (ya << 16) | xa); /* R5XX_SRC_Y_X */
+    RHDCSWrite(CS, (yb << 16) | xb); /* R5XX_DST_Y_X */
+    RHDCSWrite(CS, (h << 16) | w); /* R5XX_DST_HEIGHT_WIDTH */
 
     RHDCSAdvance(CS);
 }
@@ -457,12 +459,13 @@ R5xxXAASubsequentMono8x8PatternFillRect(ScrnInfoPtr pScrn,
     struct R5xxXaaPrivate *XaaPrivate = RHDPTR(pScrn)->TwoDPrivate;
     struct RhdCS *CS = RHDPTR(pScrn)->CS;
 
-    RHDCSGrab(CS, 2 * 4);
+    RHDCSGrab(CS, 2 * 2 + 1 + 2);
 
     RHDCSRegWrite(CS, R5XX_DST_PITCH_OFFSET, XaaPrivate->dst_pitch_offset);
     RHDCSRegWrite(CS, R5XX_BRUSH_Y_X, (patterny << 8) | patternx);
-    RHDCSRegWrite(CS, R5XX_DST_Y_X, (y << 16) | x);
-    RHDCSRegWrite(CS, R5XX_DST_HEIGHT_WIDTH, (h << 16) | w);
+    RHDCSRegWriteRun(CS, R5XX_DST_Y_X, 2);
+    RHDCSWrite(CS, (y << 16) | x); /* R5XX_DST_Y_X */
+    RHDCSWrite(CS, (h << 16) | w); /* R5XX_DST_HEIGHT_WIDTH */
 
     RHDCSAdvance(CS);
 }
@@ -754,35 +757,6 @@ R5xxXAASubsequentScanlineCPUToScreenColorExpandFillCP(ScrnInfoPtr pScrn, int x,
     R5xxXAACPScanlinePacket(CS, XaaPrivate);
 }
 
-#if X_BYTE_ORDER == X_BIG_ENDIAN
-
-static inline void
-R5xxXAAScanlineSwap16(unsigned int *Buf, unsigned int nwords)
-{
-    unsigned int *d = Buf;
-    unsigned int *s = Buf;
-
-    for (; nwords > 0; --nwords, ++d, ++s)
-	*d = ((*s & 0xffff) << 16) | ((*s >> 16) & 0xffff);
-}
-
-static inline void
-R5xxXAAScanlineSwap8(unsigned int *Buf, unsigned int nwords)
-{
-    unsigned int *d = Buf;
-    unsigned int *s = Buf;
-
-    for (; nwords > 0; --nwords, ++d, ++s)
-#ifdef __powerpc__
-	asm volatile("stwbrx %0,0,%1" : : "r" (*s), "r" (d));
-#else
-    *d = ((*s >> 24) & 0xff) | ((*s >> 8) & 0xff00)
-	| ((*s & 0xff00) << 8) | ((*s & 0xff) << 24);
-#endif
-}
-
-#endif /* X_BYTE_ORDER */
-
 /*
  * Subsequent XAA indirect CPU-to-screen color expansion and indirect
  * image write.  This is called once for each scanline.
@@ -800,12 +774,13 @@ R5xxXAASubsequentScanlineCP(ScrnInfoPtr pScrn, int bufno)
     }
 
 #if X_BYTE_ORDER == X_BIG_ENDIAN
+    /* in place */
     if (XaaPrivate->scanline_bpp == 16)
-	R5xxXAAScanlineSwap16((unsigned int *)XaaPrivate->BufferHook[0],
-			     XaaPrivate->scanline_words);
+	RHDCopySwapHDW(XaaPrivate->BufferHook[0], XaaPrivate->BufferHook[0],
+		       4 * XaaPrivate->scanline_words);
     else if (XaaPrivate->scanline_bpp < 15)
-	R5xxXAAScanlineSwap8((unsigned int *)XaaPrivate->BufferHook[0],
-			    XaaPrivate->scanline_words);
+	RHDCopySwap32(XaaPrivate->BufferHook[0], XaaPrivate->BufferHook[0],
+		      4 * XaaPrivate->scanline_words);
 #endif
 
     if (--XaaPrivate->scanline_hpass) {
@@ -34,11 +34,25 @@
 
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_prof.h"
+#include "rhd_randr.h"
 #include "r6xx_accel.h"
 #include "r600_shader.h"
 #include "r600_reg.h"
 #include "r600_state.h"
 
+#include "picturestr.h"
+#include "glyphstr.h"
+#include "mipict.h"
+#ifdef DAMAGE
+# include "damage.h"
+#endif
+
+#if defined(DAMAGE) && defined(GlyphPicture) && \
+    ((EXA_VERSION_MAJOR > 2) || (EXA_VERSION_MAJOR == 2 && EXA_VERSION_MINOR >= 1))
+#define R600_GLYPH_CACHE 1
+#endif
+
 /* #define SHOW_VERTEXES */
 
 #       define RADEON_ROP3_ZERO             0x00000000
@@ -83,6 +97,86 @@ R600DoneSolid(PixmapPtr pPix);
 static void
 R600DoneComposite(PixmapPtr pDst);
 
+/*
+ * Can all vertex coordinates for a surface of this size be passed as
+ * unsigned 16bit integers?
+ */
+static Bool
+R600VtxFits16(int width, int height)
+{
+    return (width <= 0xFFFF) && (height <= 0xFFFF);
+}
+
+/*
+ * When enabled, offscreen pixmaps that are made up of whole 8x8 tiles are
+ * kept 1D tiled. Whatever gets scanned out stays linear.
+ */
+int
+R600PixmapArrayMode(PixmapPtr pPix)
+{
+    ScrnInfoPtr pScrn = xf86Screens[pPix->drawable.pScreen->myNum];
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
+
+    if (!accel_state->tiling)
+	return ARRAY_LINEAR_GENERAL;
+
+    /* front buffer */
+    if (exaGetPixmapOffset(pPix) < rhdPtr->EXAInfo->offScreenBase)
+	return ARRAY_LINEAR_GENERAL;
+
+    /* pitch is always a multiple of 8 pixels, see pixmapPitchAlign */
+    if (pPix->drawable.height & 7)
+	return ARRAY_LINEAR_GENERAL;
+
+    if ((pPix->drawable.bitsPerPixel != 8) &&
+	(pPix->drawable.bitsPerPixel != 16) &&
+	(pPix->drawable.bitsPerPixel != 32))
+	return ARRAY_LINEAR_GENERAL;
+
+    /* shadow of a rotated CRTC */
+    if (rhdPtr->randr && RHDRRPixmapIsShadow(pScrn, pPix))
+	return ARRAY_LINEAR_GENERAL;
+
+    return ARRAY_1D_TILED_THIN1;
+}
+
+/* The fill colour goes into the PS constants. */
+static void
+R600SolidColor(ScrnInfoPtr pScrn, PixmapPtr pPix, Pixel fg)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    uint32_t a, r, g, b;
+    float ps_alu_consts[4];
+
+    /* PS alu constants */
+    if (pPix->drawable.bitsPerPixel == 16) {
+	r = (fg >> 11) & 0x1f;
+	g = (fg >> 5) & 0x3f;
+	b = (fg >> 0) & 0x1f;
+	ps_alu_consts[0] = (float)r / 31; /* R */
+	ps_alu_consts[1] = (float)g / 63; /* G */
+	ps_alu_consts[2] = (float)b / 31; /* B */
+	ps_alu_consts[3] = 1.0; /* A */
+    } else if (pPix->drawable.bitsPerPixel == 8) {
+	a = (fg >> 0) & 0xff;
+	ps_alu_consts[0] = 0.0; /* R */
+	ps_alu_consts[1] = 0.0; /* G */
+	ps_alu_consts[2] = 0.0; /* B */
+	ps_alu_consts[3] = (float)a / 255; /* A */
+    } else {
+	a = (fg >> 24) & 0xff;
+	r = (fg >> 16) & 0xff;
+	g = (fg >> 8) & 0xff;
+	b = (fg >> 0) & 0xff;
+	ps_alu_consts[0] = (float)r / 255; /* R */
+	ps_alu_consts[1] = (float)g / 255; /* G */
+	ps_alu_consts[2] = (float)b / 255; /* B */
+	ps_alu_consts[3] = (float)a / 255; /* A */
+    }
+    set_alu_consts(pScrn, accel_state->ib, 0, sizeof(ps_alu_consts) / SQ_ALU_CONSTANT_offset, ps_alu_consts);
+}
+
 static Bool
 R600PrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
 {
@@ -92,24 +186,46 @@ R600PrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
     cb_config_t     cb_conf;
     shader_config_t vs_conf, ps_conf;
     int pmask = 0;
-    uint32_t a, r, g, b;
-    float ps_alu_consts[4];
-
-    accel_state->dst_mc_addr = exaGetPixmapOffset(pPix) + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
-    accel_state->dst_size = exaGetPixmapPitch(pPix) * pPix->drawable.height;
-    accel_state->dst_pitch = exaGetPixmapPitch(pPix) / (pPix->drawable.bitsPerPixel / 8);
+    uint64_t dst_mc_addr = exaGetPixmapOffset(pPix) + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
+    uint32_t dst_pitch = exaGetPixmapPitch(pPix) / (pPix->drawable.bitsPerPixel / 8);
 
     /* bad pitch */
-    if (accel_state->dst_pitch & 7)
+    if (dst_pitch & 7)
 	return FALSE;
 
     /* bad offset */
-    if (accel_state->dst_mc_addr & 0xff)
+    if (dst_mc_addr & 0xff)
 	return FALSE;
 
     if (pPix->drawable.bitsPerPixel == 24)
 	return FALSE;
 
+    /*
+     * Window backgrounds and the like come in long runs of fills into the
+     * same pixmap. When nothing else touched the engine since the last one,
+     * it is still set up for this, and only the colour needs updating.
+     */
+    if (accel_state->solid_valid && accel_state->XHas3DEngineState &&
+	(accel_state->solid_alu == alu) && (accel_state->solid_pm == pm) &&
+	(accel_state->dst_mc_addr == dst_mc_addr) &&
+	(accel_state->dst_pitch == dst_pitch) &&
+	(accel_state->dst_height == pPix->drawable.height) &&
+	(accel_state->dst_bpp == pPix->drawable.bitsPerPixel)) {
+	if (!R600IBStart(pScrn))
+	    return FALSE;
+	R600SolidColor(pScrn, pPix, fg);
+
+	RHDProfBegin(pScrn, RHD_PROF_SOLID, alu, pPix->drawable.bitsPerPixel);
+
+	return TRUE;
+    }
+
+    accel_state->dst_mc_addr = dst_mc_addr;
+    accel_state->dst_size = exaGetPixmapPitch(pPix) * pPix->drawable.height;
+    accel_state->dst_pitch = dst_pitch;
+    accel_state->dst_height = pPix->drawable.height;
+    accel_state->dst_bpp = pPix->drawable.bitsPerPixel;
+
     CLEAR (cb_conf);
     CLEAR (vs_conf);
     CLEAR (ps_conf);
@@ -121,7 +237,11 @@ R600PrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
 	   pPix->drawable.bitsPerPixel, exaGetPixmapPitch(pPix));
 #endif
 
-    accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+    /* the dst fields above no longer match what the engine is set up for */
+    accel_state->solid_valid = FALSE;
+
+    if (!R600IBStart(pScrn))
+	return FALSE;
 
     /* Init */
     start_3d(pScrn, accel_state->ib);
@@ -131,11 +251,18 @@ R600PrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
     set_default_state(pScrn, accel_state->ib);
 
     /* Scissor / viewport */
-    EREG(accel_state->ib, PA_CL_VTE_CNTL,                      VTX_XY_FMT_bit);
-    EREG(accel_state->ib, PA_CL_CLIP_CNTL,                     CLIP_DISABLE_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_VTE_CNTL,    VTX_XY_FMT_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_CLIP_CNTL,   CLIP_DISABLE_bit);
 
-    accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
-	accel_state->solid_vs_offset;
+    /* EXA clips to the pixmap, so this decides for all rects to come */
+    accel_state->vtx_packed = R600VtxFits16(pPix->drawable.width, pPix->drawable.height);
+
+    if (accel_state->vtx_packed)
+	accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
+	    accel_state->solid_packed_vs_offset;
+    else
+	accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
+	    accel_state->solid_vs_offset;
     accel_state->ps_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
 	accel_state->solid_ps_offset;
     accel_state->vs_size = 512;
@@ -173,15 +300,16 @@ R600PrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
 	pmask |= 1; /* R */
     if (pm & 0xff000000)
 	pmask |= 8; /* A */
-    EREG(accel_state->ib, CB_SHADER_MASK,                      (pmask << OUTPUT0_ENABLE_shift));
-    EREG(accel_state->ib, R7xx_CB_SHADER_CONTROL,              (RT0_ENABLE_bit));
-    EREG(accel_state->ib, CB_COLOR_CONTROL,                    RADEON_ROP[alu]);
+    set_context_reg(pScrn, accel_state->ib, CB_SHADER_MASK,    (pmask << OUTPUT0_ENABLE_shift));
+    set_context_reg(pScrn, accel_state->ib, R7xx_CB_SHADER_CONTROL, (RT0_ENABLE_bit));
+    set_context_reg(pScrn, accel_state->ib, CB_COLOR_CONTROL,  RADEON_ROP[alu]);
 
 
     cb_conf.id = 0;
     cb_conf.w = accel_state->dst_pitch;
     cb_conf.h = pPix->drawable.height;
     cb_conf.base = accel_state->dst_mc_addr;
+    cb_conf.array_mode = R600PixmapArrayMode(pPix);
 
     if (pPix->drawable.bitsPerPixel == 8) {
 	cb_conf.format = COLOR_8;
@@ -197,62 +325,41 @@ R600PrepareSolid(PixmapPtr pPix, int alu, Pixel pm, Pixel fg)
     cb_conf.blend_clamp = 1;
     set_render_target(pScrn, accel_state->ib, &cb_conf);
 
-    EREG(accel_state->ib, PA_SU_SC_MODE_CNTL,                  (FACE_bit			|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
-    EREG(accel_state->ib, DB_SHADER_CONTROL,                   ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
+    set_context_reg(pScrn, accel_state->ib, PA_SU_SC_MODE_CNTL, (FACE_bit			|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
+    set_context_reg(pScrn, accel_state->ib, DB_SHADER_CONTROL, ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
 								DUAL_EXPORT_ENABLE_bit)); /* Only useful if no depth export */
 
     /* Interpolator setup */
     /* one unused export from VS (VS_EXPORT_COUNT is zero based, count minus one) */
-    EREG(accel_state->ib, SPI_VS_OUT_CONFIG, (0 << VS_EXPORT_COUNT_shift));
-    EREG(accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_CONFIG, (0 << VS_EXPORT_COUNT_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
 
     /* Enabling flat shading needs both FLAT_SHADE_bit in SPI_PS_INPUT_CNTL_x
      * *and* FLAT_SHADE_ENA_bit in SPI_INTERP_CONTROL_0 */
     /* no VS exports as PS input (NUM_INTERP is not zero based, no minus one) */
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_0,                 (0 << NUM_INTERP_shift));
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_1,                 0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_0, (0 << NUM_INTERP_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_1, 0);
     /* color semantic id 0 -> GPR[0] */
-    EREG(accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2),       ((0    << SEMANTIC_shift)	|
-								(0x03 << DEFAULT_VAL_shift)	|
-								FLAT_SHADE_bit		|
-								SEL_CENTROID_bit));
-    EREG(accel_state->ib, SPI_INTERP_CONTROL_0,                FLAT_SHADE_ENA_bit | 0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2), ((0    << SEMANTIC_shift)	|
+									    (0x03 << DEFAULT_VAL_shift)	|
+									    FLAT_SHADE_bit		|
+									    SEL_CENTROID_bit));
+    set_context_reg(pScrn, accel_state->ib, SPI_INTERP_CONTROL_0, FLAT_SHADE_ENA_bit | 0);
 
-    /* PS alu constants */
-    if (pPix->drawable.bitsPerPixel == 16) {
-	r = (fg >> 11) & 0x1f;
-	g = (fg >> 5) & 0x3f;
-	b = (fg >> 0) & 0x1f;
-	ps_alu_consts[0] = (float)r / 31; /* R */
-	ps_alu_consts[1] = (float)g / 63; /* G */
-	ps_alu_consts[2] = (float)b / 31; /* B */
-	ps_alu_consts[3] = 1.0; /* A */
-    } else if (pPix->drawable.bitsPerPixel == 8) {
-	a = (fg >> 0) & 0xff;
-	ps_alu_consts[0] = 0.0; /* R */
-	ps_alu_consts[1] = 0.0; /* G */
-	ps_alu_consts[2] = 0.0; /* B */
-	ps_alu_consts[3] = (float)a / 255; /* A */
-    } else {
-	a = (fg >> 24) & 0xff;
-	r = (fg >> 16) & 0xff;
-	g = (fg >> 8) & 0xff;
-	b = (fg >> 0) & 0xff;
-	ps_alu_consts[0] = (float)r / 255; /* R */
-	ps_alu_consts[1] = (float)g / 255; /* G */
-	ps_alu_consts[2] = (float)b / 255; /* B */
-	ps_alu_consts[3] = (float)a / 255; /* A */
-    }
-    set_alu_consts(pScrn, accel_state->ib, 0, sizeof(ps_alu_consts) / SQ_ALU_CONSTANT_offset, ps_alu_consts);
+    R600SolidColor(pScrn, pPix, fg);
 
-    accel_state->vb_index = 0;
+    accel_state->solid_valid = TRUE;
+    accel_state->solid_alu = alu;
+    accel_state->solid_pm = pm;
 
 #ifdef SHOW_VERTEXES
     ErrorF("PM: 0x%08x\n", pm);
 #endif
 
+    RHDProfBegin(pScrn, RHD_PROF_SOLID, alu, pPix->drawable.bitsPerPixel);
+
     return TRUE;
 }
 
@@ -263,26 +370,38 @@ R600Solid(PixmapPtr pPix, int x1, int y1, int x2, int y2)
     ScrnInfoPtr pScrn = xf86Screens[pPix->drawable.pScreen->myNum];
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
-    float *vb;
+    int vtx_size = accel_state->vtx_packed ? 4 : 8;
 
-    if (((accel_state->vb_index + 3) * 8) > (accel_state->ib->total / 2)) {
+    if (!R600VBFits(pScrn, vtx_size, 3)) {
 	R600DoneSolid(pPix);
-	accel_state->vb_index = 0;
-	accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+	if (!R600VBNext(pScrn))
+	    return;
+	RHDProfResume(pScrn);
     }
 
-    vb = (pointer)((char*)accel_state->ib->address +
-		   (accel_state->ib->total / 2) +
-		   accel_state->vb_index * 8);
+    if (accel_state->vtx_packed) {
+	uint16_t *vb = R600VBPointer(pScrn, vtx_size);
+
+	vb[0] = x1;
+	vb[1] = y1;
+
+	vb[2] = x1;
+	vb[3] = y2;
 
-    vb[0] = (float)x1;
-    vb[1] = (float)y1;
+	vb[4] = x2;
+	vb[5] = y2;
+    } else {
+	float *vb = R600VBPointer(pScrn, vtx_size);
+
+	vb[0] = (float)x1;
+	vb[1] = (float)y1;
 
-    vb[2] = (float)x1;
-    vb[3] = (float)y2;
+	vb[2] = (float)x1;
+	vb[3] = (float)y2;
 
-    vb[4] = (float)x2;
-    vb[5] = (float)y2;
+	vb[4] = (float)x2;
+	vb[5] = (float)y2;
+    }
 
     accel_state->vb_index += 3;
 
@@ -296,18 +415,18 @@ R600DoneSolid(PixmapPtr pPix)
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
     draw_config_t   draw_conf;
     vtx_resource_t  vtx_res;
+    int vtx_size = accel_state->vtx_packed ? 4 : 8;
 
     CLEAR (draw_conf);
     CLEAR (vtx_res);
 
     if (accel_state->vb_index == 0) {
-	R600IBDiscard(pScrn, accel_state->ib);
+	RHDProfEnd(pScrn);
 	return;
     }
 
-    accel_state->vb_mc_addr = RHDDRIGetIntGARTLocation(pScrn) +
-	(accel_state->ib->idx * accel_state->ib->total) + (accel_state->ib->total / 2);
-    accel_state->vb_size = accel_state->vb_index * 8;
+    accel_state->vb_mc_addr = R600VBAddress(pScrn);
+    accel_state->vb_size = accel_state->vb_index * vtx_size;
 
     /* flush vertex cache */
     if ((rhdPtr->ChipSet == RHD_RV610) ||
@@ -326,7 +445,7 @@ R600DoneSolid(PixmapPtr pPix)
 
     /* Vertex buffer setup */
     vtx_res.id              = SQ_VTX_RESOURCE_vs;
-    vtx_res.vtx_size_dw     = 8 / 4;
+    vtx_res.vtx_size_dw     = vtx_size / 4;
     vtx_res.vtx_num_entries = accel_state->vb_size / 4;
     vtx_res.mem_req_size    = 1;
     vtx_res.vb_addr         = accel_state->vb_mc_addr;
@@ -347,13 +466,17 @@ R600DoneSolid(PixmapPtr pPix)
     cp_set_surface_sync(pScrn, accel_state->ib, (CB_ACTION_ENA_bit | CB0_DEST_BASE_ENA_bit),
 			accel_state->dst_size, accel_state->dst_mc_addr);
 
-    R600CPFlushIndirect(pScrn, accel_state->ib);
+    RHDProfEnd(pScrn);
+
+    R600IBFinish(pScrn);
 }
 
-static void
+static Bool
 R600DoPrepareCopy(ScrnInfoPtr pScrn,
 		  int src_pitch, int src_width, int src_height, uint32_t src_offset, int src_bpp,
+		  int src_array_mode,
 		  int dst_pitch, int dst_height, uint32_t dst_offset, int dst_bpp,
+		  int dst_array_mode,
 		  int rop, Pixel planemask)
 {
     RHDPtr rhdPtr = RHDPTR(pScrn);
@@ -370,7 +493,8 @@ R600DoPrepareCopy(ScrnInfoPtr pScrn,
     CLEAR (vs_conf);
     CLEAR (ps_conf);
 
-    accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+    if (!R600IBStart(pScrn))
+	return FALSE;
 
     /* Init */
     start_3d(pScrn, accel_state->ib);
@@ -380,11 +504,19 @@ R600DoPrepareCopy(ScrnInfoPtr pScrn,
     set_default_state(pScrn, accel_state->ib);
 
     /* Scissor / viewport */
-    EREG(accel_state->ib, PA_CL_VTE_CNTL,                      VTX_XY_FMT_bit);
-    EREG(accel_state->ib, PA_CL_CLIP_CNTL,                     CLIP_DISABLE_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_VTE_CNTL,    VTX_XY_FMT_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_CLIP_CNTL,   CLIP_DISABLE_bit);
 
-    accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
-	accel_state->copy_vs_offset;
+    /* dst_pitch is never smaller than the dst width */
+    accel_state->vtx_packed = R600VtxFits16(src_width, src_height) &&
+	R600VtxFits16(dst_pitch, dst_height);
+
+    if (accel_state->vtx_packed)
+	accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
+	    accel_state->copy_packed_vs_offset;
+    else
+	accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
+	    accel_state->copy_vs_offset;
     accel_state->ps_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
 	accel_state->copy_ps_offset;
     accel_state->vs_size = 512;
@@ -433,6 +565,7 @@ R600DoPrepareCopy(ScrnInfoPtr pScrn,
     tex_res.dim                 = SQ_TEX_DIM_2D;
     tex_res.base                = accel_state->src_mc_addr[0];
     tex_res.mip_base            = accel_state->src_mc_addr[0];
+    tex_res.tile_mode           = src_array_mode;
     if (src_bpp == 8) {
 	tex_res.format              = FMT_8;
 	tex_res.dst_sel_x           = SQ_SEL_1; /* R */
@@ -479,9 +612,9 @@ R600DoPrepareCopy(ScrnInfoPtr pScrn,
 	pmask |= 1; /* R */
     if (planemask & 0xff000000)
 	pmask |= 8; /* A */
-    EREG  (accel_state->ib, CB_SHADER_MASK,                      (pmask << OUTPUT0_ENABLE_shift));
-    EREG  (accel_state->ib, R7xx_CB_SHADER_CONTROL,              (RT0_ENABLE_bit));
-    EREG  (accel_state->ib, CB_COLOR_CONTROL,                    RADEON_ROP[rop]);
+    set_context_reg(pScrn, accel_state->ib, CB_SHADER_MASK,      (pmask << OUTPUT0_ENABLE_shift));
+    set_context_reg(pScrn, accel_state->ib, R7xx_CB_SHADER_CONTROL, (RT0_ENABLE_bit));
+    set_context_reg(pScrn, accel_state->ib, CB_COLOR_CONTROL,    RADEON_ROP[rop]);
 
     accel_state->dst_size = dst_pitch * dst_height * (dst_bpp/8);
     accel_state->dst_mc_addr = dst_offset;
@@ -493,6 +626,7 @@ R600DoPrepareCopy(ScrnInfoPtr pScrn,
     cb_conf.w = accel_state->dst_pitch;
     cb_conf.h = dst_height;
     cb_conf.base = accel_state->dst_mc_addr;
+    cb_conf.array_mode = dst_array_mode;
     if (dst_bpp == 8) {
 	cb_conf.format = COLOR_8;
 	cb_conf.comp_swap = 3; /* A */
@@ -507,30 +641,31 @@ R600DoPrepareCopy(ScrnInfoPtr pScrn,
     cb_conf.blend_clamp = 1;
     set_render_target(pScrn, accel_state->ib, &cb_conf);
 
-    EREG(accel_state->ib, PA_SU_SC_MODE_CNTL,                  (FACE_bit			|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
-    EREG(accel_state->ib, DB_SHADER_CONTROL,                   ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
+    set_context_reg(pScrn, accel_state->ib, PA_SU_SC_MODE_CNTL, (FACE_bit			|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
+    set_context_reg(pScrn, accel_state->ib, DB_SHADER_CONTROL, ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
 								DUAL_EXPORT_ENABLE_bit)); /* Only useful if no depth export */
 
     /* Interpolator setup */
     /* export tex coord from VS */
-    EREG(accel_state->ib, SPI_VS_OUT_CONFIG, ((1 - 1) << VS_EXPORT_COUNT_shift));
-    EREG(accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_CONFIG, ((1 - 1) << VS_EXPORT_COUNT_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
 
     /* Enabling flat shading needs both FLAT_SHADE_bit in SPI_PS_INPUT_CNTL_x
      * *and* FLAT_SHADE_ENA_bit in SPI_INTERP_CONTROL_0 */
     /* input tex coord from VS */
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_0,                 ((1 << NUM_INTERP_shift)));
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_1,                 0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_0, ((1 << NUM_INTERP_shift)));
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_1, 0);
     /* color semantic id 0 -> GPR[0] */
-    EREG(accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2),       ((0    << SEMANTIC_shift)	|
-								(0x01 << DEFAULT_VAL_shift)	|
-								SEL_CENTROID_bit));
-    EREG(accel_state->ib, SPI_INTERP_CONTROL_0,                0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2), ((0    << SEMANTIC_shift)	|
+									    (0x01 << DEFAULT_VAL_shift)	|
+									    SEL_CENTROID_bit));
+    set_context_reg(pScrn, accel_state->ib, SPI_INTERP_CONTROL_0, 0);
 
     accel_state->vb_index = 0;
 
+    return TRUE;
 }
 
 static void
@@ -540,18 +675,16 @@ R600DoCopy(ScrnInfoPtr pScrn)
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
     draw_config_t   draw_conf;
     vtx_resource_t  vtx_res;
+    int vtx_size = accel_state->vtx_packed ? 8 : 16;
 
     CLEAR (draw_conf);
     CLEAR (vtx_res);
 
-    if (accel_state->vb_index == 0) {
-	R600IBDiscard(pScrn, accel_state->ib);
+    if (accel_state->vb_index == 0)
 	return;
-    }
 
-    accel_state->vb_mc_addr = RHDDRIGetIntGARTLocation(pScrn) +
-	(accel_state->ib->idx * accel_state->ib->total) + (accel_state->ib->total / 2);
-    accel_state->vb_size = accel_state->vb_index * 16;
+    accel_state->vb_mc_addr = R600VBAddress(pScrn);
+    accel_state->vb_size = accel_state->vb_index * vtx_size;
 
     /* flush vertex cache */
     if ((rhdPtr->ChipSet == RHD_RV610) ||
@@ -570,7 +703,7 @@ R600DoCopy(ScrnInfoPtr pScrn)
 
     /* Vertex buffer setup */
     vtx_res.id              = SQ_VTX_RESOURCE_vs;
-    vtx_res.vtx_size_dw     = 16 / 4;
+    vtx_res.vtx_size_dw     = vtx_size / 4;
     vtx_res.vtx_num_entries = accel_state->vb_size / 4;
     vtx_res.mem_req_size    = 1;
     vtx_res.vb_addr         = accel_state->vb_mc_addr;
@@ -590,7 +723,7 @@ R600DoCopy(ScrnInfoPtr pScrn)
     cp_set_surface_sync(pScrn, accel_state->ib, (CB_ACTION_ENA_bit | CB0_DEST_BASE_ENA_bit),
 			accel_state->dst_size, accel_state->dst_mc_addr);
 
-    R600CPFlushIndirect(pScrn, accel_state->ib);
+    R600IBFinish(pScrn);
 }
 
 static void
@@ -601,32 +734,49 @@ R600AppendCopyVertex(ScrnInfoPtr pScrn,
 {
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
-    float *vb;
+    int vtx_size = accel_state->vtx_packed ? 8 : 16;
 
-    if (((accel_state->vb_index + 3) * 16) > (accel_state->ib->total / 2)) {
+    if (!R600VBFits(pScrn, vtx_size, 3)) {
 	R600DoCopy(pScrn);
-	accel_state->vb_index = 0;
-	accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+	if (!R600VBNext(pScrn))
+	    return;
     }
 
-    vb = (pointer)((char*)accel_state->ib->address +
-		   (accel_state->ib->total / 2) +
-		   accel_state->vb_index * 16);
+    if (accel_state->vtx_packed) {
+	uint16_t *vb = R600VBPointer(pScrn, vtx_size);
+
+	vb[0] = dstX;
+	vb[1] = dstY;
+	vb[2] = srcX;
+	vb[3] = srcY;
+
+	vb[4] = dstX;
+	vb[5] = dstY + h;
+	vb[6] = srcX;
+	vb[7] = srcY + h;
 
-    vb[0] = (float)dstX;
-    vb[1] = (float)dstY;
-    vb[2] = (float)srcX;
-    vb[3] = (float)srcY;
+	vb[8] = dstX + w;
+	vb[9] = dstY + h;
+	vb[10] = srcX + w;
+	vb[11] = srcY + h;
+    } else {
+	float *vb = R600VBPointer(pScrn, vtx_size);
+
+	vb[0] = (float)dstX;
+	vb[1] = (float)dstY;
+	vb[2] = (float)srcX;
+	vb[3] = (float)srcY;
 
-    vb[4] = (float)dstX;
-    vb[5] = (float)(dstY + h);
-    vb[6] = (float)srcX;
-    vb[7] = (float)(srcY + h);
+	vb[4] = (float)dstX;
+	vb[5] = (float)(dstY + h);
+	vb[6] = (float)srcX;
+	vb[7] = (float)(srcY + h);
 
-    vb[8] = (float)(dstX + w);
-    vb[9] = (float)(dstY + h);
-    vb[10] = (float)(srcX + w);
-    vb[11] = (float)(srcY + h);
+	vb[8] = (float)(dstX + w);
+	vb[9] = (float)(dstY + h);
+	vb[10] = (float)(srcX + w);
+	vb[11] = (float)(srcY + h);
+    }
 
     accel_state->vb_index += 3;
 }
@@ -682,31 +832,27 @@ R600PrepareCopy(PixmapPtr pSrc,   PixmapPtr pDst,
     accel_state->rop = rop;
     accel_state->planemask = planemask;
 
-    if (exaGetPixmapOffset(pSrc) == exaGetPixmapOffset(pDst)) {
-	unsigned long size = pDst->drawable.height * accel_state->dst_pitch * pDst->drawable.bitsPerPixel/8;
-	accel_state->same_surface = TRUE;
-
-	if (accel_state->copy_area) {
-	    exaOffscreenFree(pDst->drawable.pScreen, accel_state->copy_area);
-	    accel_state->copy_area = NULL;
-	}
-	accel_state->copy_area = exaOffscreenAlloc(pDst->drawable.pScreen, size, 256, TRUE, NULL, NULL);
-    } else {
-
-	accel_state->same_surface = FALSE;
-
-	R600DoPrepareCopy(pScrn,
-			  accel_state->src_pitch[0], pSrc->drawable.width, pSrc->drawable.height,
-			  accel_state->src_mc_addr[0], pSrc->drawable.bitsPerPixel,
-			  accel_state->dst_pitch, pDst->drawable.height,
-			  accel_state->dst_mc_addr, pDst->drawable.bitsPerPixel,
-			  rop, planemask);
+    accel_state->same_surface = (exaGetPixmapOffset(pSrc) == exaGetPixmapOffset(pDst));
+    accel_state->copy_dirty = FALSE;
+
+    if (!R600DoPrepareCopy(pScrn,
+			   accel_state->src_pitch[0], pSrc->drawable.width, pSrc->drawable.height,
+			   accel_state->src_mc_addr[0], pSrc->drawable.bitsPerPixel,
+			   R600PixmapArrayMode(pSrc),
+			   accel_state->dst_pitch, pDst->drawable.height,
+			   accel_state->dst_mc_addr, pDst->drawable.bitsPerPixel,
+			   R600PixmapArrayMode(pDst),
+			   rop, planemask))
+	return FALSE;
 
-    }
+    RHDProfBegin(pScrn, RHD_PROF_COPY, rop, pDst->drawable.bitsPerPixel);
 
     return TRUE;
 }
 
+/* Above this, an overlapping copy is rather bounced through offscreen memory */
+#define R600_OVERLAP_STRIPS_MAX 8
+
 static Bool
 is_overlap(int sx1, int sx2, int sy1, int sy2, int dx1, int dx2, int dy1, int dy2)
 {
@@ -719,6 +865,105 @@ is_overlap(int sx1, int sx2, int sy1, int sy2, int dx1, int dx2, int dy1, int dy
 	return FALSE;
 }
 
+/*
+ * How many strips R600OverlapCopy() cuts an overlapping copy into.
+ */
+static int
+R600OverlapStrips(int srcX, int srcY, int dstX, int dstY, int w, int h)
+{
+    int hchunk = (srcX < dstX) ? (dstX - srcX) : (srcX - dstX);
+    int vchunk = (srcY < dstY) ? (dstY - srcY) : (srcY - dstY);
+
+    if (vchunk != 0 && hchunk != 0) { /* diagonal */
+	if ((w / hchunk) <= (h / vchunk))
+	    return 1 + (w + hchunk - 1) / hchunk;
+	else
+	    return 1 + (h + vchunk - 1) / vchunk;
+    } else if (vchunk == 0)
+	return (w + hchunk - 1) / hchunk;
+    else
+	return (h + vchunk - 1) / vchunk;
+}
+
+/*
+ * Draw what was appended so far, and make sure that it has landed before
+ * the next rects read from where these wrote to. When there is no IB to
+ * continue in, the rects to come are dropped, and FALSE is returned.
+ */
+static Bool
+R600OverlapStrip(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    R600DoCopy(pScrn);
+
+    /* flush texture cache, unless a failed R600VBNext() left no IB */
+    if (accel_state->ib)
+	cp_set_surface_sync(pScrn, accel_state->ib, TC_ACTION_ENA_bit,
+			    accel_state->src_size[0], accel_state->src_mc_addr[0]);
+
+    accel_state->copy_dirty = FALSE;
+
+    if (!R600IBReserveDraw(pScrn)) {
+	accel_state->ib_failed = TRUE;
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Within one surface, the rects of a copy share a draw until one of them
+ * reads from where the ones before it write to, or writes to where they
+ * read from. EXA hands us the rects in an order that is safe when each
+ * lands before the next.
+ */
+static void
+R600CopyRect(ScrnInfoPtr pScrn,
+	     int srcX, int srcY,
+	     int dstX, int dstY,
+	     int w, int h)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (accel_state->same_surface) {
+	if (accel_state->copy_dirty &&
+	    (((srcX < accel_state->copy_x2) && ((srcX + w) > accel_state->copy_x1) &&
+	      (srcY < accel_state->copy_y2) && ((srcY + h) > accel_state->copy_y1)) ||
+	     ((dstX < accel_state->copy_sx2) && ((dstX + w) > accel_state->copy_sx1) &&
+	      (dstY < accel_state->copy_sy2) && ((dstY + h) > accel_state->copy_sy1))) &&
+	    !R600OverlapStrip(pScrn))
+	    return;
+
+	if (!accel_state->copy_dirty) {
+	    accel_state->copy_x1 = dstX;
+	    accel_state->copy_y1 = dstY;
+	    accel_state->copy_x2 = dstX + w;
+	    accel_state->copy_y2 = dstY + h;
+	    accel_state->copy_sx1 = srcX;
+	    accel_state->copy_sy1 = srcY;
+	    accel_state->copy_sx2 = srcX + w;
+	    accel_state->copy_sy2 = srcY + h;
+	    accel_state->copy_dirty = TRUE;
+	} else {
+	    accel_state->copy_x1 = min(accel_state->copy_x1, dstX);
+	    accel_state->copy_y1 = min(accel_state->copy_y1, dstY);
+	    accel_state->copy_x2 = max(accel_state->copy_x2, dstX + w);
+	    accel_state->copy_y2 = max(accel_state->copy_y2, dstY + h);
+	    accel_state->copy_sx1 = min(accel_state->copy_sx1, srcX);
+	    accel_state->copy_sy1 = min(accel_state->copy_sy1, srcY);
+	    accel_state->copy_sx2 = max(accel_state->copy_sx2, srcX + w);
+	    accel_state->copy_sy2 = max(accel_state->copy_sy2, srcY + h);
+	}
+    }
+
+    R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, w, h);
+}
+
+/*
+ * The state is already set up for the surface, all strips go into the same
+ * IB, each with its own draw and a wait for idle in between.
+ */
 static void
 R600OverlapCopy(PixmapPtr pDst,
 		int srcX, int srcY,
@@ -726,10 +971,6 @@ R600OverlapCopy(PixmapPtr pDst,
 		int w, int h)
 {
     ScrnInfoPtr pScrn = xf86Screens[pDst->drawable.pScreen->myNum];
-    RHDPtr rhdPtr = RHDPTR(pScrn);
-    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
-    uint32_t dst_pitch = exaGetPixmapPitch(pDst) / (pDst->drawable.bitsPerPixel / 8);
-    uint32_t dst_offset = exaGetPixmapOffset(pDst) + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
     int i, hchunk, vchunk;
 
     if (is_overlap(srcX, srcX + w, srcY, srcY + h,
@@ -745,43 +986,31 @@ R600OverlapCopy(PixmapPtr pDst,
         if (vchunk != 0 && hchunk != 0) { /* diagonal */
             if ((w / hchunk) <= (h / vchunk)) { /* reduce to horizontal */
                 if (srcY > dstY ) { /* diagonal up */
-                    R600DoPrepareCopy(pScrn,
-                                      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      accel_state->rop, accel_state->planemask);
                     R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, w, vchunk);
-                    R600DoCopy(pScrn);
+                    if (!R600OverlapStrip(pScrn))
+                        return;
 
                     srcY = srcY + vchunk;
                     dstY = dstY + vchunk;
                 } else { /* diagonal down */
-                    R600DoPrepareCopy(pScrn,
-                                      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      accel_state->rop, accel_state->planemask);
                     R600AppendCopyVertex(pScrn, srcX, srcY + h - vchunk, dstX, dstY + h - vchunk, w, vchunk);
-                    R600DoCopy(pScrn);
+                    if (!R600OverlapStrip(pScrn))
+                        return;
                 }
                 h = h - vchunk;
                 vchunk = 0;
             } else { /* reduce to vertical */
                 if (srcX > dstX ) { /* diagonal left */
-                    R600DoPrepareCopy(pScrn,
-                                      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      accel_state->rop, accel_state->planemask);
                     R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, hchunk, h);
-                    R600DoCopy(pScrn);
+                    if (!R600OverlapStrip(pScrn))
+                        return;
 
                     srcX = srcX + hchunk;
                     dstX = dstX + hchunk;
                 } else { /* diagonal right */
-                    R600DoPrepareCopy(pScrn,
-                                      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      accel_state->rop, accel_state->planemask);
                     R600AppendCopyVertex(pScrn, srcX + w - hchunk, srcY, dstX + w - hchunk, dstY, hchunk, h);
-                    R600DoCopy(pScrn);
+                    if (!R600OverlapStrip(pScrn))
+                        return;
                 }
                 w = w - hchunk;
                 hchunk = 0;
@@ -792,61 +1021,63 @@ R600OverlapCopy(PixmapPtr pDst,
 	    if (srcX < dstX) { /* right */
 		/* copy right to left */
 		for (i = w; i > 0; i -= hchunk) {
-		    R600DoPrepareCopy(pScrn,
-				      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-				      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-				      accel_state->rop, accel_state->planemask);
+		    if (hchunk > i) hchunk = i;
 		    R600AppendCopyVertex(pScrn, srcX + i - hchunk, srcY, dstX + i - hchunk, dstY, hchunk, h);
-		    R600DoCopy(pScrn);
+		    if (!R600OverlapStrip(pScrn))
+			return;
 		}
 	    } else { /* left */
 		/* copy left to right */
 		for (i = 0; i < w; i += hchunk) {
-		    R600DoPrepareCopy(pScrn,
-				      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-				      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-				      accel_state->rop, accel_state->planemask);
-
+		    if (hchunk > w - i) hchunk = w - i;
 		    R600AppendCopyVertex(pScrn, srcX + i, srcY, dstX + i, dstY, hchunk, h);
-		    R600DoCopy(pScrn);
+		    if (!R600OverlapStrip(pScrn))
+			return;
 		}
 	    }
 	} else { /* up/down */
 	    if (srcY > dstY) { /* up */
 		/* copy top to bottom */
                 for (i = 0; i < h; i += vchunk) {
-                    R600DoPrepareCopy(pScrn,
-                                      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      accel_state->rop, accel_state->planemask);
-
                     if (vchunk > h - i) vchunk = h - i;
                     R600AppendCopyVertex(pScrn, srcX, srcY + i, dstX, dstY + i, w, vchunk);
-                    R600DoCopy(pScrn);
+                    if (!R600OverlapStrip(pScrn))
+                        return;
                 }
 	    } else { /* down */
 		/* copy bottom to top */
                 for (i = h; i > 0; i -= vchunk) {
-                    R600DoPrepareCopy(pScrn,
-                                      dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-                                      accel_state->rop, accel_state->planemask);
-
                     if (vchunk > i) vchunk = i;
                     R600AppendCopyVertex(pScrn, srcX, srcY + i - vchunk, dstX, dstY + i - vchunk, w, vchunk);
-                    R600DoCopy(pScrn);
+                    if (!R600OverlapStrip(pScrn))
+                        return;
                 }
             }
 	}
-    } else {
-	R600DoPrepareCopy(pScrn,
-			  dst_pitch, pDst->drawable.width, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-			  dst_pitch, pDst->drawable.height, dst_offset, pDst->drawable.bitsPerPixel,
-			  accel_state->rop, accel_state->planemask);
+    } else
+	R600CopyRect(pScrn, srcX, srcY, dstX, dstY, w, h);
+}
 
-	R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, w, h);
-	R600DoCopy(pScrn);
+/*
+ * Overlapping copies that would take too many strips get bounced through an
+ * offscreen area instead. This area is kept around and only ever grows.
+ */
+static Bool
+R600CopyBounce(ScreenPtr pScreen, unsigned long size)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(xf86Screens[pScreen->myNum])->TwoDPrivate;
+
+    if (accel_state->copy_area && (accel_state->copy_area->size >= size))
+	return TRUE;
+
+    if (accel_state->copy_area) {
+	exaOffscreenFree(pScreen, accel_state->copy_area);
+	accel_state->copy_area = NULL;
     }
+
+    accel_state->copy_area = exaOffscreenAlloc(pScreen, size, 256, TRUE, NULL, NULL);
+
+    return accel_state->copy_area != NULL;
 }
 
 static void
@@ -863,40 +1094,56 @@ R600Copy(PixmapPtr pDst,
 	return;
 
     if (accel_state->same_surface && is_overlap(srcX, srcX + w, srcY, srcY + h, dstX, dstX + w, dstY, dstY + h)) {
-	if (accel_state->copy_area) {
-	    uint32_t pitch = exaGetPixmapPitch(pDst) / (pDst->drawable.bitsPerPixel / 8);
+	uint32_t pitch = exaGetPixmapPitch(pDst) / (pDst->drawable.bitsPerPixel / 8);
+	int array_mode = R600PixmapArrayMode(pDst);
+
+	/* whatever was batched up has to land first */
+	if (accel_state->copy_dirty && !R600OverlapStrip(pScrn))
+	    return;
+
+	if ((R600OverlapStrips(srcX, srcY, dstX, dstY, w, h) > R600_OVERLAP_STRIPS_MAX) &&
+	    R600CopyBounce(pDst->drawable.pScreen, pitch * h * (pDst->drawable.bitsPerPixel / 8))) {
 	    uint32_t orig_offset, tmp_offset;
 
 	    tmp_offset = accel_state->copy_area->offset + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
 	    orig_offset = exaGetPixmapOffset(pDst) + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
 
-	    R600DoPrepareCopy(pScrn,
-			      pitch, pDst->drawable.width, pDst->drawable.height, orig_offset, pDst->drawable.bitsPerPixel,
-			      pitch,                       pDst->drawable.height, tmp_offset, pDst->drawable.bitsPerPixel,
-			      accel_state->rop, accel_state->planemask);
-	    R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, w, h);
+	    /*
+	     * straight copy to the top of the bounce area, the rop goes on the way back.
+	     * The bounce area is always linear, h need not be a multiple of the tile height.
+	     * Without buffers, the rect is dropped; as are the rects to come, when the
+	     * surface state cannot be restored.
+	     */
+	    if (!R600DoPrepareCopy(pScrn,
+				   pitch, pDst->drawable.width, pDst->drawable.height, orig_offset, pDst->drawable.bitsPerPixel,
+				   array_mode,
+				   pitch,                       h,                     tmp_offset, pDst->drawable.bitsPerPixel,
+				   ARRAY_LINEAR_GENERAL,
+				   3, 0xffffffff))
+		return;
+	    R600AppendCopyVertex(pScrn, srcX, srcY, 0, 0, w, h);
 	    R600DoCopy(pScrn);
+	    if (R600DoPrepareCopy(pScrn,
+				  pitch, w,                    h,                     tmp_offset, pDst->drawable.bitsPerPixel,
+				  ARRAY_LINEAR_GENERAL,
+				  pitch,                       pDst->drawable.height, orig_offset, pDst->drawable.bitsPerPixel,
+				  array_mode,
+				  accel_state->rop, accel_state->planemask)) {
+		R600AppendCopyVertex(pScrn, 0, 0, dstX, dstY, w, h);
+		R600DoCopy(pScrn);
+	    }
+
+	    /* back to the surface state for the rects to come */
 	    R600DoPrepareCopy(pScrn,
-			      pitch, pDst->drawable.width, pDst->drawable.height, tmp_offset, pDst->drawable.bitsPerPixel,
+			      pitch, pDst->drawable.width, pDst->drawable.height, orig_offset, pDst->drawable.bitsPerPixel,
+			      array_mode,
 			      pitch,                       pDst->drawable.height, orig_offset, pDst->drawable.bitsPerPixel,
+			      array_mode,
 			      accel_state->rop, accel_state->planemask);
-	    R600AppendCopyVertex(pScrn, dstX, dstY, dstX, dstY, w, h);
-	    R600DoCopy(pScrn);
 	} else
 	    R600OverlapCopy(pDst, srcX, srcY, dstX, dstY, w, h);
-    } else if (accel_state->same_surface) {
-	uint32_t pitch = exaGetPixmapPitch(pDst) / (pDst->drawable.bitsPerPixel / 8);
-	uint32_t offset = exaGetPixmapOffset(pDst) + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
-
-	R600DoPrepareCopy(pScrn,
-			  pitch, pDst->drawable.width, pDst->drawable.height, offset, pDst->drawable.bitsPerPixel,
-			  pitch,                       pDst->drawable.height, offset, pDst->drawable.bitsPerPixel,
-			  accel_state->rop, accel_state->planemask);
-	R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, w, h);
-	R600DoCopy(pScrn);
-    } else {
-	R600AppendCopyVertex(pScrn, srcX, srcY, dstX, dstY, w, h);
-    }
+    } else
+	R600CopyRect(pScrn, srcX, srcY, dstX, dstY, w, h);
 
 }
 
@@ -907,13 +1154,9 @@ R600DoneCopy(PixmapPtr pDst)
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
 
-    if (!accel_state->same_surface)
-	R600DoCopy(pScrn);
+    R600DoCopy(pScrn);
 
-    if (accel_state->copy_area) {
-	exaOffscreenFree(pDst->drawable.pScreen, accel_state->copy_area);
-	accel_state->copy_area = NULL;
-    }
+    RHDProfEnd(pScrn);
 }
 
 #define RADEON_TRACE_FALL 0
@@ -932,17 +1175,6 @@ do {					\
 
 #define xFixedToFloat(f) (((float) (f)) / 65536)
 
-static inline void transformPoint(PictTransform *transform, xPointFixed *point)
-{
-    PictVector v;
-    v.vector[0] = point->x;
-    v.vector[1] = point->y;
-    v.vector[2] = xFixed1;
-    PictureTransformPoint(transform, &v);
-    point->x = v.vector[0];
-    point->y = v.vector[1];
-}
-
 struct blendinfo {
     Bool dst_alpha;
     Bool src_alpha;
@@ -1057,7 +1289,6 @@ static Bool R600CheckCompositeTexture(PicturePtr pPict,
 {
     int w = pPict->pDrawable->width;
     int h = pPict->pDrawable->height;
-    unsigned int i;
     int max_tex_w, max_tex_h;
 
     max_tex_w = 8192;
@@ -1066,6 +1297,17 @@ static Bool R600CheckCompositeTexture(PicturePtr pPict,
     if ((w > max_tex_w) || (h > max_tex_h))
 	RADEON_FALLBACK(("Picture w/h too large (%dx%d)\n", w, h));
 
+    return TRUE;
+}
+
+/* The parts of the texture checks which only depend on formats and flags. */
+static Bool R600CheckCompositeTextureFormat(PicturePtr pPict,
+					    PicturePtr pDstPict,
+					    int op,
+					    uint32_t *card_fmt)
+{
+    unsigned int i;
+
     for (i = 0; i < sizeof(R600TexFormats) / sizeof(R600TexFormats[0]); i++) {
 	if (R600TexFormats[i].fmt == pPict->format)
 	    break;
@@ -1092,26 +1334,186 @@ static Bool R600CheckCompositeTexture(PicturePtr pPict,
 	    RADEON_FALLBACK(("REPEAT_NONE unsupported for transformed xRGB source\n"));
     }
 
+    *card_fmt = R600TexFormats[i].card_fmt;
+
     return TRUE;
 }
 
-static Bool R600TextureSetup(PicturePtr pPict, PixmapPtr pPix,
-					int unit)
-{
-    ScrnInfoPtr pScrn = xf86Screens[pPix->drawable.pScreen->myNum];
-    RHDPtr rhdPtr = RHDPTR(pScrn);
-    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
-    int w = pPict->pDrawable->width;
-    int h = pPict->pDrawable->height;
-    unsigned int i;
-    tex_resource_t  tex_res;
-    tex_sampler_t   tex_samp;
-    int pix_r, pix_g, pix_b, pix_a;
+/*
+ * Composite state cache.
+ *
+ * Whether an operation is supported, and the blend control, formats and
+ * swizzles for it, only depend on the op, the picture formats and a few
+ * flags. Only a handful of those combinations are in use at any time, so
+ * they are worked out once and then looked up.
+ */
+#define R600_COMP_CACHE_SIZE 32 /* power of two */
+
+#define R600_COMP_MASK           0x01
+#define R600_COMP_MASK_CA        0x02
+#define R600_COMP_SRC_REPEAT     0x04
+#define R600_COMP_SRC_TRANSFORM  0x08
+#define R600_COMP_MASK_REPEAT    0x10
+#define R600_COMP_MASK_TRANSFORM 0x20
+#define R600_COMP_SRC_SOLID      0x40
+#define R600_COMP_MASK_SOLID     0x80
+
+struct R600CompositeKey {
+    int op;
+    unsigned int src_format;
+    unsigned int mask_format;
+    unsigned int dst_format;
+    int src_filter;
+    int mask_filter;
+    unsigned int flags;
+};
 
-    CLEAR (tex_res);
-    CLEAR (tex_samp);
+struct R600CompositeState {
+    struct R600CompositeKey Key;
+    Bool Valid;
 
-    accel_state->src_pitch[unit] = exaGetPixmapPitch(pPix) / (pPix->drawable.bitsPerPixel / 8);
+    Bool Supported;
+    uint32_t blend_cntl;
+    uint32_t dst_format;
+    int comp_swap;
+    uint32_t tex_format[2];
+};
+
+static struct R600CompositeState R600CompositeCache[R600_COMP_CACHE_SIZE];
+
+/*
+ *
+ */
+static Bool R600CompositeStateFill(struct R600CompositeState *State, int op,
+				   PicturePtr pSrcPicture, PicturePtr pMaskPicture,
+				   PicturePtr pDstPicture)
+{
+    /* Check for unsupported compositing operations. */
+    if (op >= (int) (sizeof(R600BlendOp) / sizeof(R600BlendOp[0])))
+	RADEON_FALLBACK(("Unsupported Composite op 0x%x\n", op));
+
+    if (pMaskPicture) {
+	if (pMaskPicture->componentAlpha) {
+	    /* Check if it's component alpha that relies on a source alpha and
+	     * on the source value.  We can only get one of those into the
+	     * single source value that we get to blend with.
+	     */
+	    if (R600BlendOp[op].src_alpha &&
+		(R600BlendOp[op].blend_cntl & COLOR_SRCBLEND_mask) !=
+		(BLEND_ZERO << COLOR_SRCBLEND_shift)) {
+		RADEON_FALLBACK(("Component alpha not supported with source "
+				 "alpha and source value blending.\n"));
+	    }
+	}
+
+	/* solid pictures need no texture */
+	if (pMaskPicture->pDrawable &&
+	    !R600CheckCompositeTextureFormat(pMaskPicture, pDstPicture, op,
+					     &State->tex_format[1]))
+	    return FALSE;
+    }
+
+    if (pSrcPicture->pDrawable &&
+	!R600CheckCompositeTextureFormat(pSrcPicture, pDstPicture, op,
+					 &State->tex_format[0]))
+	return FALSE;
+
+    if (!R600GetDestFormat(pDstPicture, &State->dst_format))
+	return FALSE;
+
+    State->blend_cntl = R600GetBlendCntl(op, pMaskPicture, pDstPicture->format);
+
+    switch (pDstPicture->format) {
+    case PICT_a8r8g8b8:
+    case PICT_x8r8g8b8:
+    case PICT_a1r5g5b5:
+    case PICT_x1r5g5b5:
+    default:
+	State->comp_swap = 1; /* ARGB */
+	break;
+    case PICT_r5g6b5:
+	State->comp_swap = 2; /* RGB */
+	break;
+    case PICT_a8:
+	State->comp_swap = 3; /* A */
+	break;
+    }
+
+    return TRUE;
+}
+
+/*
+ *
+ */
+static struct R600CompositeState *
+R600CompositeStateGet(int op, PicturePtr pSrcPicture, PicturePtr pMaskPicture,
+		      PicturePtr pDstPicture)
+{
+    struct R600CompositeState *State;
+    struct R600CompositeKey Key;
+    unsigned int hash;
+
+    memset(&Key, 0, sizeof(Key));
+    Key.op = op;
+    Key.src_format = pSrcPicture->format;
+    Key.dst_format = pDstPicture->format;
+    Key.src_filter = pSrcPicture->filter;
+    if (pSrcPicture->repeat)
+	Key.flags |= R600_COMP_SRC_REPEAT;
+    if (pSrcPicture->transform)
+	Key.flags |= R600_COMP_SRC_TRANSFORM;
+    if (!pSrcPicture->pDrawable)
+	Key.flags |= R600_COMP_SRC_SOLID;
+
+    if (pMaskPicture) {
+	Key.flags |= R600_COMP_MASK;
+	Key.mask_format = pMaskPicture->format;
+	Key.mask_filter = pMaskPicture->filter;
+	if (pMaskPicture->componentAlpha)
+	    Key.flags |= R600_COMP_MASK_CA;
+	if (pMaskPicture->repeat)
+	    Key.flags |= R600_COMP_MASK_REPEAT;
+	if (pMaskPicture->transform)
+	    Key.flags |= R600_COMP_MASK_TRANSFORM;
+	if (!pMaskPicture->pDrawable)
+	    Key.flags |= R600_COMP_MASK_SOLID;
+    }
+
+    hash = Key.op ^ Key.src_format ^ (Key.mask_format << 1) ^
+	(Key.dst_format << 2) ^ (Key.flags << 3);
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+
+    State = &R600CompositeCache[hash & (R600_COMP_CACHE_SIZE - 1)];
+    if (State->Valid && !memcmp(&State->Key, &Key, sizeof(Key)))
+	return State;
+
+    State->Key = Key;
+    State->Valid = TRUE;
+    State->Supported = R600CompositeStateFill(State, op, pSrcPicture,
+					      pMaskPicture, pDstPicture);
+
+    return State;
+}
+
+static Bool R600TextureSetup(PicturePtr pPict, PixmapPtr pPix,
+			     uint32_t card_fmt, int unit)
+{
+    ScrnInfoPtr pScrn = xf86Screens[pPix->drawable.pScreen->myNum];
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
+    int w = pPict->pDrawable->width;
+    int h = pPict->pDrawable->height;
+    unsigned int i;
+    tex_resource_t  tex_res;
+    tex_sampler_t   tex_samp;
+    int pix_r, pix_g, pix_b, pix_a;
+    float vs_alu_consts[12];
+
+    CLEAR (tex_res);
+    CLEAR (tex_samp);
+
+    accel_state->src_pitch[unit] = exaGetPixmapPitch(pPix) / (pPix->drawable.bitsPerPixel / 8);
     accel_state->src_size[unit] = exaGetPixmapPitch(pPix) * h;
     accel_state->src_mc_addr[unit] = exaGetPixmapOffset(pPix) + rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart;
 
@@ -1121,14 +1523,6 @@ static Bool R600TextureSetup(PicturePtr pPict, PixmapPtr pPix,
     if (accel_state->src_mc_addr[1] & 0xff)
 	RADEON_FALLBACK(("Bad offset %d 0x%x\n", (int)accel_state->src_mc_addr[unit], unit));
 
-    for (i = 0; i < sizeof(R600TexFormats) / sizeof(R600TexFormats[0]); i++) {
-	if (R600TexFormats[i].fmt == pPict->format)
-	    break;
-    }
-
-    accel_state->texW[unit] = w;
-    accel_state->texH[unit] = h;
-
     /* ErrorF("Tex %d setup %dx%d\n", unit, w, h); */
 
     /* flush texture cache */
@@ -1144,7 +1538,8 @@ static Bool R600TextureSetup(PicturePtr pPict, PixmapPtr pPix,
     tex_res.dim                 = SQ_TEX_DIM_2D;
     tex_res.base                = accel_state->src_mc_addr[unit];
     tex_res.mip_base            = accel_state->src_mc_addr[unit];
-    tex_res.format              = R600TexFormats[i].card_fmt;
+    tex_res.tile_mode           = R600PixmapArrayMode(pPix);
+    tex_res.format              = card_fmt;
     tex_res.request_size        = 1;
 
     /* component swizzles */
@@ -1299,41 +1694,127 @@ static Bool R600TextureSetup(PicturePtr pPict, PixmapPtr pPix,
     tex_samp.mip_filter         = 0;			/* no mipmap */
     set_tex_sampler             (pScrn, accel_state->ib, &tex_samp);
 
+    /*
+     * The vertex shader transforms the coordinates, see R600_comp_vs(). It
+     * gets the columns of the transform, with the rows for the texture
+     * coordinates already scaled to the texture size.
+     */
     if (pPict->transform != 0) {
-	accel_state->is_transform[unit] = TRUE;
-	accel_state->transform[unit] = pPict->transform;
-    } else
-	accel_state->is_transform[unit] = FALSE;
+	for (i = 0; i < 3; i++) {
+	    vs_alu_consts[i * 4 + 0] = xFixedToFloat(pPict->transform->matrix[0][i]) / w;
+	    vs_alu_consts[i * 4 + 1] = xFixedToFloat(pPict->transform->matrix[1][i]) / h;
+	    vs_alu_consts[i * 4 + 2] = xFixedToFloat(pPict->transform->matrix[2][i]);
+	    vs_alu_consts[i * 4 + 3] = 0.0;
+	}
+    } else {
+	vs_alu_consts[0] = 1.0 / w;
+	vs_alu_consts[1] = 0.0;
+	vs_alu_consts[2] = 0.0;
+	vs_alu_consts[3] = 0.0;
+
+	vs_alu_consts[4] = 0.0;
+	vs_alu_consts[5] = 1.0 / h;
+	vs_alu_consts[6] = 0.0;
+	vs_alu_consts[7] = 0.0;
+
+	vs_alu_consts[8] = 0.0;
+	vs_alu_consts[9] = 0.0;
+	vs_alu_consts[10] = 1.0;
+	vs_alu_consts[11] = 0.0;
+    }
+    set_alu_consts(pScrn, accel_state->ib, SQ_ALU_CONSTANT_vs + unit * 3,
+		   sizeof(vs_alu_consts) / SQ_ALU_CONSTANT_offset, vs_alu_consts);
 
     return TRUE;
 }
 
+/*
+ * Pictures without a drawable are source only pictures. Solid ones have
+ * their colour go straight into the PS constants, gradients are left to
+ * software.
+ */
+static Bool R600CheckCompositeSolid(PicturePtr pPict)
+{
+    if (pPict->pSourcePict->type != SourcePictTypeSolidFill)
+	RADEON_FALLBACK(("Gradient pictures not supported\n"));
+
+    return TRUE;
+}
+
+/* The colour of a solid picture, with the swizzles R600TextureSetup() applies. */
+static void R600SolidPictureColor(struct r6xx_accel_state *accel_state,
+				  PicturePtr pPict, int unit, float *color)
+{
+    CARD32 pixel = pPict->pSourcePict->solidFill.color;
+
+    color[0] = (float)((pixel >> 16) & 0xff) / 255; /* R */
+    color[1] = (float)((pixel >> 8) & 0xff) / 255; /* G */
+    color[2] = (float)(pixel & 0xff) / 255; /* B */
+    color[3] = (float)((pixel >> 24) & 0xff) / 255; /* A */
+
+    if (unit == 0) {
+	if (!accel_state->component_alpha || !accel_state->src_alpha)
+	    return;
+    } else {
+	if (accel_state->component_alpha)
+	    return;
+    }
+
+    color[0] = color[3];
+    color[1] = color[3];
+    color[2] = color[3];
+}
+
+/*
+ * The vertex shader still transforms the coordinates of a solid source, see
+ * R600_comp_vs(). Nothing looks at them, but keep them sane.
+ */
+static void R600SolidTransform(ScrnInfoPtr pScrn, int unit)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    float vs_alu_consts[12] = { 1.0, 0.0, 0.0, 0.0,
+				0.0, 1.0, 0.0, 0.0,
+				0.0, 0.0, 1.0, 0.0 };
+
+    set_alu_consts(pScrn, accel_state->ib, SQ_ALU_CONSTANT_vs + unit * 3,
+		   sizeof(vs_alu_consts) / SQ_ALU_CONSTANT_offset, vs_alu_consts);
+}
+
 static Bool R600CheckComposite(int op, PicturePtr pSrcPicture, PicturePtr pMaskPicture,
 			       PicturePtr pDstPicture)
 {
-    uint32_t tmp1;
 /*    ScreenPtr pScreen = pDstPicture->pDrawable->pScreen; */
     PixmapPtr pSrcPixmap, pDstPixmap;
 /*    ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum]; */
 /*    RHDPtr rhdPtr = RHDPTR(pScrn); */
     int max_tex_w, max_tex_h, max_dst_w, max_dst_h;
 
-    /* Check for unsupported compositing operations. */
-    if (op >= (int) (sizeof(R600BlendOp) / sizeof(R600BlendOp[0])))
-	RADEON_FALLBACK(("Unsupported Composite op 0x%x\n", op));
+    if (!pSrcPicture->pDrawable && !R600CheckCompositeSolid(pSrcPicture))
+	return FALSE;
+    if (pMaskPicture && !pMaskPicture->pDrawable && !R600CheckCompositeSolid(pMaskPicture))
+	return FALSE;
 
-    pSrcPixmap = RADEONGetDrawablePixmap(pSrcPicture->pDrawable);
+    /* unsupported ops, formats, filters... */
+    if (!R600CompositeStateGet(op, pSrcPicture, pMaskPicture, pDstPicture)->Supported)
+	return FALSE;
 
     max_tex_w = 8192;
     max_tex_h = 8192;
     max_dst_w = 8192;
     max_dst_h = 8192;
 
-    if (pSrcPixmap->drawable.width >= max_tex_w ||
-	pSrcPixmap->drawable.height >= max_tex_h) {
-	RADEON_FALLBACK(("Source w/h too large (%d,%d).\n",
-			 pSrcPixmap->drawable.width,
-			 pSrcPixmap->drawable.height));
+    if (pSrcPicture->pDrawable) {
+	pSrcPixmap = RADEONGetDrawablePixmap(pSrcPicture->pDrawable);
+
+	if (pSrcPixmap->drawable.width >= max_tex_w ||
+	    pSrcPixmap->drawable.height >= max_tex_h) {
+	    RADEON_FALLBACK(("Source w/h too large (%d,%d).\n",
+			     pSrcPixmap->drawable.width,
+			     pSrcPixmap->drawable.height));
+	}
+
+	if (!R600CheckCompositeTexture(pSrcPicture, pDstPicture, op, 0))
+	    return FALSE;
     }
 
     pDstPixmap = RADEONGetDrawablePixmap(pDstPicture->pDrawable);
@@ -1345,7 +1826,7 @@ static Bool R600CheckComposite(int op, PicturePtr pSrcPicture, PicturePtr pMaskP
 			 pDstPixmap->drawable.height));
     }
 
-    if (pMaskPicture) {
+    if (pMaskPicture && pMaskPicture->pDrawable) {
 	PixmapPtr pMaskPixmap = RADEONGetDrawablePixmap(pMaskPicture->pDrawable);
 
 	if (pMaskPixmap->drawable.width >= max_tex_w ||
@@ -1355,29 +1836,10 @@ static Bool R600CheckComposite(int op, PicturePtr pSrcPicture, PicturePtr pMaskP
 			     pMaskPixmap->drawable.height));
 	}
 
-	if (pMaskPicture->componentAlpha) {
-	    /* Check if it's component alpha that relies on a source alpha and
-	     * on the source value.  We can only get one of those into the
-	     * single source value that we get to blend with.
-	     */
-	    if (R600BlendOp[op].src_alpha &&
-		(R600BlendOp[op].blend_cntl & COLOR_SRCBLEND_mask) !=
-		(BLEND_ZERO << COLOR_SRCBLEND_shift)) {
-		RADEON_FALLBACK(("Component alpha not supported with source "
-				 "alpha and source value blending.\n"));
-	    }
-	}
-
 	if (!R600CheckCompositeTexture(pMaskPicture, pDstPicture, op, 1))
 	    return FALSE;
     }
 
-    if (!R600CheckCompositeTexture(pSrcPicture, pDstPicture, op, 0))
-	return FALSE;
-
-    if (!R600GetDestFormat(pDstPicture, &tmp1))
-	return FALSE;
-
     return TRUE;
 
 }
@@ -1386,12 +1848,15 @@ static Bool R600PrepareComposite(int op, PicturePtr pSrcPicture,
 				 PicturePtr pMaskPicture, PicturePtr pDstPicture,
 				 PixmapPtr pSrc, PixmapPtr pMask, PixmapPtr pDst)
 {
-    ScrnInfoPtr pScrn = xf86Screens[pSrc->drawable.pScreen->myNum];
+    ScrnInfoPtr pScrn = xf86Screens[pDst->drawable.pScreen->myNum];
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
-    uint32_t blendcntl, dst_format;
+    struct R600CompositeState *State;
     cb_config_t cb_conf;
     shader_config_t vs_conf, ps_conf;
+    float ps_alu_consts[4], mask_color[4];
+    uint32_t ps_offset;
+    Bool mask_coords;
 
     /* RV740 seems to be particularly problematic */
     /* if ((rhdPtr->ChipSet == RHD_RV740) && (w < 32 || h < 32)) */
@@ -1400,7 +1865,14 @@ static Bool R600PrepareComposite(int op, PicturePtr pSrcPicture,
 
     /* return FALSE; */
 
-    if (pMask) {
+    State = R600CompositeStateGet(op, pSrcPicture, pMaskPicture, pDstPicture);
+    if (!State->Supported)
+	return FALSE;
+
+    accel_state->src_solid = !pSrcPicture->pDrawable;
+    accel_state->mask_solid = pMaskPicture && !pMaskPicture->pDrawable;
+
+    if (pMaskPicture) {
 	accel_state->has_mask = TRUE;
 	if (pMaskPicture->componentAlpha) {
 	    accel_state->component_alpha = TRUE;
@@ -1428,14 +1900,12 @@ static Bool R600PrepareComposite(int op, PicturePtr pSrcPicture,
     if (accel_state->dst_mc_addr & 0xff)
 	RADEON_FALLBACK(("Bad destination offset 0x%x\n", (int)accel_state->dst_mc_addr));
 
-    if (!R600GetDestFormat(pDstPicture, &dst_format))
-	return FALSE;
-
     CLEAR (cb_conf);
     CLEAR (vs_conf);
     CLEAR (ps_conf);
 
-    accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+    if (!R600IBStart(pScrn))
+	return FALSE;
 
     /* Init */
     start_3d(pScrn, accel_state->ib);
@@ -1445,31 +1915,59 @@ static Bool R600PrepareComposite(int op, PicturePtr pSrcPicture,
     set_default_state(pScrn, accel_state->ib);
 
     /* Scissor / viewport */
-    EREG  (accel_state->ib, PA_CL_VTE_CNTL,                      VTX_XY_FMT_bit);
-    EREG  (accel_state->ib, PA_CL_CLIP_CNTL,                     CLIP_DISABLE_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_VTE_CNTL,      VTX_XY_FMT_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_CLIP_CNTL,     CLIP_DISABLE_bit);
 
-    if (!R600TextureSetup(pSrcPicture, pSrc, 0)) {
-	R600IBDiscard(pScrn, accel_state->ib);
+    /* whatever got set up so far is harmless, it just stays in the IB */
+    if (accel_state->src_solid)
+	R600SolidTransform(pScrn, 0);
+    else if (!R600TextureSetup(pSrcPicture, pSrc, State->tex_format[0], 0))
 	return FALSE;
-    }
 
-    if (pMask != NULL) {
-	if (!R600TextureSetup(pMaskPicture, pMask, 1)) {
-	    R600IBDiscard(pScrn, accel_state->ib);
+    if (pMaskPicture && !accel_state->mask_solid) {
+	if (!R600TextureSetup(pMaskPicture, pMask, State->tex_format[1], 1))
 	    return FALSE;
+    }
+
+    /*
+     * A solid src or mask is a PS constant, so only a textured mask needs
+     * its coordinates passed along.
+     */
+    mask_coords = accel_state->has_mask && !accel_state->mask_solid;
+
+    if (accel_state->src_solid) {
+	R600SolidPictureColor(accel_state, pSrcPicture, 0, ps_alu_consts);
+
+	if (accel_state->mask_solid) {
+	    R600SolidPictureColor(accel_state, pMaskPicture, 1, mask_color);
+	    ps_alu_consts[0] *= mask_color[0];
+	    ps_alu_consts[1] *= mask_color[1];
+	    ps_alu_consts[2] *= mask_color[2];
+	    ps_alu_consts[3] *= mask_color[3];
 	}
-    } else
-	accel_state->is_transform[1] = FALSE;
 
-    if (pMask) {
+	if (mask_coords)
+	    ps_offset = accel_state->comp_solid_src_ps_offset;
+	else
+	    ps_offset = accel_state->solid_ps_offset;
+    } else if (accel_state->mask_solid) {
+	R600SolidPictureColor(accel_state, pMaskPicture, 1, ps_alu_consts);
+	ps_offset = accel_state->comp_solid_mask_ps_offset;
+    } else if (mask_coords)
+	ps_offset = accel_state->comp_mask_ps_offset;
+    else
+	ps_offset = accel_state->comp_ps_offset;
+
+    if (accel_state->src_solid || accel_state->mask_solid)
+	set_alu_consts(pScrn, accel_state->ib, 0, sizeof(ps_alu_consts) / SQ_ALU_CONSTANT_offset, ps_alu_consts);
+
+    if (mask_coords)
 	set_bool_consts(pScrn, accel_state->ib, SQ_BOOL_CONST_vs, (1 << 0));
-	accel_state->ps_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
-	    accel_state->comp_mask_ps_offset;
-    } else {
+    else
 	set_bool_consts(pScrn, accel_state->ib, SQ_BOOL_CONST_vs, (0 << 0));
-	accel_state->ps_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
-	    accel_state->comp_ps_offset;
-    }
+
+    accel_state->ps_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
+	ps_offset;
 
     accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
 	accel_state->comp_vs_offset;
@@ -1484,7 +1982,7 @@ static Bool R600PrepareComposite(int op, PicturePtr pSrcPicture,
 			accel_state->vs_size, accel_state->vs_mc_addr);
 
     vs_conf.shader_addr         = accel_state->vs_mc_addr;
-    vs_conf.num_gprs            = 3;
+    vs_conf.num_gprs            = 4;
     vs_conf.stack_size          = 1;
     vs_setup                    (pScrn, accel_state->ib, &vs_conf);
 
@@ -1500,83 +1998,69 @@ static Bool R600PrepareComposite(int op, PicturePtr pSrcPicture,
     ps_conf.export_mode         = 2;
     ps_setup                    (pScrn, accel_state->ib, &ps_conf);
 
-    EREG  (accel_state->ib, CB_SHADER_MASK,                      (0xf << OUTPUT0_ENABLE_shift));
-    EREG  (accel_state->ib, R7xx_CB_SHADER_CONTROL,              (RT0_ENABLE_bit));
-
-    blendcntl = R600GetBlendCntl(op, pMaskPicture, pDstPicture->format);
+    set_context_reg(pScrn, accel_state->ib, CB_SHADER_MASK,      (0xf << OUTPUT0_ENABLE_shift));
+    set_context_reg(pScrn, accel_state->ib, R7xx_CB_SHADER_CONTROL, (RT0_ENABLE_bit));
 
     if (rhdPtr->ChipSet == RHD_R600) {
 	/* no per-MRT blend on R600 */
-	EREG  (accel_state->ib, CB_COLOR_CONTROL,                    RADEON_ROP[3] | (1 << TARGET_BLEND_ENABLE_shift));
-	EREG  (accel_state->ib, CB_BLEND_CONTROL,                    blendcntl);
+	set_context_reg(pScrn, accel_state->ib, CB_COLOR_CONTROL,    RADEON_ROP[3] | (1 << TARGET_BLEND_ENABLE_shift));
+	set_context_reg(pScrn, accel_state->ib, CB_BLEND_CONTROL,    State->blend_cntl);
     } else {
-	EREG  (accel_state->ib, CB_COLOR_CONTROL,                    (RADEON_ROP[3] |
+	set_context_reg(pScrn, accel_state->ib, CB_COLOR_CONTROL,    (RADEON_ROP[3] |
 								      (1 << TARGET_BLEND_ENABLE_shift) |
 								      PER_MRT_BLEND_bit));
-	EREG  (accel_state->ib, CB_BLEND0_CONTROL,                   blendcntl);
+	set_context_reg(pScrn, accel_state->ib, CB_BLEND0_CONTROL,   State->blend_cntl);
     }
 
     cb_conf.id = 0;
     cb_conf.w = accel_state->dst_pitch;
     cb_conf.h = pDst->drawable.height;
     cb_conf.base = accel_state->dst_mc_addr;
-    cb_conf.format = dst_format;
-
-    switch (pDstPicture->format) {
-    case PICT_a8r8g8b8:
-    case PICT_x8r8g8b8:
-    case PICT_a1r5g5b5:
-    case PICT_x1r5g5b5:
-    default:
-	cb_conf.comp_swap = 1; /* ARGB */
-	break;
-    case PICT_r5g6b5:
-	cb_conf.comp_swap = 2; /* RGB */
-	break;
-    case PICT_a8:
-	cb_conf.comp_swap = 3; /* A */
-	break;
-    }
+    cb_conf.array_mode = R600PixmapArrayMode(pDst);
+    cb_conf.format = State->dst_format;
+    cb_conf.comp_swap = State->comp_swap;
     cb_conf.source_format = 1;
     cb_conf.blend_clamp = 1;
     set_render_target(pScrn, accel_state->ib, &cb_conf);
 
-    EREG(accel_state->ib, PA_SU_SC_MODE_CNTL,                  (FACE_bit			|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
-    EREG(accel_state->ib, DB_SHADER_CONTROL,                   ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
+    set_context_reg(pScrn, accel_state->ib, PA_SU_SC_MODE_CNTL, (FACE_bit			|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
+    set_context_reg(pScrn, accel_state->ib, DB_SHADER_CONTROL, ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
 								DUAL_EXPORT_ENABLE_bit)); /* Only useful if no depth export */
 
     /* Interpolator setup */
-    if (pMask) {
+    if (mask_coords) {
 	/* export 2 tex coords from VS */
-	EREG(accel_state->ib, SPI_VS_OUT_CONFIG, ((2 - 1) << VS_EXPORT_COUNT_shift));
+	set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_CONFIG, ((2 - 1) << VS_EXPORT_COUNT_shift));
 	/* src = semantic id 0; mask = semantic id 1 */
-	EREG(accel_state->ib, SPI_VS_OUT_ID_0, ((0 << SEMANTIC_0_shift) |
-						(1 << SEMANTIC_1_shift)));
+	set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_ID_0, ((0 << SEMANTIC_0_shift) |
+								  (1 << SEMANTIC_1_shift)));
 	/* input 2 tex coords from VS */
-	EREG(accel_state->ib, SPI_PS_IN_CONTROL_0, (2 << NUM_INTERP_shift));
+	set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_0, (2 << NUM_INTERP_shift));
     } else {
 	/* export 1 tex coords from VS */
-	EREG(accel_state->ib, SPI_VS_OUT_CONFIG, ((1 - 1) << VS_EXPORT_COUNT_shift));
+	set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_CONFIG, ((1 - 1) << VS_EXPORT_COUNT_shift));
 	/* src = semantic id 0 */
-	EREG(accel_state->ib, SPI_VS_OUT_ID_0,   (0 << SEMANTIC_0_shift));
+	set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
 	/* input 1 tex coords from VS */
-	EREG(accel_state->ib, SPI_PS_IN_CONTROL_0, (1 << NUM_INTERP_shift));
+	set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_0, (1 << NUM_INTERP_shift));
     }
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_1,                 0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_1, 0);
     /* SPI_PS_INPUT_CNTL_0 maps to GPR[0] - load with semantic id 0 */
-    EREG(accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2),       ((0    << SEMANTIC_shift)	|
-								(0x01 << DEFAULT_VAL_shift)	|
-								SEL_CENTROID_bit));
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2), ((0    << SEMANTIC_shift)	|
+									    (0x01 << DEFAULT_VAL_shift)	|
+									    SEL_CENTROID_bit));
     /* SPI_PS_INPUT_CNTL_1 maps to GPR[1] - load with semantic id 1 */
-    EREG(accel_state->ib, SPI_PS_INPUT_CNTL_0 + (1 <<2),       ((1    << SEMANTIC_shift)	|
-								(0x01 << DEFAULT_VAL_shift)	|
-								SEL_CENTROID_bit));
-    EREG(accel_state->ib, SPI_INTERP_CONTROL_0,                0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_INPUT_CNTL_0 + (1 <<2), ((1    << SEMANTIC_shift)	|
+									    (0x01 << DEFAULT_VAL_shift)	|
+									    SEL_CENTROID_bit));
+    set_context_reg(pScrn, accel_state->ib, SPI_INTERP_CONTROL_0, 0);
 
     accel_state->vb_index = 0;
 
+    RHDProfBegin(pScrn, RHD_PROF_COMPOSITE, op, pDstPicture->format);
+
     return TRUE;
 }
 
@@ -1590,97 +2074,66 @@ static void R600Composite(PixmapPtr pDst,
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
     float *vb;
-    xPointFixed srcTopLeft, srcTopRight, srcBottomLeft, srcBottomRight;
 
     /* ErrorF("R600Composite (%d,%d) (%d,%d) (%d,%d) (%d,%d)\n",
        srcX, srcY, maskX, maskY,dstX, dstY, w, h); */
 
-    srcTopLeft.x     = IntToxFixed(srcX);
-    srcTopLeft.y     = IntToxFixed(srcY);
-    srcTopRight.x    = IntToxFixed(srcX + w);
-    srcTopRight.y    = IntToxFixed(srcY);
-    srcBottomLeft.x  = IntToxFixed(srcX);
-    srcBottomLeft.y  = IntToxFixed(srcY + h);
-    srcBottomRight.x = IntToxFixed(srcX + w);
-    srcBottomRight.y = IntToxFixed(srcY + h);
-
-    /* XXX do transform in vertex shader */
-    if (accel_state->is_transform[0]) {
-	transformPoint(accel_state->transform[0], &srcTopLeft);
-	transformPoint(accel_state->transform[0], &srcTopRight);
-	transformPoint(accel_state->transform[0], &srcBottomLeft);
-	transformPoint(accel_state->transform[0], &srcBottomRight);
-    }
-
-    if (accel_state->has_mask) {
-	xPointFixed maskTopLeft, maskTopRight, maskBottomLeft, maskBottomRight;
-
-	if (((accel_state->vb_index + 3) * 24) > (accel_state->ib->total / 2)) {
+    /* src/mask get transformed and normalized in the vertex shader */
+    if (accel_state->has_mask && !accel_state->mask_solid) {
+	if (!R600VBFits(pScrn, 24, 3)) {
 	    R600DoneComposite(pDst);
-	    accel_state->vb_index = 0;
-	    accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+	    if (!R600VBNext(pScrn))
+		return;
+	    RHDProfResume(pScrn);
 	}
 
-	vb = (pointer)((char*)accel_state->ib->address +
-		       (accel_state->ib->total / 2) +
-		       accel_state->vb_index * 24);
-
-	maskTopLeft.x     = IntToxFixed(maskX);
-	maskTopLeft.y     = IntToxFixed(maskY);
-	maskTopRight.x    = IntToxFixed(maskX + w);
-	maskTopRight.y    = IntToxFixed(maskY);
-	maskBottomLeft.x  = IntToxFixed(maskX);
-	maskBottomLeft.y  = IntToxFixed(maskY + h);
-	maskBottomRight.x = IntToxFixed(maskX + w);
-	maskBottomRight.y = IntToxFixed(maskY + h);
-
-	if (accel_state->is_transform[1]) {
-	    transformPoint(accel_state->transform[1], &maskTopLeft);
-	    transformPoint(accel_state->transform[1], &maskTopRight);
-	    transformPoint(accel_state->transform[1], &maskBottomLeft);
-	    transformPoint(accel_state->transform[1], &maskBottomRight);
-	}
+	vb = R600VBPointer(pScrn, 24);
 
 	vb[0] = (float)dstX;
 	vb[1] = (float)dstY;
-	vb[2] = xFixedToFloat(srcTopLeft.x) / accel_state->texW[0];
-	vb[3] = xFixedToFloat(srcTopLeft.y) / accel_state->texH[0];
-	vb[4] = xFixedToFloat(maskTopLeft.x) / accel_state->texW[1];
-	vb[5] = xFixedToFloat(maskTopLeft.y) / accel_state->texH[1];
+	vb[2] = (float)srcX;
+	vb[3] = (float)srcY;
+	vb[4] = (float)maskX;
+	vb[5] = (float)maskY;
 
 	vb[6] = (float)dstX;
 	vb[7] = (float)(dstY + h);
-	vb[8] = xFixedToFloat(srcBottomLeft.x) / accel_state->texW[0];
-	vb[9] = xFixedToFloat(srcBottomLeft.y) / accel_state->texH[0];
-	vb[10] = xFixedToFloat(maskBottomLeft.x) / accel_state->texW[1];
-	vb[11] = xFixedToFloat(maskBottomLeft.y) / accel_state->texH[1];
+	vb[8] = (float)srcX;
+	vb[9] = (float)(srcY + h);
+	vb[10] = (float)maskX;
+	vb[11] = (float)(maskY + h);
 
 	vb[12] = (float)(dstX + w);
 	vb[13] = (float)(dstY + h);
-	vb[14] = xFixedToFloat(srcBottomRight.x) / accel_state->texW[0];
-	vb[15] = xFixedToFloat(srcBottomRight.y) / accel_state->texH[0];
-	vb[16] = xFixedToFloat(maskBottomRight.x) / accel_state->texW[1];
-	vb[17] = xFixedToFloat(maskBottomRight.y) / accel_state->texH[1];
+	vb[14] = (float)(srcX + w);
+	vb[15] = (float)(srcY + h);
+	vb[16] = (float)(maskX + w);
+	vb[17] = (float)(maskY + h);
 
     } else {
-	vb = (pointer)((char*)accel_state->ib->address +
-		       (accel_state->ib->total / 2) +
-		       accel_state->vb_index * 16);
+	if (!R600VBFits(pScrn, 16, 3)) {
+	    R600DoneComposite(pDst);
+	    if (!R600VBNext(pScrn))
+		return;
+	    RHDProfResume(pScrn);
+	}
+
+	vb = R600VBPointer(pScrn, 16);
 
 	vb[0] = (float)dstX;
 	vb[1] = (float)dstY;
-	vb[2] = xFixedToFloat(srcTopLeft.x) / accel_state->texW[0];
-	vb[3] = xFixedToFloat(srcTopLeft.y) / accel_state->texH[0];
+	vb[2] = (float)srcX;
+	vb[3] = (float)srcY;
 
 	vb[4] = (float)dstX;
 	vb[5] = (float)(dstY + h);
-	vb[6] = xFixedToFloat(srcBottomLeft.x) / accel_state->texW[0];
-	vb[7] = xFixedToFloat(srcBottomLeft.y) / accel_state->texH[0];
+	vb[6] = (float)srcX;
+	vb[7] = (float)(srcY + h);
 
 	vb[8] = (float)(dstX + w);
 	vb[9] = (float)(dstY + h);
-	vb[10] = xFixedToFloat(srcBottomRight.x) / accel_state->texW[0];
-	vb[11] = xFixedToFloat(srcBottomRight.y) / accel_state->texH[0];
+	vb[10] = (float)(srcX + w);
+	vb[11] = (float)(srcY + h);
     }
 
     accel_state->vb_index += 3;
@@ -1699,16 +2152,15 @@ static void R600DoneComposite(PixmapPtr pDst)
     CLEAR (vtx_res);
 
     if (accel_state->vb_index == 0) {
-	R600IBDiscard(pScrn, accel_state->ib);
+	RHDProfEnd(pScrn);
 	return;
     }
 
-    accel_state->vb_mc_addr = RHDDRIGetIntGARTLocation(pScrn) +
-	(accel_state->ib->idx * accel_state->ib->total) + (accel_state->ib->total / 2);
+    accel_state->vb_mc_addr = R600VBAddress(pScrn);
 
 
     /* Vertex buffer setup */
-    if (accel_state->has_mask) {
+    if (accel_state->has_mask && !accel_state->mask_solid) {
 	accel_state->vb_size = accel_state->vb_index * 24;
 	vtx_res.id              = SQ_VTX_RESOURCE_vs;
 	vtx_res.vtx_size_dw     = 24 / 4;
@@ -1753,21 +2205,27 @@ static void R600DoneComposite(PixmapPtr pDst)
     cp_set_surface_sync(pScrn, accel_state->ib, (CB_ACTION_ENA_bit | CB0_DEST_BASE_ENA_bit),
 			accel_state->dst_size, accel_state->dst_mc_addr);
 
-    R600CPFlushIndirect(pScrn, accel_state->ib);
+    RHDProfEnd(pScrn);
+
+    R600IBFinish(pScrn);
 }
 
-Bool
-R600CopyToVRAM(ScrnInfoPtr pScrn,
-	       char *src, int src_pitch,
-	       uint32_t dst_pitch, uint32_t dst_mc_addr, uint32_t dst_height, int bpp,
-	       int x, int y, int w, int h)
+/*
+ * Each pass fills the next staging buffer and queues the blit from it, which
+ * only waits for the blit which last used that buffer. The last blits are
+ * left running when we return. The blit also does the tiling.
+ */
+static Bool
+R600DoCopyToVRAM(ScrnInfoPtr pScrn,
+		 char *src, int src_pitch,
+		 uint32_t dst_pitch, uint32_t dst_mc_addr, uint32_t dst_height, int bpp,
+		 int dst_array_mode,
+		 int x, int y, int w, int h)
 {
-    struct RhdCS *CS = RHDPTR(pScrn)->CS;
-    uint32_t scratch_mc_addr;
     int wpass = w * (bpp/8);
     int scratch_pitch_bytes = (wpass + 255) & ~255;
     uint32_t scratch_pitch = scratch_pitch_bytes / (bpp / 8);
-    int scratch_offset = 0, hpass, temph;
+    int hpass, temph, slot;
     char *dst;
     drmBufPtr scratch;
 
@@ -1777,54 +2235,57 @@ R600CopyToVRAM(ScrnInfoPtr pScrn,
     if (dst_mc_addr & 0xff)
 	return FALSE;
 
-    scratch = RHDDRMCPBuffer(pScrn->scrnIndex);
-    if (scratch == NULL)
-	return FALSE;
-
-    scratch_mc_addr = RHDDRIGetIntGARTLocation(pScrn) + (scratch->idx * scratch->total);
-    temph = hpass = min(h, scratch->total/2 / scratch_pitch_bytes);
-    dst = (char *)scratch->address;
+    while (h) {
+	scratch = R600StagingGet(pScrn, &slot);
+	if (scratch == NULL) /* the ring shrunk: wait for what is left of it */
+	    scratch = R600StagingGet(pScrn, &slot);
+	if (scratch == NULL)
+	    return FALSE;
 
-    /* memcopy from sys to scratch */
-    while (temph--) {
-	memcpy (dst, src, wpass);
-	src += src_pitch;
-	dst += scratch_pitch_bytes;
-    }
+	hpass = min(h, scratch->total / scratch_pitch_bytes);
+	if (!hpass)
+	    return FALSE;
 
-    while (h) {
-	uint32_t offset = scratch_mc_addr + scratch_offset;
-	int oldhpass = hpass;
-	h -= oldhpass;
-	temph = hpass = min(h, scratch->total/2 / scratch_pitch_bytes);
-
-	if (hpass) {
-	    scratch_offset = scratch->total/2 - scratch_offset;
-	    dst = (char *)scratch->address + scratch_offset;
-	    /* wait for the engine to be idle */
-	    RHDCSIdle(CS);
-	    /* memcopy from sys to scratch */
-	    while (temph--) {
-		memcpy (dst, src, wpass);
-		src += src_pitch;
-		dst += scratch_pitch_bytes;
-	    }
+	/* memcopy from sys to scratch */
+	dst = (char *)scratch->address;
+	temph = hpass;
+	while (temph--) {
+	    memcpy (dst, src, wpass);
+	    src += src_pitch;
+	    dst += scratch_pitch_bytes;
 	}
+
 	/* blit from scratch to vram */
-	R600DoPrepareCopy(pScrn,
-			  scratch_pitch, w, oldhpass, offset, bpp,
-			  dst_pitch, dst_height, dst_mc_addr, bpp,
-			  3, 0xffffffff);
-	R600AppendCopyVertex(pScrn, 0, 0, x, y, w, oldhpass);
+	if (!R600DoPrepareCopy(pScrn,
+			       scratch_pitch, w, hpass, R600StagingAddress(pScrn, scratch), bpp,
+			       ARRAY_LINEAR_GENERAL,
+			       dst_pitch, dst_height, dst_mc_addr, bpp,
+			       dst_array_mode,
+			       3, 0xffffffff))
+	    return FALSE;
+	R600AppendCopyVertex(pScrn, 0, 0, x, y, w, hpass);
 	R600DoCopy(pScrn);
-	y += oldhpass;
-    }
 
-    R600IBDiscard(pScrn, scratch);
+	R600StagingQueued(pScrn, slot);
+
+	y += hpass;
+	h -= hpass;
+    }
 
     return TRUE;
 }
 
+Bool
+R600CopyToVRAM(ScrnInfoPtr pScrn,
+	       char *src, int src_pitch,
+	       uint32_t dst_pitch, uint32_t dst_mc_addr, uint32_t dst_height, int bpp,
+	       int x, int y, int w, int h)
+{
+    return R600DoCopyToVRAM(pScrn, src, src_pitch,
+			    dst_pitch, dst_mc_addr, dst_height, bpp,
+			    ARRAY_LINEAR_GENERAL, x, y, w, h);
+}
+
 static Bool
 R600UploadToScreen(PixmapPtr pDst, int x, int y, int w, int h,
 		   char *src, int src_pitch)
@@ -1835,93 +2296,658 @@ R600UploadToScreen(PixmapPtr pDst, int x, int y, int w, int h,
     uint32_t dst_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + exaGetPixmapOffset(pDst);
     uint32_t dst_height = pDst->drawable.height;
     int bpp = pDst->drawable.bitsPerPixel;
+    Bool ret;
+
+    RHDProfBegin(pScrn, RHD_PROF_UPLOAD, 0, bpp);
+
+    ret = R600DoCopyToVRAM(pScrn,
+			   src, src_pitch,
+			   dst_pitch, dst_mc_addr, dst_height, bpp,
+			   R600PixmapArrayMode(pDst),
+			   x, y, w, h);
+
+    RHDProfEnd(pScrn);
+
+    return ret;
+}
+
+/*
+ * RV740 gets small blits to GART wrong. These are cheap enough to read
+ * straight from the framebuffer, once the engine is done with it and the
+ * HDP no longer holds stale data.
+ */
+static void
+R600DownloadDirect(PixmapPtr pSrc, int x, int y, int w, int h,
+		   char *dst, int dst_pitch)
+{
+    ScrnInfoPtr pScrn = xf86Screens[pSrc->drawable.pScreen->myNum];
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct RhdCS *CS = rhdPtr->CS;
+    int src_pitch = exaGetPixmapPitch(pSrc);
+    int cpp = pSrc->drawable.bitsPerPixel / 8;
+    char *src = (char *)rhdPtr->FbBase + rhdPtr->FbScanoutStart +
+	exaGetPixmapOffset(pSrc) + y * src_pitch + x * cpp;
+
+    R600IBFlush(pScrn);
+    RHDCSFenceWait(CS, RHDCSFenceEmit(CS));
+
+    /* flush HDP read/write caches */
+    RHDRegWrite(rhdPtr, HDP_MEM_COHERENCY_FLUSH_CNTL, 0x1);
 
-    return R600CopyToVRAM(pScrn,
-			  src, src_pitch,
-			  dst_pitch, dst_mc_addr, dst_height, bpp,
-			  x, y, w, h);
+    while (h--) {
+	memcpy (dst, src, w * cpp);
+	src += src_pitch;
+	dst += dst_pitch;
+    }
 }
 
+/*
+ * The blits into the staging buffers are started ahead, and each buffer is
+ * copied out under its fence while the engine works on the next ones.
+ */
 static Bool
 R600DownloadFromScreen(PixmapPtr pSrc, int x, int y, int w, int h,
 		       char *dst, int dst_pitch)
 {
     ScrnInfoPtr pScrn = xf86Screens[pSrc->drawable.pScreen->myNum];
     RHDPtr rhdPtr = RHDPTR(pScrn);
-    struct RhdCS *CS = rhdPtr->CS;
     uint32_t src_pitch = exaGetPixmapPitch(pSrc) / (pSrc->drawable.bitsPerPixel / 8);
     uint32_t src_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + exaGetPixmapOffset(pSrc);
+    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
     uint32_t src_width = pSrc->drawable.width;
     uint32_t src_height = pSrc->drawable.height;
     int bpp = pSrc->drawable.bitsPerPixel;
-    uint32_t scratch_mc_addr;
-    int scratch_pitch_bytes = (dst_pitch + 255) & ~255;
-    int scratch_offset = 0, hpass;
-    uint32_t scratch_pitch = scratch_pitch_bytes / (bpp / 8);
+    int array_mode = R600PixmapArrayMode(pSrc);
     int wpass = w * (bpp/8);
+    int scratch_pitch_bytes = (wpass + 255) & ~255;
+    uint32_t scratch_pitch = scratch_pitch_bytes / (bpp / 8);
+    struct {
+	drmBufPtr scratch;
+	int slot;
+	int h;
+    } pass[R600_STAGING_SLOTS];
+    int first = 0, queued = 0, hpass, i;
     drmBufPtr scratch;
-
-    /* RV740 seems to be particularly problematic with small xfers */
-    /* if ((rhdPtr->ChipSet == RHD_RV740) && (w < 32 || h < 32)) */
-    /* Composite in software with DFS partially active breaks badly */
-    if (rhdPtr->ChipSet == RHD_RV740)
-	return FALSE;
+    char *src;
 
     if (src_pitch & 7)
 	return FALSE;
 
-    scratch = RHDDRMCPBuffer(pScrn->scrnIndex);
-    if (scratch == NULL)
-	return FALSE;
+    RHDProfBegin(pScrn, RHD_PROF_DOWNLOAD, 0, bpp);
+
+    if ((rhdPtr->ChipSet == RHD_RV740) && (w < 32 || h < 32)) {
+	R600DownloadDirect(pSrc, x, y, w, h, dst, dst_pitch);
+	RHDProfEnd(pScrn);
+	return TRUE;
+    }
 
-    scratch_mc_addr = RHDDRIGetIntGARTLocation(pScrn) + (scratch->idx * scratch->total);
-    hpass = min(h, scratch->total/2 / scratch_pitch_bytes);
+    while (h || queued) {
+	/* keep the engine busy, in all staging buffers we did not get to yet */
+	while (h && (queued < accel_state->staging_count)) {
+	    i = (first + queued) % R600_STAGING_SLOTS;
 
-    /* blit from vram to scratch */
-    R600DoPrepareCopy(pScrn,
-		      src_pitch, src_width, src_height, src_mc_addr, bpp,
-		      scratch_pitch, hpass, scratch_mc_addr, bpp,
-		      3, 0xffffffff);
-    R600AppendCopyVertex(pScrn, x, y, 0, 0, w, hpass);
-    R600DoCopy(pScrn);
+	    pass[i].scratch = R600StagingGet(pScrn, &pass[i].slot);
+	    /* the ring shrunk: once nothing is held, wait for what is left of it */
+	    if (!pass[i].scratch && !queued)
+		pass[i].scratch = R600StagingGet(pScrn, &pass[i].slot);
+	    if (!pass[i].scratch)
+		break;
+
+	    hpass = min(h, pass[i].scratch->total / scratch_pitch_bytes);
+	    if (!hpass)
+		break;
 
-    while (h) {
-	char *src = (char *)scratch->address + scratch_offset;
-	int oldhpass = hpass;
-	h -= oldhpass;
-	y += oldhpass;
-	hpass = min(h, scratch->total/2 / scratch_pitch_bytes);
-
-	if (hpass) {
-	    scratch_offset = scratch->total/2 - scratch_offset;
 	    /* blit from vram to scratch */
-	    R600DoPrepareCopy(pScrn,
-			      src_pitch, src_width, src_height, src_mc_addr, bpp,
-			      scratch_pitch, hpass, scratch_mc_addr + scratch_offset, bpp,
-			      3, 0xffffffff);
+	    if (!R600DoPrepareCopy(pScrn,
+				   src_pitch, src_width, src_height, src_mc_addr, bpp,
+				   array_mode,
+				   scratch_pitch, hpass,
+				   R600StagingAddress(pScrn, pass[i].scratch), bpp,
+				   ARRAY_LINEAR_GENERAL,
+				   3, 0xffffffff))
+		break;
 	    R600AppendCopyVertex(pScrn, x, y, 0, 0, w, hpass);
 	    R600DoCopy(pScrn);
+
+	    R600StagingQueued(pScrn, pass[i].slot);
+
+	    pass[i].h = hpass;
+	    queued++;
+	    y += hpass;
+	    h -= hpass;
 	}
 
-	/* wait for the engine to be idle */
-	RHDCSIdle(CS);
-	/* memcopy from scratch to sys */
-	while (oldhpass--) {
+	if (!queued) {
+	    RHDProfEnd(pScrn);
+	    return FALSE;
+	}
+
+	/* memcopy from scratch to sys, once the blit has landed */
+	R600StagingWait(pScrn, pass[first].slot);
+
+	scratch = pass[first].scratch;
+	src = (char *)scratch->address;
+	hpass = pass[first].h;
+	while (hpass--) {
 	    memcpy (dst, src, wpass);
 	    dst += dst_pitch;
 	    src += scratch_pitch_bytes;
 	}
+
+	first = (first + 1) % R600_STAGING_SLOTS;
+	queued--;
     }
 
-    R600IBDiscard(pScrn, scratch);
+    RHDProfEnd(pScrn);
 
     return TRUE;
 
 }
 
+#ifdef R600_GLYPH_CACHE
+/*
+ * Glyph cache.
+ *
+ * Anti-aliased glyphs are kept in the cells of an a8 atlas pixmap, so that a
+ * whole glyph string goes out as a single composite with the atlas as mask,
+ * instead of a full composite setup per glyph. Cells are found through the
+ * glyph sha1, and the least recently used one is replaced when the atlas is
+ * full.
+ */
+#define R600_GLYPH_CELL     32 /* biggest glyph that gets cached */
+#define R600_GLYPH_ATLAS_W  1024
+#define R600_GLYPH_ATLAS_H  512
+#define R600_GLYPH_CELLS    ((R600_GLYPH_ATLAS_W / R600_GLYPH_CELL) * (R600_GLYPH_ATLAS_H / R600_GLYPH_CELL))
+#define R600_GLYPH_HASH     1024
+
+struct R600GlyphCell {
+    unsigned char sha1[20];
+    CARD32 Stamp; /* R600Glyphs() call that used this last */
+    int Next; /* hash chain */
+    Bool Used;
+};
+
+struct R600GlyphCache {
+    GlyphsProcPtr Glyphs; /* wrapped */
+    PicturePtr pAtlas;
+    CARD32 Stamp;
+    int Hash[R600_GLYPH_HASH];
+    struct R600GlyphCell Cells[R600_GLYPH_CELLS];
+};
+
+/*
+ *
+ */
+static int
+R600GlyphHash(unsigned char *sha1)
+{
+    return (sha1[0] | (sha1[1] << 8)) & (R600_GLYPH_HASH - 1);
+}
+
+/*
+ *
+ */
+static Bool
+R600GlyphAtlas(ScreenPtr pScreen, struct R600GlyphCache *Cache)
+{
+    PictFormatPtr pFormat;
+    PixmapPtr pPixmap;
+    int error;
+
+    if (Cache->pAtlas)
+	return TRUE;
+
+    pFormat = PictureMatchFormat(pScreen, 8, PICT_a8);
+    if (!pFormat)
+	return FALSE;
+
+#ifdef CREATE_PIXMAP_USAGE_SCRATCH
+    pPixmap = pScreen->CreatePixmap(pScreen, R600_GLYPH_ATLAS_W, R600_GLYPH_ATLAS_H, 8, 0);
+#else
+    pPixmap = pScreen->CreatePixmap(pScreen, R600_GLYPH_ATLAS_W, R600_GLYPH_ATLAS_H, 8);
+#endif
+    if (!pPixmap)
+	return FALSE;
+
+    /* the picture holds its own reference to the pixmap */
+    Cache->pAtlas = CreatePicture(0, &pPixmap->drawable, pFormat, 0, 0, serverClient, &error);
+    pScreen->DestroyPixmap(pPixmap);
+
+    return Cache->pAtlas != NULL;
+}
+
+/*
+ * Find or load the cell for this glyph. Returns -1 when all cells are taken
+ * by the string at hand already.
+ */
+static int
+R600GlyphCellGet(ScreenPtr pScreen, struct R600GlyphCache *Cache, GlyphPtr pGlyph)
+{
+    struct R600GlyphCell *Cell;
+    int hash = R600GlyphHash(pGlyph->sha1);
+    int i, *prev, victim = -1;
+
+    for (i = Cache->Hash[hash]; i != -1; i = Cache->Cells[i].Next)
+	if (!memcmp(Cache->Cells[i].sha1, pGlyph->sha1, sizeof(pGlyph->sha1))) {
+	    Cache->Cells[i].Stamp = Cache->Stamp;
+	    return i;
+	}
+
+    for (i = 0; i < R600_GLYPH_CELLS; i++) {
+	Cell = &Cache->Cells[i];
+
+	if (!Cell->Used) {
+	    victim = i;
+	    break;
+	}
+
+	if ((Cell->Stamp != Cache->Stamp) &&
+	    ((victim == -1) || ((INT32) (Cell->Stamp - Cache->Cells[victim].Stamp) < 0)))
+	    victim = i;
+    }
+
+    if (victim == -1)
+	return -1;
+
+    Cell = &Cache->Cells[victim];
+    if (Cell->Used) {
+	for (prev = &Cache->Hash[R600GlyphHash(Cell->sha1)]; *prev != victim;
+	     prev = &Cache->Cells[*prev].Next)
+	    ;
+	*prev = Cell->Next;
+    }
+
+    CompositePicture(PictOpSrc, GlyphPicture(pGlyph)[pScreen->myNum], NULL, Cache->pAtlas,
+		     0, 0, 0, 0,
+		     (victim % (R600_GLYPH_ATLAS_W / R600_GLYPH_CELL)) * R600_GLYPH_CELL,
+		     (victim / (R600_GLYPH_ATLAS_W / R600_GLYPH_CELL)) * R600_GLYPH_CELL,
+		     pGlyph->info.width, pGlyph->info.height);
+
+    memcpy(Cell->sha1, pGlyph->sha1, sizeof(pGlyph->sha1));
+    Cell->Stamp = Cache->Stamp;
+    Cell->Used = TRUE;
+    Cell->Next = Cache->Hash[hash];
+    Cache->Hash[hash] = victim;
+
+    return victim;
+}
+
+/*
+ * Same check as the Xv code: we are about to draw straight into this pixmap
+ * behind EXA's back, so it has to live in the framebuffer.
+ */
+static PixmapPtr
+R600GlyphPixmap(RHDPtr rhdPtr, DrawablePtr pDrawable)
+{
+    PixmapPtr pPixmap = RADEONGetDrawablePixmap(pDrawable);
+
+    exaMoveInPixmap(pPixmap);
+
+    if (((char *)pPixmap->devPrivate.ptr < ((char *)rhdPtr->FbBase + rhdPtr->FbScanoutStart)) ||
+	((char *)pPixmap->devPrivate.ptr >= ((char *)rhdPtr->FbBase + rhdPtr->FbMapSize)))
+	return NULL;
+
+    return pPixmap;
+}
+
+/*
+ *
+ */
+static void
+R600GlyphPixmapDeltas(DrawablePtr pDrawable, PixmapPtr pPixmap, int *x, int *y)
+{
+#ifdef COMPOSITE
+    if (pDrawable->type == DRAWABLE_WINDOW) {
+	*x = -pPixmap->screen_x;
+	*y = -pPixmap->screen_y;
+	return;
+    }
+#endif
+    *x = 0;
+    *y = 0;
+}
+
+/*
+ * Can the whole string go through the atlas? Loads the glyphs into their
+ * cells while at it.
+ */
+static Bool
+R600GlyphsCheck(ScreenPtr pScreen, struct R600GlyphCache *Cache, CARD8 op,
+		PicturePtr pSrc, PicturePtr pDst, PictFormatPtr maskFormat,
+		int nlist, GlyphListPtr list, GlyphPtr *glyphs)
+{
+    BoxRec extents = { MAXSHORT, MAXSHORT, MINSHORT, MINSHORT };
+    int x = 0, y = 0, n;
+
+    if (maskFormat) {
+	/*
+	 * Drawing each glyph with op only matches going through a temporary
+	 * mask when no glyphs overlap and uncovered pixels are left alone.
+	 */
+	if (maskFormat->format != PICT_a8)
+	    return FALSE;
+	if ((op != PictOpOver) && (op != PictOpAdd))
+	    return FALSE;
+    }
+
+    if (!R600GlyphAtlas(pScreen, Cache))
+	return FALSE;
+
+    if (!R600CheckComposite(op, pSrc, Cache->pAtlas, pDst))
+	return FALSE;
+
+    Cache->Stamp++;
+
+    for (; nlist; nlist--, list++) {
+	x += list->xOff;
+	y += list->yOff;
+
+	for (n = list->len; n; n--, glyphs++) {
+	    GlyphPtr pGlyph = *glyphs;
+	    PicturePtr pPicture = GlyphPicture(pGlyph)[pScreen->myNum];
+	    BoxRec box;
+
+	    if (pGlyph->info.width && pGlyph->info.height) {
+		if (!pPicture || (pPicture->format != PICT_a8) ||
+		    (pGlyph->info.width > R600_GLYPH_CELL) ||
+		    (pGlyph->info.height > R600_GLYPH_CELL))
+		    return FALSE;
+
+		if (maskFormat) {
+		    box.x1 = x - pGlyph->info.x;
+		    box.y1 = y - pGlyph->info.y;
+		    box.x2 = box.x1 + pGlyph->info.width;
+		    box.y2 = box.y1 + pGlyph->info.height;
+
+		    if ((box.x1 < extents.x2) && (box.x2 > extents.x1) &&
+			(box.y1 < extents.y2) && (box.y2 > extents.y1))
+			return FALSE;
+
+		    if (box.x1 < extents.x1)
+			extents.x1 = box.x1;
+		    if (box.y1 < extents.y1)
+			extents.y1 = box.y1;
+		    if (box.x2 > extents.x2)
+			extents.x2 = box.x2;
+		    if (box.y2 > extents.y2)
+			extents.y2 = box.y2;
+		}
+
+		if (R600GlyphCellGet(pScreen, Cache, pGlyph) == -1)
+		    return FALSE;
+	    }
+
+	    x += pGlyph->info.xOff;
+	    y += pGlyph->info.yOff;
+	}
+    }
+
+    return TRUE;
+}
+
+/*
+ * Draw all glyphs of the string with a single composite setup, taking their
+ * coverage from the atlas.
+ */
+static Bool
+R600GlyphsDraw(ScreenPtr pScreen, struct R600GlyphCache *Cache, CARD8 op,
+	       PicturePtr pSrc, PicturePtr pDst, INT16 xSrc, INT16 ySrc,
+	       int nlist, GlyphListPtr list, GlyphPtr *glyphs)
+{
+    RHDPtr rhdPtr = RHDPTR(xf86Screens[pScreen->myNum]);
+    PicturePtr pAtlas = Cache->pAtlas;
+    PixmapPtr pSrcPix = NULL, pDstPix, pAtlasPix;
+    int src_off_x = 0, src_off_y = 0, dst_off_x, dst_off_y;
+    int src_x = 0, src_y = 0;
+    int xDst = list->xOff, yDst = list->yOff;
+    int x = 0, y = 0, n;
+    RegionRec damage;
+
+    /* solid sources have no pixmap, their colour ends up in the shader */
+    if (pSrc->pDrawable) {
+	pSrcPix = R600GlyphPixmap(rhdPtr, pSrc->pDrawable);
+	if (!pSrcPix)
+	    return FALSE;
+	src_x = pSrc->pDrawable->x;
+	src_y = pSrc->pDrawable->y;
+    }
+    pDstPix = R600GlyphPixmap(rhdPtr, pDst->pDrawable);
+    pAtlasPix = R600GlyphPixmap(rhdPtr, pAtlas->pDrawable);
+    if (!pDstPix || !pAtlasPix)
+	return FALSE;
+
+    if (!R600PrepareComposite(op, pSrc, pAtlas, pDst, pSrcPix, pAtlasPix, pDstPix))
+	return FALSE;
+
+    if (pSrcPix)
+	R600GlyphPixmapDeltas(pSrc->pDrawable, pSrcPix, &src_off_x, &src_off_y);
+    R600GlyphPixmapDeltas(pDst->pDrawable, pDstPix, &dst_off_x, &dst_off_y);
+
+    REGION_NULL(pScreen, &damage);
+
+    for (; nlist; nlist--, list++) {
+	x += list->xOff;
+	y += list->yOff;
+
+	for (n = list->len; n; n--, glyphs++) {
+	    GlyphPtr pGlyph = *glyphs;
+
+	    if (pGlyph->info.width && pGlyph->info.height) {
+		int cell = R600GlyphCellGet(pScreen, Cache, pGlyph);
+		int dstX = x - pGlyph->info.x + pDst->pDrawable->x;
+		int dstY = y - pGlyph->info.y + pDst->pDrawable->y;
+		int srcX = xSrc + (x - pGlyph->info.x) - xDst + src_x;
+		int srcY = ySrc + (y - pGlyph->info.y) - yDst + src_y;
+		int maskX = (cell % (R600_GLYPH_ATLAS_W / R600_GLYPH_CELL)) * R600_GLYPH_CELL;
+		int maskY = (cell / (R600_GLYPH_ATLAS_W / R600_GLYPH_CELL)) * R600_GLYPH_CELL;
+		RegionRec region;
+		BoxPtr pBox;
+		int nBox;
+
+		if (!miComputeCompositeRegion(&region, pSrc, pAtlas, pDst,
+					      srcX, srcY, maskX, maskY, dstX, dstY,
+					      pGlyph->info.width, pGlyph->info.height)) {
+		    x += pGlyph->info.xOff;
+		    y += pGlyph->info.yOff;
+		    continue;
+		}
+
+		REGION_UNION(pScreen, &damage, &damage, &region);
+		REGION_TRANSLATE(pScreen, &region, dst_off_x, dst_off_y);
+
+		srcX += src_off_x - dstX - dst_off_x;
+		srcY += src_off_y - dstY - dst_off_y;
+		maskX -= dstX + dst_off_x;
+		maskY -= dstY + dst_off_y;
+
+		nBox = REGION_NUM_RECTS(&region);
+		pBox = REGION_RECTS(&region);
+		for (; nBox; nBox--, pBox++)
+		    R600Composite(pDstPix, pBox->x1 + srcX, pBox->y1 + srcY,
+				  pBox->x1 + maskX, pBox->y1 + maskY,
+				  pBox->x1, pBox->y1,
+				  pBox->x2 - pBox->x1, pBox->y2 - pBox->y1);
+
+		REGION_UNINIT(pScreen, &region);
+	    }
+
+	    x += pGlyph->info.xOff;
+	    y += pGlyph->info.yOff;
+	}
+    }
+
+    R600DoneComposite(pDstPix);
+
+    DamageDamageRegion(pDst->pDrawable, &damage);
+    REGION_UNINIT(pScreen, &damage);
+
+    exaMarkSync(pScreen);
+
+    return TRUE;
+}
+
+/*
+ *
+ */
+static void
+R600Glyphs(CARD8 op, PicturePtr pSrc, PicturePtr pDst, PictFormatPtr maskFormat,
+	   INT16 xSrc, INT16 ySrc, int nlist, GlyphListPtr list, GlyphPtr *glyphs)
+{
+    ScreenPtr pScreen = pDst->pDrawable->pScreen;
+    PictureScreenPtr ps = GetPictureScreenIfSet(pScreen);
+    struct r6xx_accel_state *accel_state =
+	RHDPTR(xf86Screens[pScreen->myNum])->TwoDPrivate;
+    struct R600GlyphCache *Cache = accel_state->glyph_cache;
+
+    if (nlist &&
+	R600GlyphsCheck(pScreen, Cache, op, pSrc, pDst, maskFormat, nlist, list, glyphs) &&
+	R600GlyphsDraw(pScreen, Cache, op, pSrc, pDst, xSrc, ySrc, nlist, list, glyphs))
+	return;
+
+    ps->Glyphs = Cache->Glyphs;
+    ps->Glyphs(op, pSrc, pDst, maskFormat, xSrc, ySrc, nlist, list, glyphs);
+    ps->Glyphs = R600Glyphs;
+}
+
+/*
+ *
+ */
+static void
+R600GlyphCacheInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    PictureScreenPtr ps = GetPictureScreenIfSet(pScreen);
+    struct R600GlyphCache *Cache;
+    int i;
+
+    if (!ps)
+	return;
+
+    Cache = xcalloc(1, sizeof(struct R600GlyphCache));
+    if (!Cache)
+	return;
+
+    for (i = 0; i < R600_GLYPH_HASH; i++)
+	Cache->Hash[i] = -1;
+
+    /* the atlas itself only gets created when text is drawn first */
+    Cache->Glyphs = ps->Glyphs;
+    ps->Glyphs = R600Glyphs;
+
+    accel_state->glyph_cache = Cache;
+}
+
+/*
+ *
+ */
+static void
+R600GlyphCacheFini(ScreenPtr pScreen)
+{
+    struct r6xx_accel_state *accel_state =
+	RHDPTR(xf86Screens[pScreen->myNum])->TwoDPrivate;
+    struct R600GlyphCache *Cache = accel_state->glyph_cache;
+    PictureScreenPtr ps = GetPictureScreenIfSet(pScreen);
+
+    if (!Cache)
+	return;
+
+    if (ps)
+	ps->Glyphs = Cache->Glyphs;
+
+    if (Cache->pAtlas)
+	FreePicture(Cache->pAtlas, 0);
+
+    xfree(Cache);
+    accel_state->glyph_cache = NULL;
+}
+#endif /* R600_GLYPH_CACHE */
+
+/*
+ * Whatever is still queued up in the IB needs to hit the engine before the
+ * server goes to sleep.
+ */
+static void
+R600BlockHandler(int i, pointer blockData, pointer pTimeout, pointer pReadmask)
+{
+    ScreenPtr pScreen = screenInfo.screens[i];
+    ScrnInfoPtr pScrn = xf86Screens[i];
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    pScreen->BlockHandler = accel_state->BlockHandler;
+    (*pScreen->BlockHandler) (i, blockData, pTimeout, pReadmask);
+    pScreen->BlockHandler = R600BlockHandler;
+
+    if (pScrn->vtSema)
+	R600IBFlush(pScrn);
+}
+
+/*
+ * Engine timestamps only show up once the HDP has flushed.
+ */
+static void
+R600ProfSync(ScrnInfoPtr pScrn)
+{
+    RHDRegWrite(RHDPTR(pScrn), HDP_MEM_COHERENCY_FLUSH_CNTL, 0x1);
+}
+
+/*
+ *
+ */
+static void
+R600ProfInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
+{
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
+    struct RhdProfGPU GPU;
+
+    if (!rhdPtr->Prof)
+	return;
+
+    accel_state->prof_area = exaOffscreenAlloc(pScreen, RHD_PROF_GPU_SIZE, 256,
+					       TRUE, NULL, NULL);
+    if (!accel_state->prof_area) {
+	xf86DrvMsg(pScrn->scrnIndex, X_WARNING, "%s: No room for engine "
+		   "timestamps, only profiling the CPU side.\n", __func__);
+	return;
+    }
+
+    GPU.Map = (CARD8 *) rhdPtr->FbBase + rhdPtr->FbScanoutStart +
+	accel_state->prof_area->offset;
+    GPU.Address = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart +
+	accel_state->prof_area->offset;
+    GPU.Write = R600ProfWrite;
+    GPU.Sync = R600ProfSync;
+
+    RHDProfGPUInit(pScrn, &GPU);
+}
+
 void
 R6xxEXACloseScreen(ScreenPtr pScreen)
 {
+    ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (accel_state && accel_state->BlockHandler) {
+	pScreen->BlockHandler = accel_state->BlockHandler;
+	accel_state->BlockHandler = NULL;
+    }
+
+    if (accel_state && accel_state->copy_area) {
+	exaOffscreenFree(pScreen, accel_state->copy_area);
+	accel_state->copy_area = NULL;
+    }
+
+#ifdef R600_GLYPH_CACHE
+    if (accel_state)
+	R600GlyphCacheFini(pScreen);
+#endif
+
+    if (accel_state && accel_state->prof_area) {
+	RHDProfGPUFini(pScrn);
+	exaOffscreenFree(pScreen, accel_state->prof_area);
+	accel_state->prof_area = NULL;
+    }
+
     exaDriverFini(pScreen);
 }
 
@@ -1976,7 +3002,8 @@ R600EXASync(ScreenPtr pScreen, int marker)
     if (accel_state->exaMarkerSynced != marker) {
 	struct RhdCS *CS = RHDPTR(pScrn)->CS;
 
-	RHDCSIdle(CS);
+	R600IBFlush(pScrn);
+	RHDCSFenceWait(CS, RHDCSFenceEmit(CS));
 
 	accel_state->exaMarkerSynced = marker;
     }
@@ -1988,7 +3015,7 @@ R600AllocShaders(ScrnInfoPtr pScrn, ScreenPtr pScreen)
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
     /* 512 bytes per shader for now */
-    int size = 512 * 9;
+    int size = 512 * 13;
 
     accel_state->shaders = NULL;
 
@@ -2046,6 +3073,22 @@ R600LoadShaders(ScrnInfoPtr pScrn)
     accel_state->xv_ps_offset = 4096;
     R600_xv_ps(ChipSet, shader + accel_state->xv_ps_offset / 4);
 
+    /*  solid vs, 16bit vertices --------------------------------------- */
+    accel_state->solid_packed_vs_offset = 4608;
+    R600_solid_packed_vs(ChipSet, shader + accel_state->solid_packed_vs_offset / 4);
+
+    /*  copy vs, 16bit vertices --------------------------------------- */
+    accel_state->copy_packed_vs_offset = 5120;
+    R600_copy_packed_vs(ChipSet, shader + accel_state->copy_packed_vs_offset / 4);
+
+    /*  comp ps, solid src --------------------------------------- */
+    accel_state->comp_solid_src_ps_offset = 5632;
+    R600_comp_solid_src_ps(ChipSet, shader + accel_state->comp_solid_src_ps_offset / 4);
+
+    /*  comp ps, solid mask --------------------------------------- */
+    accel_state->comp_solid_mask_ps_offset = 6144;
+    R600_comp_solid_mask_ps(ChipSet, shader + accel_state->comp_solid_mask_ps_offset / 4);
+
     return TRUE;
 }
 
@@ -2055,6 +3098,13 @@ R600PrepareAccess(PixmapPtr pPix, int index)
     ScrnInfoPtr pScrn = xf86Screens[pPix->drawable.pScreen->myNum];
     RHDPtr rhdPtr = RHDPTR(pScrn);
 
+    /* the CPU cannot deal with tiles, EXA moves the pixmap out through DFS instead */
+    if (R600PixmapArrayMode(pPix) != ARRAY_LINEAR_GENERAL)
+	return FALSE;
+
+    /* nothing queued up may touch the pixmap behind our back */
+    R600IBFlush(pScrn);
+
     /* flush HDP read/write caches */
     RHDRegWrite(rhdPtr, HDP_MEM_COHERENCY_FLUSH_CNTL, 0x1);
 
@@ -2088,6 +3138,7 @@ R6xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
 	return FALSE;
 
     accel_state = xnfcalloc(1, sizeof(struct r6xx_accel_state));
+    accel_state->staging_count = R600_STAGING_SLOTS;
 
     EXAInfo->exa_major = EXA_VERSION_MAJOR;
     EXAInfo->exa_minor = EXA_VERSION_MINOR;
@@ -2143,6 +3194,21 @@ R6xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
     accel_state->XHas3DEngineState = FALSE;
     accel_state->copy_area = NULL;
 
+    /*
+     * tiled pixmaps can only be read back through DownloadFromScreen, which
+     * needs the staging ring: buffers in the PCI GART, from the DRM.
+     */
+    if (rhdPtr->tiledPixmaps.val.bool) {
+	if ((rhdPtr->cardType == RHD_CARD_AGP) || (rhdPtr->ChipSet == RHD_RV740) ||
+	    (CS->Type != RHD_CS_CPDMA))
+	    xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+		       "TiledPixmaps is not supported on this card.\n");
+	else {
+	    xf86DrvMsg(pScrn->scrnIndex, X_CONFIG, "Using tiled offscreen pixmaps.\n");
+	    accel_state->tiling = TRUE;
+	}
+    }
+
     rhdPtr->TwoDPrivate = accel_state;
 
     if (!R600AllocShaders(pScrn, pScreen)) {
@@ -2157,6 +3223,15 @@ R6xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
 	return FALSE;
     }
 
+    accel_state->BlockHandler = pScreen->BlockHandler;
+    pScreen->BlockHandler = R600BlockHandler;
+
+#ifdef R600_GLYPH_CACHE
+    R600GlyphCacheInit(pScrn, pScreen);
+#endif
+
+    R600ProfInit(pScrn, pScreen);
+
     exaMarkSync(pScreen);
 
     return TRUE;
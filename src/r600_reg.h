@@ -87,6 +87,16 @@ enum {
 	WAIT_MEM    = (1<<4)
 };
 
+/* packet3 IT_EVENT_WRITE_EOP encoding */
+enum {
+	EOP_EVENT_INDEX      = (5 << 8),	/* dword 1, with a *_TS event */
+
+	EOP_DATA_SEL_NONE    = (0 << 29),	/* dword 3, with the address hi bits */
+	EOP_DATA_SEL_32      = (1 << 29),
+	EOP_DATA_SEL_64      = (2 << 29),
+	EOP_DATA_SEL_COUNTER = (3 << 29)	/* 64bit GPU clock counter */
+};
+
 /* Packet3 commands */
 enum {
     IT_NOP                               = 0x10,
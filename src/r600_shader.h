@@ -346,9 +346,11 @@
 #endif
 
 extern int R600_solid_vs(enum RHD_CHIPSETS ChipSet, CARD32* vs);
+extern int R600_solid_packed_vs(enum RHD_CHIPSETS ChipSet, CARD32* vs);
 extern int R600_solid_ps(enum RHD_CHIPSETS ChipSet, CARD32* ps);
 
 extern int R600_copy_vs(enum RHD_CHIPSETS ChipSet, CARD32* vs);
+extern int R600_copy_packed_vs(enum RHD_CHIPSETS ChipSet, CARD32* vs);
 extern int R600_copy_ps(enum RHD_CHIPSETS ChipSet, CARD32* ps);
 
 extern int R600_xv_vs(enum RHD_CHIPSETS ChipSet, CARD32* shader);
@@ -357,3 +359,5 @@ extern int R600_xv_ps(enum RHD_CHIPSETS ChipSet, CARD32* shader);
 extern int R600_comp_vs(enum RHD_CHIPSETS ChipSet, CARD32* vs);
 extern int R600_comp_mask_ps(enum RHD_CHIPSETS ChipSet, CARD32* ps);
 extern int R600_comp_ps(enum RHD_CHIPSETS ChipSet, CARD32* ps);
+extern int R600_comp_solid_src_ps(enum RHD_CHIPSETS ChipSet, CARD32* ps);
+extern int R600_comp_solid_mask_ps(enum RHD_CHIPSETS ChipSet, CARD32* ps);
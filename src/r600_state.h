@@ -292,6 +292,8 @@ set_window_scissor(ScrnInfoPtr pScrn, drmBufPtr ib, int x1, int y1, int x2, int
 void
 set_clip_rect(ScrnInfoPtr pScrn, drmBufPtr ib, int id, int x1, int y1, int x2, int y2);
 void
+set_context_reg(ScrnInfoPtr pScrn, drmBufPtr ib, uint32_t reg, uint32_t val);
+void
 set_default_state(ScrnInfoPtr pScrn, drmBufPtr ib);
 void
 draw_immd(ScrnInfoPtr pScrn, drmBufPtr ib, draw_config_t *draw_conf, uint32_t *indices);
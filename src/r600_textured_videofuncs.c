@@ -34,6 +34,7 @@
 
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_prof.h"
 #include "r6xx_accel.h"
 #include "r600_shader.h"
 #include "r600_reg.h"
@@ -64,12 +65,11 @@ R600DoneTexturedVideo(ScrnInfoPtr pScrn)
     CLEAR (vtx_res);
 
     if (accel_state->vb_index == 0) {
-	R600IBDiscard(pScrn, accel_state->ib);
+	RHDProfEnd(pScrn);
 	return;
     }
 
-    accel_state->vb_mc_addr = RHDDRIGetIntGARTLocation(pScrn) +
-	(accel_state->ib->idx * accel_state->ib->total) + (accel_state->ib->total / 2);
+    accel_state->vb_mc_addr = R600VBAddress(pScrn);
     accel_state->vb_size = accel_state->vb_index * 16;
 
     /* flush vertex cache */
@@ -109,7 +109,9 @@ R600DoneTexturedVideo(ScrnInfoPtr pScrn)
     cp_set_surface_sync(pScrn, accel_state->ib, (CB_ACTION_ENA_bit | CB0_DEST_BASE_ENA_bit),
 			accel_state->dst_size, accel_state->dst_mc_addr);
 
-    R600CPFlushIndirect(pScrn, accel_state->ib);
+    RHDProfEnd(pScrn);
+
+    R600IBFinish(pScrn);
 }
 
 void
@@ -189,7 +191,10 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
     dstyoff = 0;
 #endif
 
-    accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+    if (!R600IBStart(pScrn))
+	return;
+
+    RHDProfBegin(pScrn, RHD_PROF_XV, pPriv->id, 0);
 
     /* Init */
     start_3d(pScrn, accel_state->ib);
@@ -199,8 +204,8 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
     set_default_state(pScrn, accel_state->ib);
 
     /* Scissor / viewport */
-    EREG(accel_state->ib, PA_CL_VTE_CNTL,                      VTX_XY_FMT_bit);
-    EREG(accel_state->ib, PA_CL_CLIP_CNTL,                     CLIP_DISABLE_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_VTE_CNTL,    VTX_XY_FMT_bit);
+    set_context_reg(pScrn, accel_state->ib, PA_CL_CLIP_CNTL,   CLIP_DISABLE_bit);
 
     accel_state->vs_mc_addr = rhdPtr->FbIntAddress + rhdPtr->FbScanoutStart + accel_state->shaders->offset +
 	accel_state->xv_vs_offset;
@@ -439,9 +444,9 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
     }
 
     /* Render setup */
-    EREG(accel_state->ib, CB_SHADER_MASK,                      (0x0f << OUTPUT0_ENABLE_shift));
-    EREG(accel_state->ib, R7xx_CB_SHADER_CONTROL,              (RT0_ENABLE_bit));
-    EREG(accel_state->ib, CB_COLOR_CONTROL,                    (0xcc << ROP3_shift)); /* copy */
+    set_context_reg(pScrn, accel_state->ib, CB_SHADER_MASK,    (0x0f << OUTPUT0_ENABLE_shift));
+    set_context_reg(pScrn, accel_state->ib, R7xx_CB_SHADER_CONTROL, (RT0_ENABLE_bit));
+    set_context_reg(pScrn, accel_state->ib, CB_COLOR_CONTROL,  (0xcc << ROP3_shift)); /* copy */
 
     cb_conf.id = 0;
 
@@ -450,6 +455,7 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
     cb_conf.w = accel_state->dst_pitch;
     cb_conf.h = pPixmap->drawable.height;
     cb_conf.base = accel_state->dst_mc_addr;
+    cb_conf.array_mode = R600PixmapArrayMode(pPixmap);
 
     switch (pPixmap->drawable.bitsPerPixel) {
     case 16:
@@ -473,25 +479,25 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
     cb_conf.blend_clamp = 1;
     set_render_target(pScrn, accel_state->ib, &cb_conf);
 
-    EREG(accel_state->ib, PA_SU_SC_MODE_CNTL,                  (FACE_bit			|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
-								(POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
-    EREG(accel_state->ib, DB_SHADER_CONTROL,                   ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
+    set_context_reg(pScrn, accel_state->ib, PA_SU_SC_MODE_CNTL, (FACE_bit			|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_FRONT_PTYPE_shift)	|
+								 (POLYMODE_PTYPE__TRIANGLES << POLYMODE_BACK_PTYPE_shift)));
+    set_context_reg(pScrn, accel_state->ib, DB_SHADER_CONTROL, ((1 << Z_ORDER_shift)		| /* EARLY_Z_THEN_LATE_Z */
 								DUAL_EXPORT_ENABLE_bit)); /* Only useful if no depth export */
 
     /* Interpolator setup */
     /* export tex coords from VS */
-    EREG(accel_state->ib, SPI_VS_OUT_CONFIG, ((1 - 1) << VS_EXPORT_COUNT_shift));
-    EREG(accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_CONFIG, ((1 - 1) << VS_EXPORT_COUNT_shift));
+    set_context_reg(pScrn, accel_state->ib, SPI_VS_OUT_ID_0, (0 << SEMANTIC_0_shift));
 
     /* Enabling flat shading needs both FLAT_SHADE_bit in SPI_PS_INPUT_CNTL_x
      * *and* FLAT_SHADE_ENA_bit in SPI_INTERP_CONTROL_0 */
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_0,                 ((1 << NUM_INTERP_shift)));
-    EREG(accel_state->ib, SPI_PS_IN_CONTROL_1,                 0);
-    EREG(accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2),       ((0    << SEMANTIC_shift)	|
-								(0x03 << DEFAULT_VAL_shift)	|
-								SEL_CENTROID_bit));
-    EREG(accel_state->ib, SPI_INTERP_CONTROL_0,                0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_0, ((1 << NUM_INTERP_shift)));
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_IN_CONTROL_1, 0);
+    set_context_reg(pScrn, accel_state->ib, SPI_PS_INPUT_CNTL_0 + (0 <<2), ((0    << SEMANTIC_shift)	|
+									    (0x03 << DEFAULT_VAL_shift)	|
+									    SEL_CENTROID_bit));
+    set_context_reg(pScrn, accel_state->ib, SPI_INTERP_CONTROL_0, 0);
 
     if (exaGetPixmapOffset(pPixmap) == 0)
 	wait_vline_range(
@@ -509,15 +515,14 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
 	int dstX, dstY, dstw, dsth;
 	float *vb;
 
-	if (((accel_state->vb_index + 3) * 16) > (accel_state->ib->total / 2)) {
+	if (!R600VBFits(pScrn, 16, 3)) {
 	    R600DoneTexturedVideo(pScrn);
-	    accel_state->vb_index = 0;
-	    accel_state->ib = RHDDRMCPBuffer(pScrn->scrnIndex);
+	    if (!R600VBNext(pScrn))
+		break;
+	    RHDProfResume(pScrn);
 	}
 
-	vb = (pointer)((char*)accel_state->ib->address +
-		       (accel_state->ib->total / 2) +
-		       accel_state->vb_index * 16);
+	vb = R600VBPointer(pScrn, 16);
 
 	dstX = pBox->x1 + dstxoff;
 	dstY = pBox->y1 + dstyoff;
@@ -553,6 +558,8 @@ R600DisplayTexturedVideo(ScrnInfoPtr pScrn, struct RHDPortPriv *pPriv)
     }
 
     R600DoneTexturedVideo(pScrn);
+    /* get the frame out now, instead of waiting for the block handler */
+    R600IBFlush(pScrn);
 
     DamageDamageRegion(pPriv->pDraw, &pPriv->clip);
 }
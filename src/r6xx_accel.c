@@ -65,9 +65,6 @@
 void R600CPFlushIndirect(ScrnInfoPtr pScrn, drmBufPtr ib)
 {
     drmBufPtr          buffer = ib;
-    int                start  = 0;
-    drm_radeon_indirect_t  indirect;
-    int drmFD = RHDDRMFDGet(pScrn->scrnIndex);
 
     if (!buffer) return;
 
@@ -75,24 +72,298 @@ void R600CPFlushIndirect(ScrnInfoPtr pScrn, drmBufPtr ib)
         E32(buffer, CP_PACKET2()); /* fill up to multiple of 16 dwords */
     }
 
-    indirect.idx     = buffer->idx;
-    indirect.start   = start;
-    indirect.end     = buffer->used;
-    indirect.discard = 1;
-
-    drmCommandWriteRead(drmFD, DRM_RADEON_INDIRECT,
-			&indirect, sizeof(drm_radeon_indirect_t));
-
+    RHDCSIBSubmit(RHDPTR(pScrn)->CS, buffer);
 }
 
 void R600IBDiscard(ScrnInfoPtr pScrn, drmBufPtr ib)
 {
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+
     if (!ib) return;
 
+    /* whatever state was queued up in here never reaches the engine */
+    if (ib->used && rhdPtr->TwoDPrivate)
+	((struct r6xx_accel_state *) rhdPtr->TwoDPrivate)->XHas3DEngineState = FALSE;
+
     ib->used = 0;
     R600CPFlushIndirect(pScrn, ib);
 }
 
+/*
+ * Commands go into the IB, vertices into a buffer of their own which is
+ * streamed through: each draw takes the next stretch of it. Consecutive
+ * operations keep appending to the same IB, so it only gets sent off when it
+ * runs full, or when someone needs the results (R600IBFlush).
+ *
+ * A full vertex buffer gets retired, but it can only be handed back to the
+ * kernel after the IB which draws from it, which is when the kernel ages it.
+ */
+#define R600_IB_CMD_RESERVE   4096 /* more than what one operation sets up */
+#define R600_IB_DRAW_RESERVE  1024 /* a draw and the syncs around it */
+#define R600_VB_RESERVE        256 /* a handful of rects at least */
+
+static void
+R600VBRetire(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (!accel_state->vb)
+	return;
+
+    if (accel_state->vb_retired_count == R600_VB_RETIRED_MAX)
+	R600IBFlush(pScrn);
+
+    accel_state->vb_retired[accel_state->vb_retired_count++] = accel_state->vb;
+    accel_state->vb = NULL;
+    accel_state->vb_offset = 0;
+    accel_state->vb_index = 0;
+}
+
+/*
+ * Either buffer can be unavailable, then the operation cannot be done and
+ * it is up to the caller to fall back. Vertices appended regardless are
+ * dropped until the next R600IBStart().
+ */
+Bool
+R600IBStart(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    struct RhdCS *CS = RHDPTR(pScrn)->CS;
+
+    if (accel_state->vb &&
+	((accel_state->vb_offset + R600_VB_RESERVE) > accel_state->vb->total))
+	R600VBRetire(pScrn);
+
+    if (accel_state->ib &&
+	((accel_state->ib->used + R600_IB_CMD_RESERVE) > accel_state->ib->total))
+	R600IBFlush(pScrn);
+
+    if (!accel_state->ib)
+	accel_state->ib = RHDCSIBGet(CS);
+
+    if (!accel_state->vb) {
+	accel_state->vb = RHDCSIBGet(CS);
+	accel_state->vb_offset = 0;
+    }
+
+    accel_state->vb_index = 0;
+
+    accel_state->ib_failed = !accel_state->ib || !accel_state->vb;
+    return !accel_state->ib_failed;
+}
+
+/* Operation done: its vertices stay where they are, the next one goes after. */
+void
+R600IBFinish(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    accel_state->vb_offset += (accel_state->vb_size + 15) & ~15;
+    accel_state->vb_index = 0;
+}
+
+void
+R600IBFlush(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    drmBufPtr vb;
+
+    if (!accel_state)
+	return;
+
+    if (accel_state->ib) {
+	R600CPFlushIndirect(pScrn, accel_state->ib);
+	accel_state->ib = NULL;
+    }
+
+    while (accel_state->vb_retired_count) {
+	vb = accel_state->vb_retired[--accel_state->vb_retired_count];
+	vb->used = 0;
+	R600CPFlushIndirect(pScrn, vb);
+    }
+}
+
+/*
+ * UTS/DFS go through a ring of staging buffers which are kept around. Each
+ * remembers the fence of the last blit using it, so the CPU can fill or
+ * drain one while the engine is still busy with the others.
+ *
+ * When no buffer can be had for the next slot, the ring shrinks to the
+ * buffers it already has, and NULL is returned. The caller can then call
+ * again, to wait for the oldest of those, once it is done with what it
+ * still holds. NULL with staging_count 0 means there is nothing to wait for.
+ */
+drmBufPtr
+R600StagingGet(ScrnInfoPtr pScrn, int *Slot)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    int i = accel_state->staging_next;
+
+    if (!accel_state->staging_count)
+	return NULL;
+
+    if (!accel_state->staging[i].Buffer) {
+	accel_state->staging[i].Buffer = RHDCSIBGet(RHDPTR(pScrn)->CS);
+	if (!accel_state->staging[i].Buffer) {
+	    accel_state->staging_count = i;
+	    accel_state->staging_next = 0;
+	    return NULL;
+	}
+    } else
+	R600StagingWait(pScrn, i);
+
+    accel_state->staging_next = (i + 1) % accel_state->staging_count;
+
+    *Slot = i;
+    return accel_state->staging[i].Buffer;
+}
+
+/* Wait for the blit which last used this staging buffer. */
+void
+R600StagingWait(ScrnInfoPtr pScrn, int Slot)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (accel_state->staging[Slot].Busy) {
+	RHDCSFenceWait(RHDPTR(pScrn)->CS, accel_state->staging[Slot].Fence);
+	accel_state->staging[Slot].Busy = FALSE;
+    }
+}
+
+/* The blit using this staging buffer is queued: send it off and fence it. */
+void
+R600StagingQueued(ScrnInfoPtr pScrn, int Slot)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    R600IBFlush(pScrn);
+
+    accel_state->staging[Slot].Fence = RHDCSFenceEmit(RHDPTR(pScrn)->CS);
+    accel_state->staging[Slot].Busy = TRUE;
+}
+
+/* GPU address of a staging buffer. */
+uint64_t
+R600StagingAddress(ScrnInfoPtr pScrn, drmBufPtr Buffer)
+{
+    return RHDDRIGetIntGARTLocation(pScrn) + (Buffer->idx * Buffer->total);
+}
+
+/* The kernel ages these once everything submitted before has passed. */
+static void
+R600StagingRelease(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    drmBufPtr Buffer;
+    int i;
+
+    for (i = 0; i < R600_STAGING_SLOTS; i++) {
+	Buffer = accel_state->staging[i].Buffer;
+	if (!Buffer)
+	    continue;
+
+	Buffer->used = 0;
+	R600CPFlushIndirect(pScrn, Buffer);
+
+	accel_state->staging[i].Buffer = NULL;
+	accel_state->staging[i].Busy = FALSE;
+    }
+
+    /* maybe more buffers can be had next time */
+    accel_state->staging_next = 0;
+    accel_state->staging_count = R600_STAGING_SLOTS;
+}
+
+/* Flush, and hand the other buffers back too: the kernel might reset. */
+void
+R600IBRelease(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (!accel_state)
+	return;
+
+    R600VBRetire(pScrn);
+    R600IBFlush(pScrn);
+    R600StagingRelease(pScrn);
+}
+
+/*
+ * Make sure there is room for another draw in this IB. When there isn't,
+ * continue in a fresh one, with the state as it was.
+ */
+Bool
+R600IBReserveDraw(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (accel_state->ib &&
+	((accel_state->ib->used + R600_IB_DRAW_RESERVE) > accel_state->ib->total))
+	R600IBFlush(pScrn);
+
+    if (!accel_state->ib)
+	accel_state->ib = RHDCSIBGet(RHDPTR(pScrn)->CS);
+
+    return accel_state->ib != NULL;
+}
+
+/* Is there room for Count more vertices of Size bytes in this draw? */
+Bool
+R600VBFits(ScrnInfoPtr pScrn, int Size, int Count)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    if (!accel_state->vb || accel_state->ib_failed)
+	return FALSE;
+
+    return (accel_state->vb_offset + (accel_state->vb_index + Count) * Size) <=
+	accel_state->vb->total;
+}
+
+/*
+ * The vertex buffer is full: the caller has drawn what it had, now continue
+ * in a fresh one, in the same IB and with the state as it was. When this
+ * fails, the caller drops its vertices, and R600VBFits() keeps failing
+ * until a buffer turns up again.
+ */
+Bool
+R600VBNext(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    struct RhdCS *CS = RHDPTR(pScrn)->CS;
+
+    if (accel_state->ib_failed)
+	return FALSE;
+
+    R600VBRetire(pScrn);
+    if (!R600IBReserveDraw(pScrn))
+	return FALSE;
+
+    accel_state->vb = RHDCSIBGet(CS);
+
+    return accel_state->vb != NULL;
+}
+
+/* Where vertex number vb_index of Size bytes goes. */
+pointer
+R600VBPointer(ScrnInfoPtr pScrn, int Size)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    return (char *) accel_state->vb->address + accel_state->vb_offset +
+	accel_state->vb_index * Size;
+}
+
+/* GPU address of the first vertex of the current draw. */
+uint64_t
+R600VBAddress(ScrnInfoPtr pScrn)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+
+    return RHDDRIGetIntGARTLocation(pScrn) +
+	(accel_state->vb->idx * accel_state->vb->total) + accel_state->vb_offset;
+}
+
 void
 wait_3d_idle_clean(ScrnInfoPtr pScrn, drmBufPtr ib)
 {
@@ -111,6 +382,30 @@ wait_3d_idle(ScrnInfoPtr pScrn, drmBufPtr ib)
     EREG(ib, WAIT_UNTIL,                          WAIT_3D_IDLE_bit);
 }
 
+/* For RHDProfGPUInit(): written once all that came before has left the pipe. */
+Bool
+R600ProfWrite(ScrnInfoPtr pScrn, CARD64 Address, Bool Timestamp, CARD32 Value)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    drmBufPtr ib;
+
+    if (!accel_state->ib)
+	accel_state->ib = RHDCSIBGet(RHDPTR(pScrn)->CS);
+    ib = accel_state->ib;
+    if (!ib)
+	return FALSE;
+
+    PACK3(ib, IT_EVENT_WRITE_EOP, 5);
+    E32(ib, BOTTOM_OF_PIPE_TS | EOP_EVENT_INDEX);
+    E32(ib, Address & 0xffffffff);
+    E32(ib, ((Address >> 32) & 0xff) |
+	(Timestamp ? EOP_DATA_SEL_COUNTER : EOP_DATA_SEL_32));
+    E32(ib, Value);
+    E32(ib, 0);
+
+    return TRUE;
+}
+
 /* 
  * inserts a wait for vline in the command stream 
  */
@@ -228,6 +523,10 @@ void
 start_3d(ScrnInfoPtr pScrn, drmBufPtr ib)
 {
     RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct r6xx_accel_state *accel_state = rhdPtr->TwoDPrivate;
+
+    /* someone else is about to set up the engine */
+    accel_state->solid_valid = FALSE;
 
     if (rhdPtr->ChipSet < RHD_RV770) {
 	PACK3(ib, IT_START_3D_CMDBUF, 1);
@@ -344,16 +643,16 @@ set_render_target(ScrnInfoPtr pScrn, drmBufPtr ib, cb_config_t *cb_conf)
 	E32(ib, (2 << cb_conf->id));
     }
 
-    /* pitch only for ARRAY_LINEAR_GENERAL, other tiling modes require addrlib */
-    EREG(ib, (CB_COLOR0_SIZE + (4 * cb_conf->id)), ((pitch << PITCH_TILE_MAX_shift)	|
-						    (slice << SLICE_TILE_MAX_shift)));
-    EREG(ib, (CB_COLOR0_VIEW + (4 * cb_conf->id)), ((0    << SLICE_START_shift)		|
-						    (0    << SLICE_MAX_shift)));
-    EREG(ib, (CB_COLOR0_INFO + (4 * cb_conf->id)), cb_color_info);
-    EREG(ib, (CB_COLOR0_TILE + (4 * cb_conf->id)), (0     >> 8));	/* CMASK per-tile data base/256 */
-    EREG(ib, (CB_COLOR0_FRAG + (4 * cb_conf->id)), (0     >> 8));	/* FMASK per-tile data base/256 */
-    EREG(ib, (CB_COLOR0_MASK + (4 * cb_conf->id)), ((0    << CMASK_BLOCK_MAX_shift)	|
-						    (0    << FMASK_TILE_MAX_shift)));
+    /* pitch only for ARRAY_LINEAR_GENERAL and ARRAY_1D_TILED_THIN1, 2D tiling requires addrlib */
+    set_context_reg(pScrn, ib, (CB_COLOR0_SIZE + (4 * cb_conf->id)), ((pitch << PITCH_TILE_MAX_shift)	|
+								      (slice << SLICE_TILE_MAX_shift)));
+    set_context_reg(pScrn, ib, (CB_COLOR0_VIEW + (4 * cb_conf->id)), ((0    << SLICE_START_shift)		|
+								      (0    << SLICE_MAX_shift)));
+    set_context_reg(pScrn, ib, (CB_COLOR0_INFO + (4 * cb_conf->id)), cb_color_info);
+    set_context_reg(pScrn, ib, (CB_COLOR0_TILE + (4 * cb_conf->id)), (0     >> 8));	/* CMASK per-tile data base/256 */
+    set_context_reg(pScrn, ib, (CB_COLOR0_FRAG + (4 * cb_conf->id)), (0     >> 8));	/* FMASK per-tile data base/256 */
+    set_context_reg(pScrn, ib, (CB_COLOR0_MASK + (4 * cb_conf->id)), ((0    << CMASK_BLOCK_MAX_shift)	|
+								      (0    << FMASK_TILE_MAX_shift)));
 }
 
 void
@@ -383,9 +682,9 @@ fs_setup(ScrnInfoPtr pScrn, drmBufPtr ib, shader_config_t *fs_conf)
     if (fs_conf->dx10_clamp)
 	sq_pgm_resources |= SQ_PGM_RESOURCES_FS__DX10_CLAMP_bit;
 
-    EREG(ib, SQ_PGM_START_FS, fs_conf->shader_addr >> 8);
-    EREG(ib, SQ_PGM_RESOURCES_FS, sq_pgm_resources);
-    EREG(ib, SQ_PGM_CF_OFFSET_FS, 0);
+    set_context_reg(pScrn, ib, SQ_PGM_START_FS, fs_conf->shader_addr >> 8);
+    set_context_reg(pScrn, ib, SQ_PGM_RESOURCES_FS, sq_pgm_resources);
+    set_context_reg(pScrn, ib, SQ_PGM_CF_OFFSET_FS, 0);
 }
 
 void
@@ -403,9 +702,9 @@ vs_setup(ScrnInfoPtr pScrn, drmBufPtr ib, shader_config_t *vs_conf)
     if (vs_conf->uncached_first_inst)
 	sq_pgm_resources |= UNCACHED_FIRST_INST_bit;
 
-    EREG(ib, SQ_PGM_START_VS, vs_conf->shader_addr >> 8);
-    EREG(ib, SQ_PGM_RESOURCES_VS, sq_pgm_resources);
-    EREG(ib, SQ_PGM_CF_OFFSET_VS, 0);
+    set_context_reg(pScrn, ib, SQ_PGM_START_VS, vs_conf->shader_addr >> 8);
+    set_context_reg(pScrn, ib, SQ_PGM_RESOURCES_VS, sq_pgm_resources);
+    set_context_reg(pScrn, ib, SQ_PGM_CF_OFFSET_VS, 0);
 }
 
 void
@@ -425,10 +724,10 @@ ps_setup(ScrnInfoPtr pScrn, drmBufPtr ib, shader_config_t *ps_conf)
     if (ps_conf->clamp_consts)
 	sq_pgm_resources |= CLAMP_CONSTS_bit;
 
-    EREG(ib, SQ_PGM_START_PS, ps_conf->shader_addr >> 8);
-    EREG(ib, SQ_PGM_RESOURCES_PS, sq_pgm_resources);
-    EREG(ib, SQ_PGM_EXPORTS_PS, ps_conf->export_mode);
-    EREG(ib, SQ_PGM_CF_OFFSET_PS, 0);
+    set_context_reg(pScrn, ib, SQ_PGM_START_PS, ps_conf->shader_addr >> 8);
+    set_context_reg(pScrn, ib, SQ_PGM_RESOURCES_PS, sq_pgm_resources);
+    set_context_reg(pScrn, ib, SQ_PGM_EXPORTS_PS, ps_conf->export_mode);
+    set_context_reg(pScrn, ib, SQ_PGM_CF_OFFSET_PS, 0);
 }
 
 void
@@ -595,53 +894,83 @@ void
 set_screen_scissor(ScrnInfoPtr pScrn, drmBufPtr ib, int x1, int y1, int x2, int y2)
 {
 
-    EREG(ib, PA_SC_SCREEN_SCISSOR_TL,              ((x1 << PA_SC_SCREEN_SCISSOR_TL__TL_X_shift) |
-						    (y1 << PA_SC_SCREEN_SCISSOR_TL__TL_Y_shift)));
-    EREG(ib, PA_SC_SCREEN_SCISSOR_BR,              ((x2 << PA_SC_SCREEN_SCISSOR_BR__BR_X_shift) |
-						    (y2 << PA_SC_SCREEN_SCISSOR_BR__BR_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_SCREEN_SCISSOR_TL, ((x1 << PA_SC_SCREEN_SCISSOR_TL__TL_X_shift) |
+							 (y1 << PA_SC_SCREEN_SCISSOR_TL__TL_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_SCREEN_SCISSOR_BR, ((x2 << PA_SC_SCREEN_SCISSOR_BR__BR_X_shift) |
+							 (y2 << PA_SC_SCREEN_SCISSOR_BR__BR_Y_shift)));
 }
 
 void
 set_vport_scissor(ScrnInfoPtr pScrn, drmBufPtr ib, int id, int x1, int y1, int x2, int y2)
 {
-    EREG(ib, PA_SC_VPORT_SCISSOR_0_TL +
-	 id * PA_SC_VPORT_SCISSOR_0_TL_offset, ((x1 << PA_SC_VPORT_SCISSOR_0_TL__TL_X_shift) |
-						(y1 << PA_SC_VPORT_SCISSOR_0_TL__TL_Y_shift) |
-						WINDOW_OFFSET_DISABLE_bit));
-    EREG(ib, PA_SC_VPORT_SCISSOR_0_BR +
-	 id * PA_SC_VPORT_SCISSOR_0_BR_offset, ((x2 << PA_SC_VPORT_SCISSOR_0_BR__BR_X_shift) |
-						(y2 << PA_SC_VPORT_SCISSOR_0_BR__BR_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_VPORT_SCISSOR_0_TL +
+			   id * PA_SC_VPORT_SCISSOR_0_TL_offset, ((x1 << PA_SC_VPORT_SCISSOR_0_TL__TL_X_shift) |
+								  (y1 << PA_SC_VPORT_SCISSOR_0_TL__TL_Y_shift) |
+								  WINDOW_OFFSET_DISABLE_bit));
+    set_context_reg(pScrn, ib, PA_SC_VPORT_SCISSOR_0_BR +
+			   id * PA_SC_VPORT_SCISSOR_0_BR_offset, ((x2 << PA_SC_VPORT_SCISSOR_0_BR__BR_X_shift) |
+								  (y2 << PA_SC_VPORT_SCISSOR_0_BR__BR_Y_shift)));
 }
 
 void
 set_generic_scissor(ScrnInfoPtr pScrn, drmBufPtr ib, int x1, int y1, int x2, int y2)
 {
-    EREG(ib, PA_SC_GENERIC_SCISSOR_TL,            ((x1 << PA_SC_GENERIC_SCISSOR_TL__TL_X_shift) |
-						   (y1 << PA_SC_GENERIC_SCISSOR_TL__TL_Y_shift) |
-						   WINDOW_OFFSET_DISABLE_bit));
-    EREG(ib, PA_SC_GENERIC_SCISSOR_BR,            ((x2 << PA_SC_GENERIC_SCISSOR_BR__BR_X_shift) |
-						   (y2 << PA_SC_GENERIC_SCISSOR_TL__TL_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_GENERIC_SCISSOR_TL, ((x1 << PA_SC_GENERIC_SCISSOR_TL__TL_X_shift) |
+							  (y1 << PA_SC_GENERIC_SCISSOR_TL__TL_Y_shift) |
+							  WINDOW_OFFSET_DISABLE_bit));
+    set_context_reg(pScrn, ib, PA_SC_GENERIC_SCISSOR_BR, ((x2 << PA_SC_GENERIC_SCISSOR_BR__BR_X_shift) |
+							  (y2 << PA_SC_GENERIC_SCISSOR_TL__TL_Y_shift)));
 }
 
 void
 set_window_scissor(ScrnInfoPtr pScrn, drmBufPtr ib, int x1, int y1, int x2, int y2)
 {
-    EREG(ib, PA_SC_WINDOW_SCISSOR_TL,             ((x1 << PA_SC_WINDOW_SCISSOR_TL__TL_X_shift) |
-						   (y1 << PA_SC_WINDOW_SCISSOR_TL__TL_Y_shift) |
-						   WINDOW_OFFSET_DISABLE_bit));
-    EREG(ib, PA_SC_WINDOW_SCISSOR_BR,             ((x2 << PA_SC_WINDOW_SCISSOR_BR__BR_X_shift) |
-						   (y2 << PA_SC_WINDOW_SCISSOR_BR__BR_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_WINDOW_SCISSOR_TL, ((x1 << PA_SC_WINDOW_SCISSOR_TL__TL_X_shift) |
+							 (y1 << PA_SC_WINDOW_SCISSOR_TL__TL_Y_shift) |
+							 WINDOW_OFFSET_DISABLE_bit));
+    set_context_reg(pScrn, ib, PA_SC_WINDOW_SCISSOR_BR, ((x2 << PA_SC_WINDOW_SCISSOR_BR__BR_X_shift) |
+							 (y2 << PA_SC_WINDOW_SCISSOR_BR__BR_Y_shift)));
 }
 
 void
 set_clip_rect(ScrnInfoPtr pScrn, drmBufPtr ib, int id, int x1, int y1, int x2, int y2)
 {
-    EREG(ib, PA_SC_CLIPRECT_0_TL +
-	 id * PA_SC_CLIPRECT_0_TL_offset,     ((x1 << PA_SC_CLIPRECT_0_TL__TL_X_shift) |
-					       (y1 << PA_SC_CLIPRECT_0_TL__TL_Y_shift)));
-    EREG(ib, PA_SC_CLIPRECT_0_BR +
-	 id * PA_SC_CLIPRECT_0_BR_offset,     ((x2 << PA_SC_CLIPRECT_0_BR__BR_X_shift) |
-					       (y2 << PA_SC_CLIPRECT_0_BR__BR_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_CLIPRECT_0_TL +
+			   id * PA_SC_CLIPRECT_0_TL_offset,     ((x1 << PA_SC_CLIPRECT_0_TL__TL_X_shift) |
+								 (y1 << PA_SC_CLIPRECT_0_TL__TL_Y_shift)));
+    set_context_reg(pScrn, ib, PA_SC_CLIPRECT_0_BR +
+			   id * PA_SC_CLIPRECT_0_BR_offset,     ((x2 << PA_SC_CLIPRECT_0_BR__BR_X_shift) |
+								 (y2 << PA_SC_CLIPRECT_0_BR__BR_Y_shift)));
+}
+
+/*
+ * Context registers are shadowed in the accel state, so that values which stay
+ * the same from one operation to the next are only sent to the CP once. The
+ * shadow is only trusted while XHas3DEngineState is set, everything that drops
+ * that (VT switch, engine reset, DRI, discarded IBs) also drops the shadow.
+ */
+void
+set_context_reg(ScrnInfoPtr pScrn, drmBufPtr ib, uint32_t reg, uint32_t val)
+{
+    struct r6xx_accel_state *accel_state = RHDPTR(pScrn)->TwoDPrivate;
+    uint32_t index, bit;
+
+    if ((reg < SET_CONTEXT_REG_offset) || (reg >= SET_CONTEXT_REG_end) ||
+	!accel_state || !accel_state->XHas3DEngineState) {
+	EREG(ib, reg, val);
+	return;
+    }
+
+    index = (reg - SET_CONTEXT_REG_offset) >> 2;
+    bit = 1 << (index & 31);
+
+    if ((accel_state->context_reg_valid[index >> 5] & bit) &&
+	(accel_state->context_reg[index] == val))
+	return;
+
+    EREG(ib, reg, val);
+    accel_state->context_reg[index] = val;
+    accel_state->context_reg_valid[index >> 5] |= bit;
 }
 
 /*
@@ -668,6 +997,8 @@ set_default_state(ScrnInfoPtr pScrn, drmBufPtr ib)
 #endif
 
     accel_state->XHas3DEngineState = TRUE;
+    /* nothing is known about the context registers until the below is done */
+    memset(accel_state->context_reg_valid, 0, sizeof(accel_state->context_reg_valid));
 
     wait_3d_idle(pScrn, ib);
 
@@ -11,6 +11,7 @@
 Bool R6xxEXAInit(ScrnInfoPtr pScrn, ScreenPtr pScreen);
 void R6xxEXACloseScreen(ScreenPtr pScreen);
 void R6xxEXADestroy(ScrnInfoPtr pScrn);
+int R600PixmapArrayMode(PixmapPtr pPix);
 
 void R6xxCacheFlush(struct RhdCS *CS);
 void R6xxEngineWaitIdleFull(struct RhdCS *CS);
@@ -25,17 +26,65 @@ RADEONGetDrawablePixmap(DrawablePtr pDrawable);
 void
 R6xxIdle(ScrnInfoPtr pScrn);
 
+Bool
+R600IBStart(ScrnInfoPtr pScrn);
+void
+R600IBFinish(ScrnInfoPtr pScrn);
+void
+R600IBFlush(ScrnInfoPtr pScrn);
+void
+R600IBRelease(ScrnInfoPtr pScrn);
+Bool
+R600IBReserveDraw(ScrnInfoPtr pScrn);
+Bool
+R600VBFits(ScrnInfoPtr pScrn, int Size, int Count);
+Bool
+R600VBNext(ScrnInfoPtr pScrn);
+pointer
+R600VBPointer(ScrnInfoPtr pScrn, int Size);
+uint64_t
+R600VBAddress(ScrnInfoPtr pScrn);
+drmBufPtr
+R600StagingGet(ScrnInfoPtr pScrn, int *Slot);
+void
+R600StagingWait(ScrnInfoPtr pScrn, int Slot);
+void
+R600StagingQueued(ScrnInfoPtr pScrn, int Slot);
+uint64_t
+R600StagingAddress(ScrnInfoPtr pScrn, drmBufPtr Buffer);
+Bool
+R600ProfWrite(ScrnInfoPtr pScrn, CARD64 Address, Bool Timestamp, CARD32 Value);
+
 Bool
 R600LoadShaders(ScrnInfoPtr pScrn);
 
+/* SET_CONTEXT_REG_offset to SET_CONTEXT_REG_end, in dwords */
+#define R6XX_CONTEXT_REG_COUNT (0x1000 >> 2)
+
 struct r6xx_accel_state {
     Bool XHas3DEngineState;
 
+    /* what the context registers were last set to, see set_context_reg() */
+    uint32_t          context_reg[R6XX_CONTEXT_REG_COUNT];
+    uint32_t          context_reg_valid[R6XX_CONTEXT_REG_COUNT / 32];
+
     int               exaSyncMarker;
     int               exaMarkerSynced;
 
+    /* IB is kept around over several operations, see R600IBStart() */
     drmBufPtr         ib;
+    Bool              ib_failed; /* state not set up, draw nothing */
+
+    /* vertices are streamed through a buffer of their own */
+#define R600_VB_RETIRED_MAX 8
+    drmBufPtr         vb;
     int               vb_index;
+    uint32_t          vb_offset;
+    Bool              vtx_packed; /* solid/copy: 16bit integer vertices */
+    drmBufPtr         vb_retired[R600_VB_RETIRED_MAX];
+    int               vb_retired_count;
+
+    BlockHandlerProcPtr BlockHandler;
 
     /* shader storage */
     ExaOffscreenArea  *shaders;
@@ -48,6 +97,10 @@ struct r6xx_accel_state {
     uint32_t          comp_mask_ps_offset;
     uint32_t          xv_vs_offset;
     uint32_t          xv_ps_offset;
+    uint32_t          solid_packed_vs_offset;
+    uint32_t          copy_packed_vs_offset;
+    uint32_t          comp_solid_src_ps_offset;
+    uint32_t          comp_solid_mask_ps_offset;
 
     /*size/addr stuff */
     uint32_t          src_size[2];
@@ -68,22 +121,46 @@ struct r6xx_accel_state {
     uint32_t          vb_size;
     uint64_t          vb_mc_addr;
 
-    /* UTS/DFS */
-    drmBufPtr         scratch;
+    /* UTS/DFS staging buffers, see R600StagingGet() */
+#define R600_STAGING_SLOTS 4
+    struct {
+	drmBufPtr     Buffer;
+	Bool          Busy; /* a blit still uses it, until Fence */
+	CARD32        Fence;
+    }                 staging[R600_STAGING_SLOTS];
+    int               staging_next;
+    int               staging_count; /* slots in the ring, filled from 0 up */
+
+    /* offscreen pixmaps may be tiled, see R600PixmapArrayMode() */
+    Bool              tiling;
 
     /* copy */
     ExaOffscreenArea  *copy_area;
+
+    /* engine timestamps, see RHDProfGPUInit() */
+    ExaOffscreenArea  *prof_area;
+
+    /* text, see R600Glyphs() */
+    struct R600GlyphCache *glyph_cache;
+
+    /* the engine is still set up for this fill, see R600PrepareSolid() */
+    Bool              solid_valid;
+    int               solid_alu;
+    uint32_t          solid_pm;
+
     Bool              same_surface;
     int               rop;
     uint32_t          planemask;
+    /* dst and src extents of the rects drawn since the last wait, see R600CopyRect() */
+    Bool              copy_dirty;
+    int               copy_x1, copy_y1, copy_x2, copy_y2;
+    int               copy_sx1, copy_sy1, copy_sx2, copy_sy2;
 
     /*comp */
-    unsigned short texW[2];
-    unsigned short texH[2];
-    Bool is_transform[2];
-    struct pixman_transform *transform[2];
     Bool has_mask;
     Bool component_alpha;
     Bool src_alpha;
+    Bool src_solid; /* src/mask colour in the PS constants, see R600PrepareComposite() */
+    Bool mask_solid;
 };
 
@@ -62,6 +62,9 @@
 
 #endif
 
+#define PROF_BEGIN(pScreen, op, format)
+#define PROF_END(pScreen)
+
 #else /* IS_RADEON_DRIVER */
 
 #ifdef HAVE_CONFIG_H
@@ -72,6 +75,7 @@
 
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_prof.h"
 
 #include "r5xx_regs.h"
 #include "r5xx_accel.h"
@@ -159,6 +163,10 @@ F_TO_DW(float val)
 #define RADEON_SWITCH_TO_3D() R5xxEngineWaitIdle2D(rhdPtr->CS)
 #define RADEONInit3DEngine(x) R5xx3DSetup(rhdPtr->scrnIndex)
 
+#define PROF_BEGIN(pScreen, op, format) \
+    RHDProfBegin(xf86Screens[(pScreen)->myNum], RHD_PROF_COMPOSITE, (op), (format))
+#define PROF_END(pScreen) RHDProfEnd(xf86Screens[(pScreen)->myNum])
+
 #endif /* IS_RADEON_DRIVER */
 
 /* Only include the following (generic) bits once. */
@@ -1067,7 +1075,6 @@ static Bool R300CheckCompositeTexture(PicturePtr pPict,
 {
     int w = pPict->pDrawable->width;
     int h = pPict->pDrawable->height;
-    unsigned int i;
     int max_tex_w, max_tex_h;
 
     if (is_r500) {
@@ -1081,6 +1088,20 @@ static Bool R300CheckCompositeTexture(PicturePtr pPict,
     if ((w > max_tex_w) || (h > max_tex_h))
 	RADEON_FALLBACK(("Picture w/h too large (%dx%d)\n", w, h));
 
+    if (!RADEONCheckTexturePOT(pPict, unit == 0))
+	return FALSE;
+
+    return TRUE;
+}
+
+/* The parts of the texture checks which only depend on formats and flags. */
+static Bool R300CheckCompositeTextureFormat(PicturePtr pPict,
+					    PicturePtr pDstPict,
+					    int op,
+					    uint32_t *card_fmt)
+{
+    unsigned int i;
+
     for (i = 0; i < sizeof(R300TexFormats) / sizeof(R300TexFormats[0]); i++)
     {
 	if (R300TexFormats[i].fmt == pPict->format)
@@ -1090,9 +1111,6 @@ static Bool R300CheckCompositeTexture(PicturePtr pPict,
 	RADEON_FALLBACK(("Unsupported picture format 0x%x\n",
 			 (int)pPict->format));
 
-    if (!RADEONCheckTexturePOT(pPict, unit == 0))
-	return FALSE;
-
     if (pPict->filter != PictFilterNearest &&
 	pPict->filter != PictFilterBilinear)
 	RADEON_FALLBACK(("Unsupported filter 0x%x\n", pPict->filter));
@@ -1115,20 +1133,360 @@ static Bool R300CheckCompositeTexture(PicturePtr pPict,
 	RADEON_FALLBACK(("Unsupported repeat type %d\n", pPict->repeat));
     }
 
+    *card_fmt = R300TexFormats[i].card_fmt;
+
+    return TRUE;
+}
+
+/*
+ * Composite state cache.
+ *
+ * Whether an operation is supported, and the formats, blend control and
+ * shader swizzles for it, only depend on the op, the picture formats and a
+ * few flags. Only a handful of those combinations are in use at any time,
+ * so they are worked out once and then looked up.
+ */
+#define RADEON_COMP_CACHE_SIZE 32 /* power of two */
+
+#define RADEON_COMP_MASK           0x01
+#define RADEON_COMP_MASK_CA        0x02
+#define RADEON_COMP_SRC_TRANSFORM  0x04
+#define RADEON_COMP_MASK_TRANSFORM 0x08
+#define RADEON_COMP_R500           0x10
+
+struct RadeonCompositeKey {
+    int op;
+    unsigned int src_format;
+    unsigned int mask_format;
+    unsigned int dst_format;
+    int src_filter;
+    int mask_filter;
+    int src_repeat; /* repeatType + 1, 0 when not repeating */
+    int mask_repeat;
+    unsigned int flags;
+};
+
+struct RadeonCompositeState {
+    struct RadeonCompositeKey Key;
+    Bool Valid;
+
+    Bool Supported;
+    uint32_t dst_format;
+    uint32_t blend_cntl;
+    uint32_t tex_format[2];
+
+    /* pixel shader swizzles */
+    uint32_t src_color;
+    uint32_t src_alpha;
+    uint32_t mask_color;
+    uint32_t mask_alpha;
+    uint32_t output_fmt;
+};
+
+static struct RadeonCompositeState RadeonCompositeCache[RADEON_COMP_CACHE_SIZE];
+
+/*
+ *
+ */
+static Bool R300CompositeStateFill(struct RadeonCompositeState *State, int op,
+				   PicturePtr pSrcPicture, PicturePtr pMaskPicture,
+				   PicturePtr pDstPicture, Bool is_r500)
+{
+    uint32_t output_fmt;
+    uint32_t src_color, src_alpha;
+    uint32_t mask_color, mask_alpha;
+
+    /* Check for unsupported compositing operations. */
+    if ((unsigned int)op >= sizeof(RadeonBlendOp) / sizeof(RadeonBlendOp[0]))
+	RADEON_FALLBACK(("Unsupported Composite op 0x%x\n", op));
+
+    if (pMaskPicture) {
+	if (pMaskPicture->componentAlpha) {
+	    /* Check if it's component alpha that relies on a source alpha and
+	     * on the source value.  We can only get one of those into the
+	     * single source value that we get to blend with.
+	     */
+	    if (RadeonBlendOp[op].src_alpha &&
+		(RadeonBlendOp[op].blend_cntl & RADEON_SRC_BLEND_MASK) !=
+		RADEON_SRC_BLEND_GL_ZERO) {
+		RADEON_FALLBACK(("Component alpha not supported with source "
+				 "alpha and source value blending.\n"));
+	    }
+	}
+
+	if (!R300CheckCompositeTextureFormat(pMaskPicture, pDstPicture, op,
+					     &State->tex_format[1]))
+	    return FALSE;
+    }
+
+    if (!R300CheckCompositeTextureFormat(pSrcPicture, pDstPicture, op,
+					 &State->tex_format[0]))
+	return FALSE;
+
+    if (!R300GetDestFormat(pDstPicture, &State->dst_format))
+	return FALSE;
+
+    State->blend_cntl = RADEONGetBlendCntl(op, pMaskPicture, pDstPicture->format);
+
+    if (!is_r500) {
+	if (PICT_FORMAT_RGB(pSrcPicture->format) == 0)
+	    src_color = R300_ALU_RGB_0_0;
+	else
+	    src_color = R300_ALU_RGB_SRC0_RGB;
+
+	if (PICT_FORMAT_A(pSrcPicture->format) == 0)
+	    src_alpha = R300_ALU_ALPHA_1_0;
+	else
+	    src_alpha = R300_ALU_ALPHA_SRC0_A;
+
+	if (pMaskPicture && pMaskPicture->componentAlpha) {
+	    if (RadeonBlendOp[op].src_alpha) {
+		if (PICT_FORMAT_A(pSrcPicture->format) == 0) {
+		    src_color = R300_ALU_RGB_1_0;
+		    src_alpha = R300_ALU_ALPHA_1_0;
+		} else {
+		    src_color = R300_ALU_RGB_SRC0_AAA;
+		    src_alpha = R300_ALU_ALPHA_SRC0_A;
+		}
+
+		mask_color = R300_ALU_RGB_SRC1_RGB;
+
+		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		    mask_alpha = R300_ALU_ALPHA_1_0;
+		else
+		    mask_alpha = R300_ALU_ALPHA_SRC1_A;
+
+	    } else {
+		src_color = R300_ALU_RGB_SRC0_RGB;
+
+		if (PICT_FORMAT_A(pSrcPicture->format) == 0)
+		    src_alpha = R300_ALU_ALPHA_1_0;
+		else
+		    src_alpha = R300_ALU_ALPHA_SRC0_A;
+
+		mask_color = R300_ALU_RGB_SRC1_RGB;
+
+		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		    mask_alpha = R300_ALU_ALPHA_1_0;
+		else
+		    mask_alpha = R300_ALU_ALPHA_SRC1_A;
+
+	    }
+	} else if (pMaskPicture) {
+	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		mask_color = R300_ALU_RGB_1_0;
+	    else
+		mask_color = R300_ALU_RGB_SRC1_AAA;
+
+	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		mask_alpha = R300_ALU_ALPHA_1_0;
+	    else
+		mask_alpha = R300_ALU_ALPHA_SRC1_A;
+	} else {
+	    mask_color = R300_ALU_RGB_1_0;
+	    mask_alpha = R300_ALU_ALPHA_1_0;
+	}
+
+	/* shader output swizzling */
+	switch (pDstPicture->format) {
+	case PICT_a8r8g8b8:
+	case PICT_x8r8g8b8:
+	default:
+	    output_fmt = (R300_OUT_FMT_C4_8 |
+			  R300_OUT_FMT_C0_SEL_BLUE |
+			  R300_OUT_FMT_C1_SEL_GREEN |
+			  R300_OUT_FMT_C2_SEL_RED |
+			  R300_OUT_FMT_C3_SEL_ALPHA);
+	    break;
+	case PICT_a8b8g8r8:
+	case PICT_x8b8g8r8:
+	    output_fmt = (R300_OUT_FMT_C4_8 |
+			  R300_OUT_FMT_C0_SEL_RED |
+			  R300_OUT_FMT_C1_SEL_GREEN |
+			  R300_OUT_FMT_C2_SEL_BLUE |
+			  R300_OUT_FMT_C3_SEL_ALPHA);
+	    break;
+	case PICT_a8:
+	    output_fmt = (R300_OUT_FMT_C4_8 |
+			  R300_OUT_FMT_C0_SEL_ALPHA);
+	    break;
+	}
+    } else {
+	if (PICT_FORMAT_RGB(pSrcPicture->format) == 0)
+	    src_color = (R500_ALU_RGB_R_SWIZ_A_0 |
+			 R500_ALU_RGB_G_SWIZ_A_0 |
+			 R500_ALU_RGB_B_SWIZ_A_0);
+	else
+	    src_color = (R500_ALU_RGB_R_SWIZ_A_R |
+			 R500_ALU_RGB_G_SWIZ_A_G |
+			 R500_ALU_RGB_B_SWIZ_A_B);
+
+	if (PICT_FORMAT_A(pSrcPicture->format) == 0)
+	    src_alpha = R500_ALPHA_SWIZ_A_1;
+	else
+	    src_alpha = R500_ALPHA_SWIZ_A_A;
+
+	if (pMaskPicture && pMaskPicture->componentAlpha) {
+	    if (RadeonBlendOp[op].src_alpha) {
+		if (PICT_FORMAT_A(pSrcPicture->format) == 0) {
+		    src_color = (R500_ALU_RGB_R_SWIZ_A_1 |
+				 R500_ALU_RGB_G_SWIZ_A_1 |
+				 R500_ALU_RGB_B_SWIZ_A_1);
+		    src_alpha = R500_ALPHA_SWIZ_A_1;
+		} else {
+		    src_color = (R500_ALU_RGB_R_SWIZ_A_A |
+				 R500_ALU_RGB_G_SWIZ_A_A |
+				 R500_ALU_RGB_B_SWIZ_A_A);
+		    src_alpha = R500_ALPHA_SWIZ_A_A;
+		}
+
+		mask_color = (R500_ALU_RGB_R_SWIZ_B_R |
+			      R500_ALU_RGB_G_SWIZ_B_G |
+			      R500_ALU_RGB_B_SWIZ_B_B);
+
+		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		    mask_alpha = R500_ALPHA_SWIZ_B_1;
+		else
+		    mask_alpha = R500_ALPHA_SWIZ_B_A;
+
+	    } else {
+		src_color = (R500_ALU_RGB_R_SWIZ_A_R |
+			     R500_ALU_RGB_G_SWIZ_A_G |
+			     R500_ALU_RGB_B_SWIZ_A_B);
+
+		if (PICT_FORMAT_A(pSrcPicture->format) == 0)
+		    src_alpha = R500_ALPHA_SWIZ_A_1;
+		else
+		    src_alpha = R500_ALPHA_SWIZ_A_A;
+
+		mask_color = (R500_ALU_RGB_R_SWIZ_B_R |
+			      R500_ALU_RGB_G_SWIZ_B_G |
+			      R500_ALU_RGB_B_SWIZ_B_B);
+
+		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		    mask_alpha = R500_ALPHA_SWIZ_B_1;
+		else
+		    mask_alpha = R500_ALPHA_SWIZ_B_A;
+
+	    }
+	} else if (pMaskPicture) {
+	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		mask_color = (R500_ALU_RGB_R_SWIZ_B_1 |
+			      R500_ALU_RGB_G_SWIZ_B_1 |
+			      R500_ALU_RGB_B_SWIZ_B_1);
+	    else
+		mask_color = (R500_ALU_RGB_R_SWIZ_B_A |
+			      R500_ALU_RGB_G_SWIZ_B_A |
+			      R500_ALU_RGB_B_SWIZ_B_A);
+
+	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
+		mask_alpha = R500_ALPHA_SWIZ_B_1;
+	    else
+		mask_alpha = R500_ALPHA_SWIZ_B_A;
+	} else {
+	    mask_color = (R500_ALU_RGB_R_SWIZ_B_1 |
+			  R500_ALU_RGB_G_SWIZ_B_1 |
+			  R500_ALU_RGB_B_SWIZ_B_1);
+	    mask_alpha = R500_ALPHA_SWIZ_B_1;
+	}
+
+	/* shader output swizzling */
+	switch (pDstPicture->format) {
+	case PICT_a8r8g8b8:
+	case PICT_x8r8g8b8:
+	default:
+	    output_fmt = (R300_OUT_FMT_C4_8 |
+			  R300_OUT_FMT_C0_SEL_BLUE |
+			  R300_OUT_FMT_C1_SEL_GREEN |
+			  R300_OUT_FMT_C2_SEL_RED |
+			  R300_OUT_FMT_C3_SEL_ALPHA);
+	    break;
+	case PICT_a8b8g8r8:
+	case PICT_x8b8g8r8:
+	    output_fmt = (R300_OUT_FMT_C4_8 |
+			  R300_OUT_FMT_C0_SEL_RED |
+			  R300_OUT_FMT_C1_SEL_GREEN |
+			  R300_OUT_FMT_C2_SEL_BLUE |
+			  R300_OUT_FMT_C3_SEL_ALPHA);
+	    break;
+	case PICT_a8:
+	    output_fmt = (R300_OUT_FMT_C4_8 |
+			  R300_OUT_FMT_C0_SEL_ALPHA);
+	    break;
+	}
+    }
+
+    State->src_color = src_color;
+    State->src_alpha = src_alpha;
+    State->mask_color = mask_color;
+    State->mask_alpha = mask_alpha;
+    State->output_fmt = output_fmt;
+
     return TRUE;
 }
 
+/*
+ *
+ */
+static struct RadeonCompositeState *
+R300CompositeStateGet(int op, PicturePtr pSrcPicture, PicturePtr pMaskPicture,
+		      PicturePtr pDstPicture, Bool is_r500)
+{
+    struct RadeonCompositeState *State;
+    struct RadeonCompositeKey Key;
+    unsigned int hash;
+
+    memset(&Key, 0, sizeof(Key));
+    Key.op = op;
+    Key.src_format = pSrcPicture->format;
+    Key.dst_format = pDstPicture->format;
+    Key.src_filter = pSrcPicture->filter;
+    if (pSrcPicture->repeat)
+	Key.src_repeat = pSrcPicture->repeatType + 1;
+    if (pSrcPicture->transform)
+	Key.flags |= RADEON_COMP_SRC_TRANSFORM;
+    if (is_r500)
+	Key.flags |= RADEON_COMP_R500;
+
+    if (pMaskPicture) {
+	Key.flags |= RADEON_COMP_MASK;
+	Key.mask_format = pMaskPicture->format;
+	Key.mask_filter = pMaskPicture->filter;
+	if (pMaskPicture->repeat)
+	    Key.mask_repeat = pMaskPicture->repeatType + 1;
+	if (pMaskPicture->componentAlpha)
+	    Key.flags |= RADEON_COMP_MASK_CA;
+	if (pMaskPicture->transform)
+	    Key.flags |= RADEON_COMP_MASK_TRANSFORM;
+    }
+
+    hash = Key.op ^ Key.src_format ^ (Key.mask_format << 1) ^
+	(Key.dst_format << 2) ^ (Key.flags << 3);
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+
+    State = &RadeonCompositeCache[hash & (RADEON_COMP_CACHE_SIZE - 1)];
+    if (State->Valid && !memcmp(&State->Key, &Key, sizeof(Key)))
+	return State;
+
+    State->Key = Key;
+    State->Valid = TRUE;
+    State->Supported = R300CompositeStateFill(State, op, pSrcPicture, pMaskPicture,
+					      pDstPicture, is_r500);
+
+    return State;
+}
+
 #endif /* ONLY_ONCE */
 
 static Bool FUNC_NAME(R300TextureSetup)(PicturePtr pPict, PixmapPtr pPix,
-					int unit)
+					uint32_t card_fmt, int unit)
 {
     VAR_PREAMBLE(pPix->drawable.pScreen);
     THREEDSTATE_PREAMBLE();
     uint32_t txfilter, txformat0, txformat1, txoffset, txpitch;
     int w = pPict->pDrawable->width;
     int h = pPict->pDrawable->height;
-    unsigned int i;
     int pixel_shift;
     ACCEL_PREAMBLE();
 
@@ -1150,13 +1508,7 @@ static Bool FUNC_NAME(R300TextureSetup)(PicturePtr pPict, PixmapPtr pPix,
     if (RADEONPixmapIsColortiled(pPix))
 	txoffset |= R300_MACRO_TILE;
 
-    for (i = 0; i < sizeof(R300TexFormats) / sizeof(R300TexFormats[0]); i++)
-    {
-	if (R300TexFormats[i].fmt == pPict->format)
-	    break;
-    }
-
-    txformat1 = R300TexFormats[i].card_fmt;
+    txformat1 = card_fmt;
 
     txformat0 = ((((w - 1) & 0x7ff) << R300_TXWIDTH_SHIFT) |
 		 (((h - 1) & 0x7ff) << R300_TXHEIGHT_SHIFT));
@@ -1229,15 +1581,15 @@ static Bool R300CheckComposite(int op, PicturePtr pSrcPicture, PicturePtr pMaskP
 	return FALSE;
 
     VAR_PREAMBLE(pSrcPicture->pDrawable->pScreen);
-    uint32_t tmp1;
     PixmapPtr pSrcPixmap, pDstPixmap;
     int max_tex_w, max_tex_h, max_dst_w, max_dst_h;
 
     TRACE;
 
-    /* Check for unsupported compositing operations. */
-    if ((unsigned int)op >= sizeof(RadeonBlendOp) / sizeof(RadeonBlendOp[0]))
-	RADEON_FALLBACK(("Unsupported Composite op 0x%x\n", op));
+    /* unsupported ops, formats, filters... */
+    if (!R300CompositeStateGet(op, pSrcPicture, pMaskPicture, pDstPicture,
+			       IS_R500_3D)->Supported)
+	return FALSE;
 
     pSrcPixmap = RADEONGetDrawablePixmap(pSrcPicture->pDrawable);
 
@@ -1279,19 +1631,6 @@ static Bool R300CheckComposite(int op, PicturePtr pSrcPicture, PicturePtr pMaskP
 			     pMaskPixmap->drawable.height));
 	}
 
-	if (pMaskPicture->componentAlpha) {
-	    /* Check if it's component alpha that relies on a source alpha and
-	     * on the source value.  We can only get one of those into the
-	     * single source value that we get to blend with.
-	     */
-	    if (RadeonBlendOp[op].src_alpha &&
-		(RadeonBlendOp[op].blend_cntl & RADEON_SRC_BLEND_MASK) !=
-		RADEON_SRC_BLEND_GL_ZERO) {
-		RADEON_FALLBACK(("Component alpha not supported with source "
-				 "alpha and source value blending.\n"));
-	    }
-	}
-
 	if (!R300CheckCompositeTexture(pMaskPicture, pDstPicture, op, 1, IS_R500_3D))
 	    return FALSE;
     }
@@ -1299,9 +1638,6 @@ static Bool R300CheckComposite(int op, PicturePtr pSrcPicture, PicturePtr pMaskP
     if (!R300CheckCompositeTexture(pSrcPicture, pDstPicture, op, 0, IS_R500_3D))
 	return FALSE;
 
-    if (!R300GetDestFormat(pDstPicture, &tmp1))
-	return FALSE;
-
     return TRUE;
 
 }
@@ -1315,17 +1651,21 @@ static Bool FUNC_NAME(R300PrepareComposite)(int op, PicturePtr pSrcPicture,
     THREEDSTATE_PREAMBLE();
     uint32_t dst_format, dst_offset, dst_pitch;
     uint32_t txenable, colorpitch;
-    uint32_t blendcntl;
+    struct RadeonCompositeState *State;
     int pixel_shift;
     ACCEL_PREAMBLE();
 
     TRACE;
 
+    State = R300CompositeStateGet(op, pSrcPicture, pMaskPicture, pDstPicture,
+				  IS_R500_3D);
+    if (!State->Supported)
+	return FALSE;
+
     if (!accel_state->XHas3DEngineState)
 	RADEONInit3DEngine(pScrn);
 
-    if (!R300GetDestFormat(pDstPicture, &dst_format))
-	return FALSE;
+    dst_format = State->dst_format;
 
     if (pMask)
 	accel_state->has_mask = TRUE;
@@ -1351,12 +1691,12 @@ static Bool FUNC_NAME(R300PrepareComposite)(int op, PicturePtr pSrcPicture,
     if (!RADEONSetupSourceTile(pSrcPicture, pSrc, TRUE, FALSE))
 	return FALSE;
 
-    if (!FUNC_NAME(R300TextureSetup)(pSrcPicture, pSrc, 0))
+    if (!FUNC_NAME(R300TextureSetup)(pSrcPicture, pSrc, State->tex_format[0], 0))
 	return FALSE;
     txenable = R300_TEX_0_ENABLE;
 
     if (pMask != NULL) {
-	if (!FUNC_NAME(R300TextureSetup)(pMaskPicture, pMask, 1))
+	if (!FUNC_NAME(R300TextureSetup)(pMaskPicture, pMask, State->tex_format[1], 1))
 	    return FALSE;
 	txenable |= R300_TEX_1_ENABLE;
     } else {
@@ -1464,89 +1804,11 @@ static Bool FUNC_NAME(R300PrepareComposite)(int op, PicturePtr pSrcPicture,
 	int src_color, src_alpha;
 	int mask_color, mask_alpha;
 
-	if (PICT_FORMAT_RGB(pSrcPicture->format) == 0)
-	    src_color = R300_ALU_RGB_0_0;
-	else
-	    src_color = R300_ALU_RGB_SRC0_RGB;
-
-	if (PICT_FORMAT_A(pSrcPicture->format) == 0)
-	    src_alpha = R300_ALU_ALPHA_1_0;
-	else
-	    src_alpha = R300_ALU_ALPHA_SRC0_A;
-
-	if (pMask && pMaskPicture->componentAlpha) {
-	    if (RadeonBlendOp[op].src_alpha) {
-		if (PICT_FORMAT_A(pSrcPicture->format) == 0) {
-		    src_color = R300_ALU_RGB_1_0;
-		    src_alpha = R300_ALU_ALPHA_1_0;
-		} else {
-		    src_color = R300_ALU_RGB_SRC0_AAA;
-		    src_alpha = R300_ALU_ALPHA_SRC0_A;
-		}
-
-		mask_color = R300_ALU_RGB_SRC1_RGB;
-
-		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		    mask_alpha = R300_ALU_ALPHA_1_0;
-		else
-		    mask_alpha = R300_ALU_ALPHA_SRC1_A;
-
-	    } else {
-		src_color = R300_ALU_RGB_SRC0_RGB;
-
-		if (PICT_FORMAT_A(pSrcPicture->format) == 0)
-		    src_alpha = R300_ALU_ALPHA_1_0;
-		else
-		    src_alpha = R300_ALU_ALPHA_SRC0_A;
-
-		mask_color = R300_ALU_RGB_SRC1_RGB;
-
-		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		    mask_alpha = R300_ALU_ALPHA_1_0;
-		else
-		    mask_alpha = R300_ALU_ALPHA_SRC1_A;
-
-	    }
-	} else if (pMask) {
-	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		mask_color = R300_ALU_RGB_1_0;
-	    else
-		mask_color = R300_ALU_RGB_SRC1_AAA;
-
-	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		mask_alpha = R300_ALU_ALPHA_1_0;
-	    else
-		mask_alpha = R300_ALU_ALPHA_SRC1_A;
-	} else {
-	    mask_color = R300_ALU_RGB_1_0;
-	    mask_alpha = R300_ALU_ALPHA_1_0;
-	}
-
-	/* shader output swizzling */
-	switch (pDstPicture->format) {
-	case PICT_a8r8g8b8:
-	case PICT_x8r8g8b8:
-	default:
-	    output_fmt = (R300_OUT_FMT_C4_8 |
-			  R300_OUT_FMT_C0_SEL_BLUE |
-			  R300_OUT_FMT_C1_SEL_GREEN |
-			  R300_OUT_FMT_C2_SEL_RED |
-			  R300_OUT_FMT_C3_SEL_ALPHA);
-	    break;
-	case PICT_a8b8g8r8:
-	case PICT_x8b8g8r8:
-	    output_fmt = (R300_OUT_FMT_C4_8 |
-			  R300_OUT_FMT_C0_SEL_RED |
-			  R300_OUT_FMT_C1_SEL_GREEN |
-			  R300_OUT_FMT_C2_SEL_BLUE |
-			  R300_OUT_FMT_C3_SEL_ALPHA);
-	    break;
-	case PICT_a8:
-	    output_fmt = (R300_OUT_FMT_C4_8 |
-			  R300_OUT_FMT_C0_SEL_ALPHA);
-	    break;
-	}
-
+	src_color = State->src_color;
+	src_alpha = State->src_alpha;
+	mask_color = State->mask_color;
+	mask_alpha = State->mask_alpha;
+	output_fmt = State->output_fmt;
 
 	/* setup the rasterizer, load FS */
 	BEGIN_ACCEL(9);
@@ -1660,108 +1922,11 @@ static Bool FUNC_NAME(R300PrepareComposite)(int op, PicturePtr pSrcPicture,
 	uint32_t src_color, src_alpha;
 	uint32_t mask_color, mask_alpha;
 
-	if (PICT_FORMAT_RGB(pSrcPicture->format) == 0)
-	    src_color = (R500_ALU_RGB_R_SWIZ_A_0 |
-			 R500_ALU_RGB_G_SWIZ_A_0 |
-			 R500_ALU_RGB_B_SWIZ_A_0);
-	else
-	    src_color = (R500_ALU_RGB_R_SWIZ_A_R |
-			 R500_ALU_RGB_G_SWIZ_A_G |
-			 R500_ALU_RGB_B_SWIZ_A_B);
-
-	if (PICT_FORMAT_A(pSrcPicture->format) == 0)
-	    src_alpha = R500_ALPHA_SWIZ_A_1;
-	else
-	    src_alpha = R500_ALPHA_SWIZ_A_A;
-
-	if (pMask && pMaskPicture->componentAlpha) {
-	    if (RadeonBlendOp[op].src_alpha) {
-		if (PICT_FORMAT_A(pSrcPicture->format) == 0) {
-		    src_color = (R500_ALU_RGB_R_SWIZ_A_1 |
-				 R500_ALU_RGB_G_SWIZ_A_1 |
-				 R500_ALU_RGB_B_SWIZ_A_1);
-		    src_alpha = R500_ALPHA_SWIZ_A_1;
-		} else {
-		    src_color = (R500_ALU_RGB_R_SWIZ_A_A |
-				 R500_ALU_RGB_G_SWIZ_A_A |
-				 R500_ALU_RGB_B_SWIZ_A_A);
-		    src_alpha = R500_ALPHA_SWIZ_A_A;
-		}
-
-		mask_color = (R500_ALU_RGB_R_SWIZ_B_R |
-			      R500_ALU_RGB_G_SWIZ_B_G |
-			      R500_ALU_RGB_B_SWIZ_B_B);
-
-		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		    mask_alpha = R500_ALPHA_SWIZ_B_1;
-		else
-		    mask_alpha = R500_ALPHA_SWIZ_B_A;
-
-	    } else {
-		src_color = (R500_ALU_RGB_R_SWIZ_A_R |
-			     R500_ALU_RGB_G_SWIZ_A_G |
-			     R500_ALU_RGB_B_SWIZ_A_B);
-
-		if (PICT_FORMAT_A(pSrcPicture->format) == 0)
-		    src_alpha = R500_ALPHA_SWIZ_A_1;
-		else
-		    src_alpha = R500_ALPHA_SWIZ_A_A;
-
-		mask_color = (R500_ALU_RGB_R_SWIZ_B_R |
-			      R500_ALU_RGB_G_SWIZ_B_G |
-			      R500_ALU_RGB_B_SWIZ_B_B);
-
-		if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		    mask_alpha = R500_ALPHA_SWIZ_B_1;
-		else
-		    mask_alpha = R500_ALPHA_SWIZ_B_A;
-
-	    }
-	} else if (pMask) {
-	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		mask_color = (R500_ALU_RGB_R_SWIZ_B_1 |
-			      R500_ALU_RGB_G_SWIZ_B_1 |
-			      R500_ALU_RGB_B_SWIZ_B_1);
-	    else
-		mask_color = (R500_ALU_RGB_R_SWIZ_B_A |
-			      R500_ALU_RGB_G_SWIZ_B_A |
-			      R500_ALU_RGB_B_SWIZ_B_A);
-
-	    if (PICT_FORMAT_A(pMaskPicture->format) == 0)
-		mask_alpha = R500_ALPHA_SWIZ_B_1;
-	    else
-		mask_alpha = R500_ALPHA_SWIZ_B_A;
-	} else {
-	    mask_color = (R500_ALU_RGB_R_SWIZ_B_1 |
-			  R500_ALU_RGB_G_SWIZ_B_1 |
-			  R500_ALU_RGB_B_SWIZ_B_1);
-	    mask_alpha = R500_ALPHA_SWIZ_B_1;
-	}
-
-	/* shader output swizzling */
-	switch (pDstPicture->format) {
-	case PICT_a8r8g8b8:
-	case PICT_x8r8g8b8:
-	default:
-	    output_fmt = (R300_OUT_FMT_C4_8 |
-			  R300_OUT_FMT_C0_SEL_BLUE |
-			  R300_OUT_FMT_C1_SEL_GREEN |
-			  R300_OUT_FMT_C2_SEL_RED |
-			  R300_OUT_FMT_C3_SEL_ALPHA);
-	    break;
-	case PICT_a8b8g8r8:
-	case PICT_x8b8g8r8:
-	    output_fmt = (R300_OUT_FMT_C4_8 |
-			  R300_OUT_FMT_C0_SEL_RED |
-			  R300_OUT_FMT_C1_SEL_GREEN |
-			  R300_OUT_FMT_C2_SEL_BLUE |
-			  R300_OUT_FMT_C3_SEL_ALPHA);
-	    break;
-	case PICT_a8:
-	    output_fmt = (R300_OUT_FMT_C4_8 |
-			  R300_OUT_FMT_C0_SEL_ALPHA);
-	    break;
-	}
+	src_color = State->src_color;
+	src_alpha = State->src_alpha;
+	mask_color = State->mask_color;
+	mask_alpha = State->mask_alpha;
+	output_fmt = State->output_fmt;
 
 	BEGIN_ACCEL(6);
 	if (pMask) {
@@ -1965,11 +2130,12 @@ static Bool FUNC_NAME(R300PrepareComposite)(int op, PicturePtr pSrcPicture,
     OUT_ACCEL_REG(R300_RB3D_COLOROFFSET0, dst_offset);
     OUT_ACCEL_REG(R300_RB3D_COLORPITCH0, colorpitch);
 
-    blendcntl = RADEONGetBlendCntl(op, pMaskPicture, pDstPicture->format);
-    OUT_ACCEL_REG(R300_RB3D_BLENDCNTL, blendcntl | R300_ALPHA_BLEND_ENABLE | R300_READ_ENABLE);
+    OUT_ACCEL_REG(R300_RB3D_BLENDCNTL, State->blend_cntl | R300_ALPHA_BLEND_ENABLE | R300_READ_ENABLE);
 
     FINISH_ACCEL();
 
+    PROF_BEGIN(pDst->drawable.pScreen, op, pDstPicture->format);
+
     return TRUE;
 }
 
@@ -2275,6 +2441,8 @@ static void FUNC_NAME(RadeonDoneComposite)(PixmapPtr pDst)
     ADVANCE_RING();
 #endif
 
+    PROF_END(pDst->drawable.pScreen);
+
     LEAVE_DRAW(0);
 }
 
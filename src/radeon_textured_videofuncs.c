@@ -95,6 +95,7 @@ do {								\
 
 # include "rhd.h"
 # include "rhd_cs.h"
+# include "rhd_prof.h"
 
 # include "r5xx_regs.h"
 # include "r5xx_accel.h"
@@ -187,6 +188,10 @@ RADEONTilingEnabled(ScrnInfoPtr pScrn, PixmapPtr pPix)
 
 # define BUFFER_PITCH pPriv->BufferPitch
 # define FB_BUFFER_OFFSET (pPriv->BufferOffset + rhdPtr->FbIntAddress)
+# define FB_BUFFER_OFFSET_U (FB_BUFFER_OFFSET + pPriv->BufferOffsetU)
+# define FB_BUFFER_OFFSET_V (FB_BUFFER_OFFSET + pPriv->BufferOffsetV)
+# define IS_PLANAR_VIDEO \
+    (IS_R500_3D && ((pPriv->id == FOURCC_YV12) || (pPriv->id == FOURCC_I420)))
 # define FB_PIXMAP_OFFSET(x) (((char *)(x) - (char *)rhdPtr->FbBase) + rhdPtr->FbIntAddress)
 
 # ifdef USE_EXA
@@ -198,8 +203,16 @@ RADEONTilingEnabled(ScrnInfoPtr pScrn, PixmapPtr pPix)
 
 typedef struct RHDPortPriv *RADEONPortPrivPtr;
 
+#define PROF_BEGIN(pScrn, id) RHDProfBegin((pScrn), RHD_PROF_XV, (id), 0)
+#define PROF_END(pScrn) RHDProfEnd(pScrn)
+
 #endif /* IS_RADEON_DRIVER */
 
+#ifndef PROF_BEGIN
+#define PROF_BEGIN(pScrn, id)
+#define PROF_END(pScrn)
+#endif
+
 #ifdef IS_RADEON_DRIVER
 static
 #endif
@@ -219,6 +232,22 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
     int dstxoff, dstyoff, pixel_shift;
     BoxPtr pBox = REGION_RECTS(&pPriv->clip);
     int nBox = REGION_NUM_RECTS(&pPriv->clip);
+#ifndef IS_RADEON_DRIVER
+    /* Y'CbCr to RGB matrices, columns are Y, Cb and Cr */
+    static const float csc_rec601[9] = {
+	1.0,  0.0,      1.4020,
+	1.0, -0.34414, -0.71414,
+	1.0,  1.7720,   0.0,
+    };
+    static const float csc_rec709[9] = {
+	1.0,  0.0,      1.5748,
+	1.0, -0.18732, -0.46812,
+	1.0,  1.8556,   0.0,
+    };
+    /* Y' is scaled from 16:235, Cb/Cr from 16:240 */
+    const float y_mul = 255.0 / 219.0, y_shift = -16.0 / 219.0;
+    const float c_mul = 255.0 / 224.0, c_shift = -128.0 / 224.0;
+#endif
     VIDEO_PREAMBLE();
 
     pixel_shift = pPixmap->drawable.bitsPerPixel >> 4;
@@ -245,6 +274,8 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
     if (!accel_state->XHas3DEngineState)
 	RADEONInit3DEngine(pScrn);
 
+    PROF_BEGIN(pScrn, pPriv->id);
+
     RADEON_SWITCH_TO_3D();
 
     /* we can probably improve this */
@@ -294,12 +325,12 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
 	if (RADEONTilingEnabled(pScrn, pPixmap))
 	    colorpitch |= R300_COLORTILE;
 
-	if (pPriv->id == FOURCC_UYVY)
-	    txformat1 = R300_TX_FORMAT_YVYU422;
+	if (IS_PLANAR_VIDEO)
+	    txformat1 = R300_EASY_TX_FORMAT(X, X, X, ONE, X8);
+	else if (pPriv->id == FOURCC_UYVY)
+	    txformat1 = R300_TX_FORMAT_YVYU422 | R300_TX_FORMAT_YUV_TO_RGB_CLAMP;
 	else
-	    txformat1 = R300_TX_FORMAT_VYUY422;
-
-	txformat1 |= R300_TX_FORMAT_YUV_TO_RGB_CLAMP;
+	    txformat1 = R300_TX_FORMAT_VYUY422 | R300_TX_FORMAT_YUV_TO_RGB_CLAMP;
 
 	txformat0 = ((((pPriv->w - 1) & 0x7ff) << R300_TXWIDTH_SHIFT) |
 		     (((pPriv->h - 1) & 0x7ff) << R300_TXHEIGHT_SHIFT));
@@ -314,7 +345,10 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
 		    R300_TX_MAG_FILTER_LINEAR | R300_TX_MIN_FILTER_LINEAR);
 
 	/* pitch is in pixels */
-	txpitch = BUFFER_PITCH / 2;
+	if (IS_PLANAR_VIDEO)
+	    txpitch = BUFFER_PITCH;
+	else
+	    txpitch = BUFFER_PITCH / 2;
 	txpitch -= 1;
 
 	if (IS_R500_3D && ((pPriv->w - 1) & 0x800))
@@ -334,6 +368,34 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
 
 	txenable = R300_TEX_0_ENABLE;
 
+#ifndef IS_RADEON_DRIVER
+	if (IS_PLANAR_VIDEO) {
+	    /* U in unit 1, V in unit 2, both at half resolution */
+	    txformat0 = (((((pPriv->w >> 1) - 1) & 0x7ff) << R300_TXWIDTH_SHIFT) |
+			 (((((pPriv->h + 1) >> 1) - 1) & 0x7ff) << R300_TXHEIGHT_SHIFT) |
+			 R300_TXPITCH_EN);
+	    txpitch = (BUFFER_PITCH >> 1) - 1;
+
+	    BEGIN_VIDEO(12);
+	    OUT_VIDEO_REG(R300_TX_FILTER0_0 + 4, txfilter | (1 << R300_TX_ID_SHIFT));
+	    OUT_VIDEO_REG(R300_TX_FILTER1_0 + 4, 0);
+	    OUT_VIDEO_REG(R300_TX_FORMAT0_0 + 4, txformat0);
+	    OUT_VIDEO_REG(R300_TX_FORMAT1_0 + 4, txformat1);
+	    OUT_VIDEO_REG(R300_TX_FORMAT2_0 + 4, txpitch);
+	    OUT_VIDEO_REG(R300_TX_OFFSET_0 + 4, FB_BUFFER_OFFSET_U);
+
+	    OUT_VIDEO_REG(R300_TX_FILTER0_0 + 8, txfilter | (2 << R300_TX_ID_SHIFT));
+	    OUT_VIDEO_REG(R300_TX_FILTER1_0 + 8, 0);
+	    OUT_VIDEO_REG(R300_TX_FORMAT0_0 + 8, txformat0);
+	    OUT_VIDEO_REG(R300_TX_FORMAT1_0 + 8, txformat1);
+	    OUT_VIDEO_REG(R300_TX_FORMAT2_0 + 8, txpitch);
+	    OUT_VIDEO_REG(R300_TX_OFFSET_0 + 8, FB_BUFFER_OFFSET_V);
+	    FINISH_VIDEO();
+
+	    txenable |= R300_TEX_1_ENABLE | R300_TEX_2_ENABLE;
+	}
+#endif
+
 	/* setup the VAP */
 	if (HAS_TCL)
 	    BEGIN_VIDEO(6);
@@ -452,6 +514,212 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
 			   R300_ALU_ALPHA_OMOD(R300_ALU_ALPHA_OMOD_NONE) |
 			   R300_ALU_ALPHA_CLAMP));
 	    FINISH_VIDEO();
+#ifndef IS_RADEON_DRIVER
+	} else if (IS_PLANAR_VIDEO) {
+	    static const uint32_t tex_wmask[3] = {
+		R500_INST_RGB_WMASK_R, R500_INST_RGB_WMASK_G, R500_INST_RGB_WMASK_B
+	    };
+	    const float *csc;
+	    float consts[16];
+	    int i;
+
+	    /* Pick the same Y'CbCr colour space as the R600 path */
+	    if ((pPriv->color_space == RHD_XV_COLOR_SPACE_REC709) ||
+		(pPriv->color_space == RHD_XV_COLOR_SPACE_AUTODETECT &&
+		 pPriv->src_w >= 928))
+		csc = csc_rec709;
+	    else
+		csc = csc_rec601;
+
+	    /*
+	     * Fold the range scaling into the matrix, so that
+	     * rgb = Y * c0 + U * c1 + V * c2 + c3.
+	     */
+	    for (i = 0; i < 3; i++) {
+		consts[i] = csc[3 * i] * y_mul;
+		consts[4 + i] = csc[3 * i + 1] * c_mul;
+		consts[8 + i] = csc[3 * i + 2] * c_mul;
+		consts[12 + i] = csc[3 * i] * y_shift +
+		    (csc[3 * i + 1] + csc[3 * i + 2]) * c_shift;
+	    }
+	    consts[3] = consts[7] = consts[11] = consts[15] = 0.0;
+
+	    BEGIN_VIDEO(59);
+	    /* 2 components: 2 for tex0 */
+	    OUT_VIDEO_REG(R300_RS_COUNT,
+			  ((2 << R300_RS_COUNT_IT_COUNT_SHIFT) |
+			   R300_RS_COUNT_HIRES_EN));
+
+	    /* R300_INST_COUNT_RS - highest RS instruction used */
+	    OUT_VIDEO_REG(R300_RS_INST_COUNT, R300_INST_COUNT_RS(0));
+
+	    OUT_VIDEO_REG(R500_US_CODE_ADDR, (R500_US_CODE_START_ADDR(0) |
+					      R500_US_CODE_END_ADDR(5)));
+	    OUT_VIDEO_REG(R500_US_CODE_RANGE, (R500_US_CODE_RANGE_ADDR(0) |
+					       R500_US_CODE_RANGE_SIZE(5)));
+	    OUT_VIDEO_REG(R500_US_CODE_OFFSET, 0);
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_INDEX, 0);
+
+	    /*
+	     * tex insts: Y, U and V into temp1.r, temp1.g and temp1.b,
+	     * all three sampled at the texcoord in temp0.
+	     */
+	    for (i = 0; i < 3; i++) {
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_INST_TYPE_TEX |
+						       R500_INST_TEX_SEM_WAIT |
+						       tex_wmask[i] |
+						       R500_INST_RGB_CLAMP));
+
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_TEX_ID(i) |
+						       R500_TEX_INST_LD |
+						       R500_TEX_SEM_ACQUIRE |
+						       R500_TEX_IGNORE_UNCOVERED));
+
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_TEX_SRC_ADDR(0) |
+						       R500_TEX_SRC_S_SWIZ_R |
+						       R500_TEX_SRC_T_SWIZ_G |
+						       R500_TEX_DST_ADDR(1) |
+						       R500_TEX_DST_R_SWIZ_R |
+						       R500_TEX_DST_G_SWIZ_G |
+						       R500_TEX_DST_B_SWIZ_B |
+						       R500_TEX_DST_A_SWIZ_A));
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_DX_ADDR(0) |
+						       R500_DX_S_SWIZ_R |
+						       R500_DX_T_SWIZ_R |
+						       R500_DX_R_SWIZ_R |
+						       R500_DX_Q_SWIZ_R |
+						       R500_DY_ADDR(0) |
+						       R500_DY_S_SWIZ_R |
+						       R500_DY_T_SWIZ_R |
+						       R500_DY_R_SWIZ_R |
+						       R500_DY_Q_SWIZ_R));
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, 0x00000000);
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, 0x00000000);
+	    }
+
+	    /* ALU inst: temp2.rgb = Y * c0 + c3 */
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_INST_TYPE_ALU |
+						   R500_INST_TEX_SEM_WAIT |
+						   R500_INST_RGB_WMASK_R |
+						   R500_INST_RGB_WMASK_G |
+						   R500_INST_RGB_WMASK_B));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_RGB_ADDR0(1) |
+						   R500_RGB_ADDR1(0) |
+						   R500_RGB_ADDR1_CONST |
+						   R500_RGB_ADDR2(3) |
+						   R500_RGB_ADDR2_CONST));
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALPHA_ADDR0(1) |
+						   R500_ALPHA_ADDR1(0) |
+						   R500_ALPHA_ADDR1_CONST |
+						   R500_ALPHA_ADDR2(3) |
+						   R500_ALPHA_ADDR2_CONST));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALU_RGB_SEL_A_SRC0 |
+						   R500_ALU_RGB_R_SWIZ_A_R |
+						   R500_ALU_RGB_G_SWIZ_A_R |
+						   R500_ALU_RGB_B_SWIZ_A_R |
+						   R500_ALU_RGB_SEL_B_SRC1 |
+						   R500_ALU_RGB_R_SWIZ_B_R |
+						   R500_ALU_RGB_G_SWIZ_B_G |
+						   R500_ALU_RGB_B_SWIZ_B_B));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALPHA_OP_MAD |
+						   R500_ALPHA_ADDRD(2) |
+						   R500_ALPHA_SWIZ_A_0 |
+						   R500_ALPHA_SWIZ_B_0));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALU_RGBA_OP_MAD |
+						   R500_ALU_RGBA_ADDRD(2) |
+						   R500_ALU_RGBA_SEL_C_SRC2 |
+						   R500_ALU_RGBA_R_SWIZ_R |
+						   R500_ALU_RGBA_G_SWIZ_G |
+						   R500_ALU_RGBA_B_SWIZ_B |
+						   R500_ALU_RGBA_A_SWIZ_0));
+
+	    /* ALU inst: temp2.rgb = U * c1 + temp2 */
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_INST_TYPE_ALU |
+						   R500_INST_RGB_WMASK_R |
+						   R500_INST_RGB_WMASK_G |
+						   R500_INST_RGB_WMASK_B));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_RGB_ADDR0(1) |
+						   R500_RGB_ADDR1(1) |
+						   R500_RGB_ADDR1_CONST |
+						   R500_RGB_ADDR2(2)));
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALPHA_ADDR0(1) |
+						   R500_ALPHA_ADDR1(1) |
+						   R500_ALPHA_ADDR1_CONST |
+						   R500_ALPHA_ADDR2(2)));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALU_RGB_SEL_A_SRC0 |
+						   R500_ALU_RGB_R_SWIZ_A_G |
+						   R500_ALU_RGB_G_SWIZ_A_G |
+						   R500_ALU_RGB_B_SWIZ_A_G |
+						   R500_ALU_RGB_SEL_B_SRC1 |
+						   R500_ALU_RGB_R_SWIZ_B_R |
+						   R500_ALU_RGB_G_SWIZ_B_G |
+						   R500_ALU_RGB_B_SWIZ_B_B));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALPHA_OP_MAD |
+						   R500_ALPHA_ADDRD(2) |
+						   R500_ALPHA_SWIZ_A_0 |
+						   R500_ALPHA_SWIZ_B_0));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALU_RGBA_OP_MAD |
+						   R500_ALU_RGBA_ADDRD(2) |
+						   R500_ALU_RGBA_SEL_C_SRC2 |
+						   R500_ALU_RGBA_R_SWIZ_R |
+						   R500_ALU_RGBA_G_SWIZ_G |
+						   R500_ALU_RGBA_B_SWIZ_B |
+						   R500_ALU_RGBA_A_SWIZ_0));
+
+	    /* ALU inst: out.rgb = V * c2 + temp2, out.a = 1 */
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_INST_TYPE_OUT |
+						   R500_INST_LAST |
+						   R500_INST_RGB_OMASK_R |
+						   R500_INST_RGB_OMASK_G |
+						   R500_INST_RGB_OMASK_B |
+						   R500_INST_ALPHA_OMASK |
+						   R500_INST_RGB_CLAMP |
+						   R500_INST_ALPHA_CLAMP));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_RGB_ADDR0(1) |
+						   R500_RGB_ADDR1(2) |
+						   R500_RGB_ADDR1_CONST |
+						   R500_RGB_ADDR2(2)));
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALPHA_ADDR0(1) |
+						   R500_ALPHA_ADDR1(2) |
+						   R500_ALPHA_ADDR1_CONST |
+						   R500_ALPHA_ADDR2(2)));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALU_RGB_SEL_A_SRC0 |
+						   R500_ALU_RGB_R_SWIZ_A_B |
+						   R500_ALU_RGB_G_SWIZ_A_B |
+						   R500_ALU_RGB_B_SWIZ_A_B |
+						   R500_ALU_RGB_SEL_B_SRC1 |
+						   R500_ALU_RGB_R_SWIZ_B_R |
+						   R500_ALU_RGB_G_SWIZ_B_G |
+						   R500_ALU_RGB_B_SWIZ_B_B));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALPHA_OP_MAD |
+						   R500_ALPHA_SWIZ_A_1 |
+						   R500_ALPHA_SWIZ_B_1));
+
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, (R500_ALU_RGBA_OP_MAD |
+						   R500_ALU_RGBA_SEL_C_SRC2 |
+						   R500_ALU_RGBA_R_SWIZ_R |
+						   R500_ALU_RGBA_G_SWIZ_G |
+						   R500_ALU_RGBA_B_SWIZ_B |
+						   R500_ALU_RGBA_A_SWIZ_0));
+
+	    /* c0 - c3 */
+	    OUT_VIDEO_REG(R500_GA_US_VECTOR_INDEX, (R500_US_VECTOR_TYPE_CONST |
+						    R500_US_VECTOR_INDEX(0)));
+	    for (i = 0; i < 16; i++)
+		OUT_VIDEO_REG(R500_GA_US_VECTOR_DATA, F_TO_DW(consts[i]));
+	    FINISH_VIDEO();
+#endif /* IS_RADEON_DRIVER */
 	} else {
 	    BEGIN_VIDEO(18);
 	    /* 2 components: 2 for tex0 */
@@ -804,6 +1072,8 @@ FUNC_NAME(RADEONDisplayTexturedVideo)(ScrnInfoPtr pScrn, RADEONPortPrivPtr pPriv
     OUT_VIDEO_REG(RADEON_WAIT_UNTIL, RADEON_WAIT_3D_IDLECLEAN);
     FINISH_VIDEO();
 
+    PROF_END(pScrn);
+
 #ifdef DAMAGE
     DamageDamageRegion(pPriv->pDraw, &pPriv->clip);
 #endif
@@ -263,6 +263,10 @@ typedef struct RHDRec {
     RHDOpt              lowPowerMode;
     RHDOpt              lowPowerModeEngineClock;
     RHDOpt              lowPowerModeMemoryClock;
+    RHDOpt		tiledPixmaps;
+    RHDOpt		csTrace;
+    RHDOpt		csBackend;
+    RHDOpt		profile;
     enum RHD_HPD_USAGE	hpdUsage;
     unsigned int        FbMapSize;
     pointer             FbBase;   /* map base of fb   */
@@ -333,6 +337,7 @@ typedef struct RHDRec {
     rhdShadowPtr       shadowPtr;
 
     struct RhdCS       *CS;
+    struct RhdProf     *Prof;
 
     struct _XAAInfoRec *XAAInfo;
 #ifdef USE_EXA
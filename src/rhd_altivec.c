@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The AltiVec versions of the byte swapping copies and of the Xv YV12
+ * packing, see rhd_swap.c and rhd_video.c. This is the only file built with
+ * -maltivec, so that the compiler cannot slip vector instructions into code
+ * which runs before RHDHasAltivec() has been asked.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+
+#include "rhd_swap.h"
+#include "rhd_xvpack.h"
+
+/* last, altivec.h defines vector, pixel and bool */
+#include <altivec.h>
+
+/*
+ * Stores need dst to be 16 byte aligned, so the scalar version takes care of
+ * the head and the tail. src gets read unaligned: two loads and a permute,
+ * with the swap folded into that permute.
+ */
+static inline void
+CopySwapAltivec(CARD8 *dst, CARD8 *src, unsigned int size, unsigned int unit,
+		const vector unsigned char swap, RHDCopySwapProc Scalar)
+{
+    unsigned int head = (16 - ((unsigned long) dst & 15)) & 15;
+    vector unsigned char perm;
+
+    /* too small, or dst will never line up */
+    if ((head + 16 > size) || (head & (unit - 1))) {
+	Scalar(dst, src, size);
+	return;
+    }
+
+    if (head) {
+	Scalar(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+    }
+
+    /* combine the unaligned load and the swap into a single permute */
+    perm = vec_perm(vec_lvsl(0, src), vec_lvsl(0, src), swap);
+
+    for (; size >= 16; size -= 16, dst += 16, src += 16) {
+	vector unsigned char lo = vec_ld(0, src);
+	vector unsigned char hi = vec_ld(15, src);
+
+	vec_st(vec_perm(lo, hi, perm), 0, dst);
+    }
+
+    if (size)
+	Scalar(dst, src, size);
+}
+
+void
+RHDCopySwap32Altivec(CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    const vector unsigned char swap = (vector unsigned char)
+	{ 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+
+    CopySwapAltivec(dst, src, size & ~3, 4, swap, RHDCopySwap32C);
+}
+
+void
+RHDCopySwapHDWAltivec(CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    const vector unsigned char swap = (vector unsigned char)
+	{ 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 };
+
+    CopySwapAltivec(dst, src, size & ~3, 4, swap, RHDCopySwapHDWC);
+}
+
+void
+RHDCopySwap16Altivec(CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    const vector unsigned char swap = (vector unsigned char)
+	{ 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+
+    CopySwapAltivec(dst, src, size & ~1, 2, swap, RHDCopySwap16C);
+}
+
+static inline vector unsigned char
+R5xxXvLoadAltivec(CARD8 *p)
+{
+    return vec_perm(vec_ld(0, p), vec_ld(15, p), vec_lvsl(0, p));
+}
+
+/*
+ * Big endian: the C version stores s2, odd luma, s3, even luma.
+ */
+void
+R5xxXvPackLineAltivec(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs)
+{
+    const vector unsigned char swap = (vector unsigned char)
+	{ 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+    int head = ((16 - ((unsigned long) d & 15)) & 15) >> 2;
+
+    /* stores need to be aligned */
+    if (((unsigned long) d & 3) || (head + 16 > pairs)) {
+	R5xxXvPackLineC(d, s1, s2, s3, pairs);
+	return;
+    }
+
+    if (head) {
+	R5xxXvPackLineC(d, s1, s2, s3, head);
+	d += head;
+	s2 += head;
+	s3 += head;
+	s1 += 2 * head;
+	pairs -= head;
+    }
+
+    for (; pairs >= 16; pairs -= 16) {
+	vector unsigned char y0 = R5xxXvLoadAltivec(s1);
+	vector unsigned char y1 = R5xxXvLoadAltivec(s1 + 16);
+	vector unsigned char c = R5xxXvLoadAltivec(s2);
+	vector unsigned char c3 = R5xxXvLoadAltivec(s3);
+	vector unsigned char uv0 = vec_mergeh(c, c3);
+	vector unsigned char uv1 = vec_mergel(c, c3);
+
+	y0 = vec_perm(y0, y0, swap);
+	y1 = vec_perm(y1, y1, swap);
+
+	vec_st(vec_mergeh(uv0, y0), 0, (CARD8 *) d);
+	vec_st(vec_mergel(uv0, y0), 16, (CARD8 *) d);
+	vec_st(vec_mergeh(uv1, y1), 32, (CARD8 *) d);
+	vec_st(vec_mergel(uv1, y1), 48, (CARD8 *) d);
+
+	d += 16;
+	s2 += 16;
+	s3 += 16;
+	s1 += 32;
+    }
+
+    R5xxXvPackLineC(d, s1, s2, s3, pairs);
+}
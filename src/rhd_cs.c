@@ -33,15 +33,55 @@
 
 #include <compiler.h>
 
+/* for usleep, and the trace file */
+#if HAVE_XF86_ANSIC_H
+# include "xf86_ansic.h"
+#else
+# include <unistd.h>
+# include <string.h>
+# include <stdio.h>
+#endif
+
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_cs_trace.h"
 #include "r5xx_regs.h"
+#include "r600_reg.h"
 
 #if 1
 #define BUILD_CS_MMIO 1
 #endif
 
-#define CS_LOOP_COUNT 10000000
+/*
+ * Waiting on the engine: retry straight away for a bit, then start handing
+ * the CPU back, and only give up after CS_WAIT_TIMEOUT has passed.
+ */
+#define CS_SPIN_COUNT    64
+#define CS_WAIT_USECS    20
+#define CS_WAIT_TIMEOUT  3000 /* ms */
+
+static Bool
+CSWait(struct RhdCS *CS, int *Tries, CARD32 *Start)
+{
+    if (++(*Tries) <= CS_SPIN_COUNT)
+	return TRUE;
+
+    if (!*Start) {
+	*Start = GetTimeInMillis();
+	CS->WaitCount++;
+    } else if ((GetTimeInMillis() - *Start) > CS_WAIT_TIMEOUT)
+	return FALSE;
+
+    usleep(CS_WAIT_USECS);
+    return TRUE;
+}
+
+static void
+CSWaitDone(struct RhdCS *CS, CARD32 Start)
+{
+    if (Start)
+	CS->WaitTime += GetTimeInMillis() - Start;
+}
 
 #ifdef BUILD_CS_MMIO
 /*
@@ -55,26 +95,63 @@
 #define CSMMIORegRead(Reg) MMIO_IN32(MMIOBase, (Reg))
 #define CSMMIORegWrite(Reg, Value) MMIO_OUT32(MMIOBase, (Reg), (Value))
 
+/*
+ * Takes a single snapshot of the free RBBM entries, and then writes out as
+ * many registers as fit in there, without going back to the RBBM status.
+ *
+ * A PACKET0 can cover a run of consecutive registers (RHDCSRegWriteRun). When
+ * only part of a run fits, the rest of it gets a fresh header in the buffer,
+ * in the slot of the last value that was written out.
+ */
 static void
 CSMMIORBBMStuff(struct RhdCS *CS)
 {
     CARD8 *MMIOBase = RHDPTRI(CS)->MMIOBase;
-    CARD32 BufferEntries = (CS->Wptr - CS->Flushed) / 2;
-    CARD32 RBBMEntries = CSMMIORegRead(R5XX_RBBM_STATUS) & R5XX_RBBM_FIFOCNT_MASK;
-    int i, Entries;
-
-    if (RBBMEntries < BufferEntries)
-	Entries = RBBMEntries;
-    else
-	Entries = BufferEntries;
-
-    for (i = 0; i < Entries; i++) {
-	CSMMIORegWrite((CS->Buffer[CS->Flushed] & 0x3FFF) << 2,
-		       CS->Buffer[CS->Flushed + 1]);
-	CS->Flushed += 2;
+    CARD32 Entries = CSMMIORegRead(R5XX_RBBM_STATUS) & R5XX_RBBM_FIFOCNT_MASK;
+
+    while (Entries && (CS->Flushed != CS->Wptr)) {
+	CARD32 *Packet = &CS->Buffer[CS->Flushed];
+	CARD32 Reg, Count, Burst, i;
+
+	if (Packet[0] == CP_PACKET2()) { /* padding */
+	    CS->Flushed++;
 #ifdef RHD_CS_DEBUG
-	CS->Grabbed -= 2;
+	    CS->Grabbed--;
 #endif
+	    continue;
+	}
+
+#ifdef RHD_CS_DEBUG
+	if (Packet[0] & 0xC0000000)
+	    xf86DrvMsg(CS->scrnIndex, X_ERROR, "%s: Not a PACKET0: 0x%08X\n",
+		       __func__, (unsigned int) Packet[0]);
+#endif
+
+	Reg = (Packet[0] & 0x3FFF) << 2;
+	Count = ((Packet[0] >> 16) & 0x3FFF) + 1;
+
+	if (Count > Entries)
+	    Burst = Entries;
+	else
+	    Burst = Count;
+
+	for (i = 0; i < Burst; i++)
+	    CSMMIORegWrite(Reg + (i << 2), Packet[1 + i]);
+
+	if (Burst == Count) {
+	    CS->Flushed += 1 + Count;
+#ifdef RHD_CS_DEBUG
+	    CS->Grabbed -= 1 + Count;
+#endif
+	} else {
+	    CS->Flushed += Burst;
+	    CS->Buffer[CS->Flushed] = CP_PACKET0(Reg + (Burst << 2), Count - Burst);
+#ifdef RHD_CS_DEBUG
+	    CS->Grabbed -= Burst;
+#endif
+	}
+
+	Entries -= Burst;
     }
 }
 
@@ -84,29 +161,21 @@ CSMMIORBBMStuff(struct RhdCS *CS)
 static void
 CSMMIOFlush(struct RhdCS *CS)
 {
-    int i;
-
-#ifdef RHD_CS_DEBUG
-    if (CS->Flushed & 1)
-	xf86DrvMsg(CS->scrnIndex, X_ERROR,
-		   "%s: CS->Flushed is not aligned (%d - (%s))!\n",
-		   __func__, (unsigned int) CS->Flushed, CS->Func);
-    if (CS->Wptr & 1)
-	xf86DrvMsg(CS->scrnIndex, X_ERROR,
-		   "%s: CS->Wptr is not aligned (%d - (%s))!\n",
-		   __func__, (unsigned int) CS->Wptr, CS->Func);
-#endif
+    CARD32 Start = 0;
+    int Tries = 0;
 
     /* go from CS->Flushed to CP->Wptr and write it out */
-    for (i = 0; i < CS_LOOP_COUNT; i++) {
-	if (CS->Flushed != CS->Wptr)
-	    CSMMIORBBMStuff(CS);
-	else
-	    return;
+    while (CS->Flushed != CS->Wptr) {
+	CSMMIORBBMStuff(CS);
+
+	if ((CS->Flushed != CS->Wptr) && !CSWait(CS, &Tries, &Start)) {
+	    xf86DrvMsg(CS->scrnIndex, X_ERROR,
+		       "%s: Failed to empty the RBBM.\n", __func__);
+	    break;
+	}
     }
 
-    xf86DrvMsg(CS->scrnIndex, X_ERROR,
-	       "%s: Failed to empty the RBBM.\n", __func__);
+    CSWaitDone(CS, Start);
 }
 
 /*
@@ -115,33 +184,27 @@ CSMMIOFlush(struct RhdCS *CS)
 static void
 CSMMIOGrab(struct RhdCS *CS, CARD32 Count)
 {
-    int i;
-
-#ifdef RHD_CS_DEBUG
-    if (CS->Flushed & 1)
-	xf86DrvMsg(CS->scrnIndex, X_ERROR,
-		   "%s: CS->Flushed is not aligned (%d - (%s))!\n",
-		   __func__, (unsigned int) CS->Flushed, CS->Func);
-    if (CS->Wptr & 1)
-	xf86DrvMsg(CS->scrnIndex, X_ERROR,
-		   "%s: CS->Wptr is not aligned (%d - (%s))!\n",
-		   __func__, (unsigned int) CS->Wptr, CS->Func);
-#endif
+    CARD32 Start = 0;
+    int Tries = 0;
 
-    for (i = 0; i < CS_LOOP_COUNT; i++) {
-	if ((CS->Size - CS->Wptr) >= Count)
-	    return;
+    while ((CS->Size - CS->Wptr) < Count) {
 	if (CS->Flushed == CS->Wptr) {
 	    CS->Wptr = 0;
 	    CS->Flushed = 0;
-	    return;
+	    break;
 	}
+
 	CSMMIORBBMStuff(CS);
+
+	if (!CSWait(CS, &Tries, &Start)) {
+	    xf86DrvMsg(CS->scrnIndex, X_ERROR,
+		       "%s: Failed to get %d slots in the RBBM.\n",
+		       __func__, (unsigned int) Count);
+	    break;
+	}
     }
 
-    xf86DrvMsg(CS->scrnIndex, X_ERROR,
-	       "%s: Failed to get %d slots in the RBBM.\n",
-	       __func__, (unsigned int) Count);
+    CSWaitDone(CS, Start);
 }
 
 /*
@@ -219,11 +282,12 @@ DRMCPFlush(struct RhdCS *CS)
     if (!CP->DrmBuffer)
 	return;
 
-    if (rhdPtr->ChipSet >= RHD_R600) {
-	while ((CS->Wptr * 4) & 0x3c) {
-	    RHDCSGrab(CS, 1);
+    if ((rhdPtr->ChipSet >= RHD_R600) && (CS->Wptr & 0xF)) {
+	CARD32 Pad = 0x10 - (CS->Wptr & 0xF);
+
+	RHDCSGrab(CS, Pad);
+	while (Pad--)
 	    RHDCSWrite(CS, CP_PACKET2());
-	}
     }
 
     indirect.idx = CP->DrmBuffer->idx;
@@ -381,6 +445,54 @@ DRMCPIdle(struct RhdCS *CS)
     return FALSE;
 }
 
+/*
+ * The DRM hands out sequence numbers through its IRQ emit, and waiting on
+ * those sleeps in the kernel until the engine got there.
+ */
+static CARD32
+DRMCPFenceEmit(struct RhdCS *CS)
+{
+    struct RhdDRMCP *CP = CS->Private;
+    drm_radeon_irq_emit_t emit;
+    int Fence = 0;
+
+    emit.irq_seq = &Fence;
+
+    if (drmCommandWriteRead(CP->DrmFd, DRM_RADEON_IRQ_EMIT,
+			    &emit, sizeof(drm_radeon_irq_emit_t))) {
+	xf86DrvMsg(CS->scrnIndex, X_INFO, "%s: No DRM IRQ support, waiting"
+		   " for the engine to go idle instead.\n", __func__);
+	CS->FenceEmit = NULL;
+	CS->FenceWait = NULL;
+	return 0;
+    }
+
+    return Fence;
+}
+
+/*
+ *
+ */
+static Bool
+DRMCPFenceWait(struct RhdCS *CS, CARD32 Fence)
+{
+    struct RhdDRMCP *CP = CS->Private;
+    drm_radeon_irq_wait_t wait;
+    int ret;
+
+    wait.irq_seq = Fence;
+
+    ret = drmCommandWrite(CP->DrmFd, DRM_RADEON_IRQ_WAIT,
+			  &wait, sizeof(drm_radeon_irq_wait_t));
+    if (ret) {
+	xf86DrvMsg(CS->scrnIndex, X_ERROR, "%s: DRM IRQ WAIT for %u returned"
+		   " %d\n", __func__, (unsigned int) Fence, ret);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
 /*
  *
  */
@@ -403,6 +515,33 @@ DRMCPGrab(struct RhdCS *CS, CARD32 Count)
     }
 }
 
+/*
+ *
+ */
+static struct _drmBuf *
+DRMCPIBGet(struct RhdCS *CS)
+{
+    return RHDDRMCPBuffer(CS->scrnIndex);
+}
+
+/*
+ *
+ */
+static void
+DRMCPIBSubmit(struct RhdCS *CS, struct _drmBuf *Buffer)
+{
+    struct RhdDRMCP *CP = CS->Private;
+    struct drm_radeon_indirect indirect;
+
+    indirect.idx = Buffer->idx;
+    indirect.start = 0;
+    indirect.end = Buffer->used;
+    indirect.discard = 1;
+
+    drmCommandWriteRead(CP->DrmFd, DRM_RADEON_INDIRECT,
+			&indirect, sizeof(struct drm_radeon_indirect));
+}
+
 /*
  *
  */
@@ -455,16 +594,460 @@ CSDRMCPInit(struct RhdCS *CS)
     /* The DRILeaveServer call flushes all the time for us */
     CS->AdvanceFlush = FALSE;
     CS->Idle = DRMCPIdle;
+    CS->FenceEmit = DRMCPFenceEmit;
+    CS->FenceWait = DRMCPFenceWait;
     CS->Start = DRMCPStart;
     CS->Reset = DRMCPReset;
     CS->Stop = DRMCPStop;
     CS->Destroy = DRMCPDestroy;
+    CS->IBGet = DRMCPIBGet;
+    CS->IBSubmit = DRMCPIBSubmit;
 
     return TRUE;
 }
 
 #endif /* USE_DRI */
 
+/*
+ *
+ * Null Backend: nothing ever reaches an engine, the stream is only checked
+ * for sanity and counted. This lets the accel paths run without the engine
+ * getting in the way, for testing and for measuring CPU side costs.
+ *
+ */
+/* R6xx holds an IB, a VB, the retired VBs and the staging ring at once */
+#define CS_NULL_IB_COUNT     16
+#define CS_NULL_ERRORS_SHOWN 16
+
+struct RhdCSNull {
+    Bool R6xx;
+    CARD32 MMIOSize; /* registers above this do not exist */
+
+    CARD32 Flushes;
+    CARD32 Dwords;
+    CARD32 Packets[4];
+    CARD32 IBs;
+    CARD32 IBDwords;
+    CARD32 Errors;
+
+#ifdef USE_DRI
+    /* stand-ins for the DRM DMA buffers */
+    drmBuf IBList[CS_NULL_IB_COUNT];
+    Bool IBInUse[CS_NULL_IB_COUNT];
+#endif
+};
+
+/*
+ * Ranges of the R6xx SET_* packets, the first payload dword is the offset.
+ */
+static const struct {
+    CARD8 Opcode;
+    CARD32 Start;
+    CARD32 End;
+} CSNullSetRanges[] = {
+    { IT_SET_CONFIG_REG,  SET_CONFIG_REG_offset,  SET_CONFIG_REG_end },
+    { IT_SET_CONTEXT_REG, SET_CONTEXT_REG_offset, SET_CONTEXT_REG_end },
+    { IT_SET_ALU_CONST,   SET_ALU_CONST_offset,   SET_ALU_CONST_end },
+    { IT_SET_RESOURCE,    SET_RESOURCE_offset,    SET_RESOURCE_end },
+    { IT_SET_SAMPLER,     SET_SAMPLER_offset,     SET_SAMPLER_end },
+    { IT_SET_CTL_CONST,   SET_CTL_CONST_offset,   SET_CTL_CONST_end },
+    { IT_SET_LOOP_CONST,  SET_LOOP_CONST_offset,  SET_LOOP_CONST_end },
+    { IT_SET_BOOL_CONST,  SET_BOOL_CONST_offset,  SET_BOOL_CONST_end },
+    { 0, 0, 0 }
+};
+
+/*
+ *
+ */
+static void
+CSNullError(struct RhdCS *CS, CARD32 *Buffer, CARD32 Offset,
+	    const char *Message)
+{
+    struct RhdCSNull *Null = CS->Private;
+
+    Null->Errors++;
+    if (Null->Errors <= CS_NULL_ERRORS_SHOWN)
+	xf86DrvMsg(CS->scrnIndex, X_ERROR, "%s: %s: 0x%08X at dword %u.\n",
+		   __func__, Message, (unsigned int) Buffer[Offset],
+		   (unsigned int) Offset);
+}
+
+/*
+ * Walk the packets and check them against the register ranges.
+ */
+static void
+CSNullCheck(struct RhdCS *CS, CARD32 *Buffer, CARD32 Count)
+{
+    struct RhdCSNull *Null = CS->Private;
+    CARD32 i = 0, Header, Length, Reg, End;
+    int j;
+
+    while (i < Count) {
+	Header = Buffer[i];
+
+	switch (Header >> 30) {
+	case 0:
+	    Length = ((Header >> 16) & 0x3FFF) + 1;
+	    Reg = (Header & 0x7FFF) << 2;
+	    /* bit 15: all of them go to the same register */
+	    End = Reg + ((Header & 0x8000) ? 4 : (4 * Length));
+	    if (End > Null->MMIOSize)
+		CSNullError(CS, Buffer, i, "PACKET0 beyond the registers");
+	    break;
+	case 1:
+	    Length = 2;
+	    break;
+	case 2:
+	    Length = 0;
+	    break;
+	default:
+	    Length = ((Header >> 16) & 0x3FFF) + 1;
+	    if (!Null->R6xx || ((i + 1) >= Count))
+		break;
+
+	    for (j = 0; CSNullSetRanges[j].Opcode; j++)
+		if (CSNullSetRanges[j].Opcode == ((Header >> 8) & 0xFF))
+		    break;
+	    if (!CSNullSetRanges[j].Opcode)
+		break;
+
+	    Reg = CSNullSetRanges[j].Start + (Buffer[i + 1] << 2);
+	    End = Reg + 4 * (Length - 1);
+	    if ((Length < 2) || (End > CSNullSetRanges[j].End))
+		CSNullError(CS, Buffer, i, "SET packet beyond its range");
+	    break;
+	}
+
+	if ((i + 1 + Length) > Count) {
+	    CSNullError(CS, Buffer, i, "Packet runs past the end");
+	    break;
+	}
+
+	Null->Packets[Header >> 30]++;
+	i += 1 + Length;
+    }
+}
+
+/*
+ *
+ */
+static void
+CSNullFlush(struct RhdCS *CS)
+{
+    struct RhdCSNull *Null = CS->Private;
+
+    CSNullCheck(CS, CS->Buffer + CS->Flushed, CS->Wptr - CS->Flushed);
+
+    Null->Flushes++;
+    Null->Dwords += CS->Wptr - CS->Flushed;
+
+    CS->Flushed = CS->Wptr;
+#ifdef RHD_CS_DEBUG
+    CS->Grabbed = 0;
+#endif
+}
+
+/*
+ *
+ */
+static void
+CSNullGrab(struct RhdCS *CS, CARD32 Count)
+{
+    if ((CS->Size - CS->Wptr) < Count) {
+	if (CS->Flushed != CS->Wptr)
+	    CSNullFlush(CS);
+
+	CS->Flushed = 0;
+	CS->Wptr = 0;
+    }
+}
+
+/*
+ *
+ */
+static void
+CSNullStart(struct RhdCS *CS)
+{
+    struct RhdCSNull *Null = CS->Private;
+
+    Null->Flushes = 0;
+    Null->Dwords = 0;
+    Null->Packets[0] = 0;
+    Null->Packets[1] = 0;
+    Null->Packets[2] = 0;
+    Null->Packets[3] = 0;
+    Null->IBs = 0;
+    Null->IBDwords = 0;
+    Null->Errors = 0;
+}
+
+/*
+ *
+ */
+static void
+CSNullStop(struct RhdCS *CS)
+{
+    struct RhdCSNull *Null = CS->Private;
+
+    if (CS->Flushed != CS->Wptr)
+	CSNullFlush(CS);
+
+    xf86DrvMsg(CS->scrnIndex, X_INFO, "%s: %u flushes with %u dwords, "
+	       "%u indirect buffers with %u dwords.\n", __func__,
+	       (unsigned int) Null->Flushes, (unsigned int) Null->Dwords,
+	       (unsigned int) Null->IBs, (unsigned int) Null->IBDwords);
+    xf86DrvMsg(CS->scrnIndex, X_INFO, "%s: %u PACKET0, %u PACKET1, "
+	       "%u PACKET2, %u PACKET3, %u errors.\n", __func__,
+	       (unsigned int) Null->Packets[0], (unsigned int) Null->Packets[1],
+	       (unsigned int) Null->Packets[2], (unsigned int) Null->Packets[3],
+	       (unsigned int) Null->Errors);
+}
+
+#ifdef USE_DRI
+/*
+ *
+ */
+static struct _drmBuf *
+CSNullIBGet(struct RhdCS *CS)
+{
+    struct RhdCSNull *Null = CS->Private;
+    drmBufPtr Buffer;
+    int i;
+
+    for (i = 0; i < CS_NULL_IB_COUNT; i++)
+	if (!Null->IBInUse[i])
+	    break;
+
+    if (i == CS_NULL_IB_COUNT) {
+	xf86DrvMsg(CS->scrnIndex, X_ERROR,
+		   "%s: all %d buffers are in use.\n", __func__,
+		   CS_NULL_IB_COUNT);
+	return NULL;
+    }
+
+    Buffer = &Null->IBList[i];
+    if (!Buffer->address) {
+	Buffer->idx = i;
+	Buffer->total = 64 << 10;
+	Buffer->address = xnfcalloc(1, Buffer->total);
+    }
+    Buffer->used = 0;
+
+    Null->IBInUse[i] = TRUE;
+
+    return Buffer;
+}
+
+/*
+ *
+ */
+static void
+CSNullIBSubmit(struct RhdCS *CS, struct _drmBuf *Buffer)
+{
+    struct RhdCSNull *Null = CS->Private;
+
+    CSNullCheck(CS, Buffer->address, Buffer->used >> 2);
+
+    Null->IBs++;
+    Null->IBDwords += Buffer->used >> 2;
+
+    /* like the DRM, submission hands the buffer back */
+    Buffer->used = 0;
+    Null->IBInUse[Buffer->idx] = FALSE;
+}
+#endif /* USE_DRI */
+
+/*
+ *
+ */
+static void
+CSNullDestroy(struct RhdCS *CS)
+{
+    struct RhdCSNull *Null = CS->Private;
+#ifdef USE_DRI
+    int i;
+
+    for (i = 0; i < CS_NULL_IB_COUNT; i++)
+	if (Null->IBList[i].address)
+	    xfree(Null->IBList[i].address);
+#endif
+
+    xfree(Null);
+    CS->Private = NULL;
+
+    xfree(CS->Buffer);
+    CS->Buffer = NULL;
+    CS->Destroy = NULL;
+}
+
+/*
+ *
+ */
+static void
+CSNullInit(struct RhdCS *CS)
+{
+    RHDPtr rhdPtr = RHDPTRI(CS);
+    struct RhdCSNull *Null;
+
+    xf86DrvMsg(CS->scrnIndex, X_WARNING, "Using the Null Command Submission"
+	       " backend: nothing will be rendered by the engine!\n");
+
+    Null = xnfcalloc(1, sizeof(struct RhdCSNull));
+    Null->R6xx = (rhdPtr->ChipSet >= RHD_R600);
+    Null->MMIOSize = rhdPtr->MMIOMapSize ? rhdPtr->MMIOMapSize : 0x10000;
+
+    CS->Private = Null;
+
+    CS->Type = RHD_CS_NULL;
+
+    CS->Size = (64 << 10) / 4;
+    CS->Buffer = xnfcalloc(1, 4 * CS->Size);
+
+    CS->Grab = CSNullGrab;
+    CS->Flush = CSNullFlush;
+    CS->AdvanceFlush = FALSE;
+    CS->Idle = NULL;
+    CS->Start = CSNullStart;
+    CS->Reset = NULL;
+    CS->Stop = CSNullStop;
+    CS->Destroy = CSNullDestroy;
+#ifdef USE_DRI
+    CS->IBGet = CSNullIBGet;
+    CS->IBSubmit = CSNullIBSubmit;
+#endif
+}
+
+/*
+ *
+ * Command stream capture, for offline inspection with utils/cstrace.
+ *
+ * Whatever sits between TraceWptr and Wptr gets written out right before the
+ * backend gets its hands on it: the MMIO backend rewrites packet headers
+ * when it has to split up a run of registers. The PACKET2 padding the DRM
+ * backend adds to R6xx flushes is not recorded.
+ *
+ */
+struct RhdCSTrace {
+    FILE *File;
+    CARD32 Start;
+};
+
+/*
+ *
+ */
+static void
+CSTraceClose(struct RhdCS *CS)
+{
+    struct RhdCSTrace *Trace = CS->Trace;
+
+    if (!Trace)
+	return;
+
+    fclose(Trace->File);
+    xfree(Trace);
+    CS->Trace = NULL;
+}
+
+/*
+ *
+ */
+static void
+CSTraceOpen(struct RhdCS *CS, const char *Name, CARD32 Family)
+{
+    struct RhdCSTrace *Trace;
+    CARD32 Header[2];
+    FILE *File;
+
+    File = fopen(Name, "w");
+    if (!File) {
+	xf86DrvMsg(CS->scrnIndex, X_ERROR,
+		   "%s: Unable to open \"%s\" for writing.\n", __func__, Name);
+	return;
+    }
+
+    Header[0] = RHD_CS_TRACE_VERSION;
+    Header[1] = Family;
+
+    if ((fwrite(RHD_CS_TRACE_MAGIC, 8, 1, File) != 1) ||
+	(fwrite(Header, sizeof(Header), 1, File) != 1)) {
+	xf86DrvMsg(CS->scrnIndex, X_ERROR,
+		   "%s: Unable to write to \"%s\".\n", __func__, Name);
+	fclose(File);
+	return;
+    }
+
+    Trace = xnfcalloc(1, sizeof(struct RhdCSTrace));
+    Trace->File = File;
+    Trace->Start = GetTimeInMillis();
+
+    CS->Trace = Trace;
+
+    xf86DrvMsg(CS->scrnIndex, X_INFO,
+	       "Recording the command stream to \"%s\".\n", Name);
+}
+
+/*
+ *
+ */
+static void
+CSTraceRecord(struct RhdCS *CS, CARD32 Type, const char *Name,
+	      CARD32 *Data, CARD32 Count)
+{
+    struct RhdCSTrace *Trace = CS->Trace;
+    static const char Pad[4] = { 0, 0, 0, 0 };
+    CARD32 Header[4];
+    CARD32 Length = 0;
+
+    if (Name) {
+	Length = strlen(Name);
+	if (Length > RHD_CS_TRACE_NAME_MAX)
+	    Length = RHD_CS_TRACE_NAME_MAX;
+    }
+
+    Header[0] = Type;
+    Header[1] = GetTimeInMillis() - Trace->Start;
+    Header[2] = Count;
+    Header[3] = Length;
+
+    if ((fwrite(Header, sizeof(Header), 1, Trace->File) != 1) ||
+	(Length && (fwrite(Name, Length, 1, Trace->File) != 1)) ||
+	((Length & 3) && (fwrite(Pad, 4 - (Length & 3), 1, Trace->File) != 1)) ||
+	(fwrite(Data, 4, Count, Trace->File) != Count)) {
+	xf86DrvMsg(CS->scrnIndex, X_ERROR,
+		   "%s: Write failed, no longer recording.\n", __func__);
+	CSTraceClose(CS);
+    }
+}
+
+/*
+ *
+ */
+static void
+CSTraceStream(struct RhdCS *CS)
+{
+    const char *Func = NULL;
+
+#ifdef RHD_CS_DEBUG
+    Func = CS->Func;
+#endif
+
+    if (CS->Wptr > CS->TraceWptr)
+	CSTraceRecord(CS, RHD_CS_TRACE_STREAM, Func,
+		      CS->Buffer + CS->TraceWptr, CS->Wptr - CS->TraceWptr);
+}
+
+/*
+ * Out of line version of the Grab, for when we are recording.
+ */
+void
+RHDCSTraceGrab(struct RhdCS *CS, CARD32 Count)
+{
+    CSTraceStream(CS);
+
+    CS->Grab(CS, Count);
+    CS->TraceWptr = CS->Wptr;
+}
+
 /*
  *
  * Actual highlevel Command Submission.
@@ -519,8 +1102,15 @@ RHDCSFlush(struct RhdCS *CS)
 		   (unsigned int) CS->Grabbed, CS->Func);
 #endif
 
-    if (CS->Flushed != CS->Wptr)
+    if (CS->Flushed != CS->Wptr) {
+	if (CS->Trace)
+	    CSTraceStream(CS);
+	/* backend padding goes through RHDCSGrab, do not record all this twice */
+	CS->TraceWptr = CS->Wptr;
+
 	CS->Flush(CS);
+	CS->TraceWptr = CS->Wptr;
+    }
 }
 
 /*
@@ -529,6 +1119,9 @@ RHDCSFlush(struct RhdCS *CS)
 Bool
 RHDCSIdle(struct RhdCS *CS)
 {
+    CARD32 Start;
+    Bool ret;
+
 #ifdef RHD_CS_DEBUG
     if (!CS->Active) {
 	xf86DrvMsg(CS->scrnIndex, X_ERROR, "%s: CS is not active!\n",
@@ -537,12 +1130,92 @@ RHDCSIdle(struct RhdCS *CS)
     }
 #endif
 
-    if (CS->Idle)
-	return CS->Idle(CS);
+    if (!CS->Idle)
+	return TRUE;
+
+    Start = GetTimeInMillis();
+    ret = CS->Idle(CS);
+    CS->WaitCount++;
+    CS->WaitTime += GetTimeInMillis() - Start;
+
+    return ret;
+}
+
+/*
+ * Flushes, and hands out a fence for everything that was submitted so far.
+ * 0 means the backend has no fences, RHDCSFenceWait then idles the engine.
+ */
+CARD32
+RHDCSFenceEmit(struct RhdCS *CS)
+{
+    RHDCSFlush(CS);
+
+    if (!CS->FenceEmit)
+	return 0;
 
+    CS->FenceLast = CS->FenceEmit(CS);
+    return CS->FenceLast;
+}
+
+/*
+ *
+ */
+Bool
+RHDCSFenceWait(struct RhdCS *CS, CARD32 Fence)
+{
+    CARD32 Start;
+    Bool ret;
+
+    if (!Fence || !CS->FenceWait)
+	return RHDCSIdle(CS);
+
+    /* already seen this one pass */
+    if ((int) (CS->FenceDone - Fence) >= 0)
+	return TRUE;
+
+    Start = GetTimeInMillis();
+    ret = CS->FenceWait(CS, Fence);
+    CS->WaitCount++;
+    CS->WaitTime += GetTimeInMillis() - Start;
+
+    if (!ret)
+	return RHDCSIdle(CS);
+
+    CS->FenceDone = Fence;
     return TRUE;
 }
 
+#ifdef USE_DRI
+/*
+ * Indirect buffers which get filled outside of struct RhdCS (R6xx). The
+ * buffer is handed back to the backend on submission.
+ */
+struct _drmBuf *
+RHDCSIBGet(struct RhdCS *CS)
+{
+    if (!CS->IBGet) {
+	xf86DrvMsg(CS->scrnIndex, X_ERROR, "%s: Command Submission backend"
+		   " has no indirect buffers.\n", __func__);
+	return NULL;
+    }
+
+    return CS->IBGet(CS);
+}
+
+/*
+ *
+ */
+void
+RHDCSIBSubmit(struct RhdCS *CS, struct _drmBuf *Buffer)
+{
+    if (CS->Trace && Buffer->used)
+	CSTraceRecord(CS, RHD_CS_TRACE_IB, NULL, Buffer->address,
+		      Buffer->used >> 2);
+
+    CS->IBSubmit(CS, Buffer);
+}
+#endif /* USE_DRI */
+
 /*
  *
  */
@@ -562,6 +1235,7 @@ RHDCSStart(struct RhdCS *CS)
 
     CS->Flushed = 0;
     CS->Wptr = 0;
+    CS->TraceWptr = 0;
 #ifdef RHD_CS_DEBUG
     CS->Grabbed = 0;
 #endif
@@ -610,10 +1284,23 @@ RHDCSStop(struct RhdCS *CS)
 		   (unsigned int) CS->Grabbed, CS->Func);
 #endif
 
+    if (CS->Trace) {
+	CSTraceStream(CS);
+	fflush(CS->Trace->File);
+    }
+
     CS->Stop(CS);
 
+    if (CS->WaitCount)
+	xf86DrvMsg(CS->scrnIndex, X_INFO, "%s: Waited on the engine %u times,"
+		   " for %ums in total.\n", __func__,
+		   (unsigned int) CS->WaitCount, (unsigned int) CS->WaitTime);
+    CS->WaitCount = 0;
+    CS->WaitTime = 0;
+
     CS->Flushed = 0;
     CS->Wptr = 0;
+    CS->TraceWptr = 0;
 #ifdef RHD_CS_DEBUG
     CS->Grabbed = 0;
 #endif
@@ -629,19 +1316,39 @@ RHDCSInit(ScrnInfoPtr pScrn)
 {
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct RhdCS *CS = xnfcalloc(1, sizeof(struct RhdCS));
+    char *Backend = NULL;
 
     CS->scrnIndex = pScrn->scrnIndex;
 
     rhdPtr->CS = CS;
 
+    if (rhdPtr->csTrace.set && rhdPtr->csTrace.val.string)
+	CSTraceOpen(CS, rhdPtr->csTrace.val.string,
+		    (rhdPtr->ChipSet >= RHD_R600) ?
+		    RHD_CS_TRACE_R6XX : RHD_CS_TRACE_R5XX);
+
+    if (rhdPtr->csBackend.set && rhdPtr->csBackend.val.string) {
+	Backend = rhdPtr->csBackend.val.string;
+
+	if (!strcasecmp(Backend, "null")) {
+	    CSNullInit(CS);
+	    return;
+	} else if (strcasecmp(Backend, "mmio")) {
+	    xf86DrvMsg(pScrn->scrnIndex, X_WARNING, "%s: Unknown Command "
+		       "Submission backend \"%s\".\n", __func__, Backend);
+	    Backend = NULL;
+	}
+    }
+
 #ifdef USE_DRI
-    if (CSDRMCPInit(CS))
+    if (!Backend && CSDRMCPInit(CS))
 	return;
 #endif
 
     if (rhdPtr->ChipSet >= RHD_R600) {
 	xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
 		   "%s: CS for R600 requires DRI.\n", __func__);
+	CSTraceClose(CS);
 	xfree(CS);
 	rhdPtr->CS = NULL;
 	return;
@@ -663,6 +1370,8 @@ RHDCSDestroy(ScrnInfoPtr pScrn)
     if (CS->Destroy)
 	CS->Destroy(CS);
 
+    CSTraceClose(CS);
+
     xfree(CS);
     RHDPTR(pScrn)->CS = NULL;
 }
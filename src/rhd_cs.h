@@ -39,9 +39,12 @@ enum RhdCSType {
     RHD_CS_NONE = 0,
     RHD_CS_MMIO,
     RHD_CS_CP, /* CP but without the GART (Direct CP) */
-    RHD_CS_CPDMA /* CP with kernel support (DRM or indirect CP) */
+    RHD_CS_CPDMA, /* CP with kernel support (DRM or indirect CP) */
+    RHD_CS_NULL /* no engine at all: only checks the stream (testing) */
 };
 
+struct _drmBuf;
+
 struct RhdCS {
     int scrnIndex;
 
@@ -76,12 +79,30 @@ struct RhdCS {
     Bool AdvanceFlush; /* flush the buffer all the time? */
     Bool (*Idle) (struct RhdCS *CS);
 
+    /* fences are optional, see RHDCSFenceEmit() */
+    CARD32 (*FenceEmit) (struct RhdCS *CS);
+    Bool (*FenceWait) (struct RhdCS *CS, CARD32 Fence);
+    CARD32 FenceLast;
+    CARD32 FenceDone;
+
+    /* how often and for how long (ms) we sat waiting on the engine */
+    CARD32 WaitCount;
+    CARD32 WaitTime;
+
     void (*Start) (struct RhdCS *CS);
     void (*Reset) (struct RhdCS *CS);
     void (*Stop) (struct RhdCS *CS);
 
     void (*Destroy) (struct RhdCS *CS);
 
+    /* separate indirect buffers (R6xx), see RHDCSIBGet() */
+    struct _drmBuf *(*IBGet) (struct RhdCS *CS);
+    void (*IBSubmit) (struct RhdCS *CS, struct _drmBuf *Buffer);
+
+    /* capture of everything that passes through, see CSTraceOpen() */
+    struct RhdCSTrace *Trace;
+    CARD32 TraceWptr;
+
     void *Private; /* holds MMIO or direct/indirect CP specific information */
 };
 
@@ -109,6 +130,8 @@ struct _drmBuf *RHDDRMCPBuffer(int scrnIndex);
  */
 void RHDCSFlush(struct RhdCS *CS);
 Bool RHDCSIdle(struct RhdCS *CS);
+CARD32 RHDCSFenceEmit(struct RhdCS *CS);
+Bool RHDCSFenceWait(struct RhdCS *CS, CARD32 Fence);
 void RHDCSStart(struct RhdCS *CS);
 void RHDCSReset(struct RhdCS *CS);
 void RHDCSStop(struct RhdCS *CS);
@@ -116,6 +139,13 @@ void RHDCSStop(struct RhdCS *CS);
 void RHDCSInit(ScrnInfoPtr pScrn);
 void RHDCSDestroy(ScrnInfoPtr pScrn);
 
+void RHDCSTraceGrab(struct RhdCS *CS, CARD32 Count);
+
+#ifdef USE_DRI
+struct _drmBuf *RHDCSIBGet(struct RhdCS *CS);
+void RHDCSIBSubmit(struct RhdCS *CS, struct _drmBuf *Buffer);
+#endif
+
 /*
  * I seriously dislike big macros. They make code unreadable and they invite
  * others to make it even more unreadable. But i also cannot deny the numbers
@@ -125,7 +155,10 @@ void RHDCSDestroy(ScrnInfoPtr pScrn);
 do { \
     if ((CS->Clean == RHD_CS_CLEAN_QUEUED) || (CS->Clean == RHD_CS_CLEAN_UNTOUCHED)) \
 	CS->Clean = RHD_CS_CLEAN_DONE; \
-    CS->Grab(CS, Count); \
+    if (CS->Trace) \
+	RHDCSTraceGrab(CS, Count); \
+    else \
+	CS->Grab(CS, Count); \
 } while (0)
 
 #ifdef RHD_CS_DEBUG
@@ -141,6 +174,9 @@ do { \
     (CS)->Buffer[(CS)->Wptr++] = CP_PACKET0((Reg), 1); \
     (CS)->Buffer[(CS)->Wptr++] = (Value); \
 } while (0)
+/* Count consecutive registers from Reg on; follow up with Count RHDCSWrites */
+#define RHDCSRegWriteRun(CS, Reg, Count) \
+    (CS)->Buffer[(CS)->Wptr++] = CP_PACKET0((Reg), (Count))
 
 #define RHDCSAdvance(CS) \
 do { \
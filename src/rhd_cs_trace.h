@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Layout of the command stream trace files written by rhd_cs.c and read
+ * by utils/cstrace. Shared between the driver and the utility, so keep this
+ * free of any X server types.
+ *
+ * All fields are 32bit words in host byte order.
+ *
+ * File header:
+ *   RHD_CS_TRACE_MAGIC (8 bytes), version, family.
+ *
+ * Then, one record per chunk of submitted commands:
+ *   type, time (ms since the trace was opened), dword count, name length,
+ *   name (padded to a multiple of 4 bytes, not terminated), dwords.
+ */
+#ifndef _HAVE_RHD_CS_TRACE_
+#define _HAVE_RHD_CS_TRACE_ 1
+
+#define RHD_CS_TRACE_MAGIC   "RHDCSTRC"
+#define RHD_CS_TRACE_VERSION 1
+
+/* family: which set of registers and packets to decode with */
+#define RHD_CS_TRACE_R5XX    0
+#define RHD_CS_TRACE_R6XX    1
+
+/* record types */
+#define RHD_CS_TRACE_STREAM  1 /* RHDCSWrite/RHDCSRegWrite through struct RhdCS */
+#define RHD_CS_TRACE_IB      2 /* R6xx indirect buffer */
+
+#define RHD_CS_TRACE_NAME_MAX 64
+
+#endif /* _HAVE_RHD_CS_TRACE_ */
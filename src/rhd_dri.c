@@ -103,6 +103,7 @@
 #define RHD_DEFAULT_BUFFER_SIZE     2	/* MB (must be page aligned) */
 #define RHD_DEFAULT_CP_TIMEOUT      100000  /* usecs */
 #define RHD_DEFAULT_PCI_APER_SIZE   32	/* in MB */
+#define RHD_BUFFER_POOL_SIZE        4	/* indirect buffers kept at hand */
 
 #define RADEON_MAX_DRAWABLES        256
 
@@ -176,6 +177,9 @@ struct rhdDri {
     drmAddress        buf;              /* Map */
     int               bufNumBufs;       /* Number of buffers */
     drmBufMapPtr      buffers;          /* Buffer map */
+    drmBufPtr         bufPool[RHD_BUFFER_POOL_SIZE]; /* Already ours */
+    int               bufPoolCount;
+    Bool              bufPoolStopped;   /* Between LeaveVT and EnterVT */
 
     /* CP GART Texture data */
     unsigned long     gartTexStart;      /* Offset into GART space */
@@ -222,6 +226,8 @@ static void RHDDRITransitionTo2d(ScreenPtr pScreen);
 static void RHDDRITransitionTo3d(ScreenPtr pScreen);
 static void RHDDRITransitionMultiToSingle3d(ScreenPtr pScreen);
 static void RHDDRITransitionSingleToMulti3d(ScreenPtr pScreen);
+static void RHDDRIBufferPoolFill(ScrnInfoPtr pScrn);
+static void RHDDRIBufferPoolRelease(ScrnInfoPtr pScrn);
 
 
 /* Compute log base 2 of val */
@@ -452,6 +458,12 @@ static void RHDLeaveServer(ScreenPtr pScreen)
 
 	CS->Clean = RHD_CS_CLEAN_DIRTY;
     }
+
+    /* Stock up on buffers while we are idle anyway. This only goes to the
+     * kernel when scratch register 1 says that all it dispatched has
+     * retired, so that it cannot spin on a pending buffer; otherwise the
+     * next RHDDRMCPBuffer() tries again. */
+    RHDDRIBufferPoolFill(pScrn);
 }
 
 /* Contexts can be swapped by the X server if necessary.  This callback
@@ -1633,6 +1645,8 @@ void RHDDRIEnterVT(ScreenPtr pScreen)
     if ( (ret = drmCommandNone(rhdDRI->drmFD, DRM_RADEON_CP_RESUME)) )
 	xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
 		   "%s: CP resume %d\n", __func__, ret);
+
+    rhdDRI->bufPoolStopped = FALSE;
 }
 
 /* Stop all before vt switch / suspend */
@@ -1650,6 +1664,11 @@ void RHDDRILeaveVT(ScreenPtr pScreen)
     RHDDRISetVBlankInterrupt (pScrn, FALSE);
     DRILock(pScrn->pScreen, 0);
 
+    /* CP resume resets the freelist, don't hang on to stale buffers, and
+     * don't let the engine idle and CS stop that follow refill the pool */
+    rhdDRI->bufPoolStopped = TRUE;
+    RHDDRIBufferPoolRelease(pScrn);
+
     /* Backup the PCIE GART TABLE from fb memory */
     if (rhdDRI->pciGartBackup)
 	memcpy(rhdDRI->pciGartBackup,
@@ -1691,6 +1710,7 @@ Bool RHDDRICloseScreen(ScreenPtr pScreen)
     rhdDRI->gartLocation  = 0;
 
     /* De-allocate vertex buffers */
+    RHDDRIBufferPoolRelease(pScrn);
     if (rhdDRI->buffers) {
 	drmUnmapBufs(rhdDRI->buffers);
 	rhdDRI->buffers = NULL;
@@ -1889,19 +1909,119 @@ RHDDRMFDGet(int scrnIndex)
 	return Dri->drmFD;
 }
 
+/*
+ * Has the engine passed everything the kernel dispatched so far? The kernel
+ * writes the age of each dispatch to scratch register 1.
+ */
+static Bool
+RHDDRIDispatchRetired(ScrnInfoPtr pScrn)
+{
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    drm_radeon_sarea_t *pSAREAPriv =
+	(drm_radeon_sarea_t *) DRIGetSAREAPrivate(pScrn->pScreen);
+    CARD32 Age;
+
+    if (rhdPtr->ChipSet >= RHD_R600)
+	Age = RHDRegRead(rhdPtr, R6XX_SCRATCH_REG1);
+    else
+	Age = RHDRegRead(rhdPtr, R5XX_SCRATCH_REG1);
+
+    return ((int) (Age - pSAREAPriv->last_dispatch)) >= 0;
+}
+
+/*
+ * Grab a handful of indirect buffers in one go. The kernel only hands out
+ * buffers whose age has retired, and it fills in the indices one by one,
+ * so a partial grant leaves us with whatever it got to before giving up.
+ *
+ * Before giving up, the kernel spins for a while on a buffer that is still
+ * pending, so only ask for several when nothing dispatched is outstanding.
+ */
+static void
+RHDDRIBufferPoolFill(ScrnInfoPtr pScrn)
+{
+    struct rhdDri *Dri = RHDPTR(pScrn)->dri;
+    int indx[RHD_BUFFER_POOL_SIZE];
+    int size[RHD_BUFFER_POOL_SIZE];
+    drmDMAReq dma;
+    int i;
+
+    if (!Dri->buffers || !pScrn->vtSema || Dri->bufPoolStopped ||
+	(Dri->bufPoolCount == RHD_BUFFER_POOL_SIZE))
+	return;
+
+    if (!RHDDRIDispatchRetired(pScrn))
+	return;
+
+    for (i = 0; i < RHD_BUFFER_POOL_SIZE; i++)
+	indx[i] = -1;
+
+    /* This is the X server's context */
+    dma.context = 0x00000001;
+    dma.send_count    = 0;
+    dma.send_list     = NULL;
+    dma.send_sizes    = NULL;
+    dma.flags         = 0;
+    dma.request_count = RHD_BUFFER_POOL_SIZE - Dri->bufPoolCount;
+    dma.request_size  = 64 << 10;
+    dma.request_list  = indx;
+    dma.request_sizes = size;
+    dma.granted_count = 0;
+
+    drmDMA(Dri->drmFD, &dma);
+
+    for (i = 0; (i < dma.request_count) && (indx[i] >= 0); i++)
+	Dri->bufPool[Dri->bufPoolCount++] = &Dri->buffers->list[indx[i]];
+}
+
+/*
+ * Hand the buffers we are sitting on back to the kernel.
+ */
+static void
+RHDDRIBufferPoolRelease(ScrnInfoPtr pScrn)
+{
+    struct rhdDri *Dri = RHDPTR(pScrn)->dri;
+    struct drm_radeon_indirect indirect;
+
+    while (Dri->bufPoolCount) {
+	drmBufPtr buf = Dri->bufPool[--Dri->bufPoolCount];
+
+	indirect.idx = buf->idx;
+	indirect.start = 0;
+	indirect.end = 0;
+	indirect.discard = 1;
+
+	drmCommandWriteRead(Dri->drmFD, DRM_RADEON_INDIRECT,
+			    &indirect, sizeof(struct drm_radeon_indirect));
+    }
+}
+
 /*
  * Get an indirect buffer for the CP 2D acceleration commands
  */
 struct _drmBuf *
 RHDDRMCPBuffer(int scrnIndex)
 {
-    struct rhdDri *Dri = RHDPTR(xf86Screens[scrnIndex])->dri;
+    ScrnInfoPtr pScrn = xf86Screens[scrnIndex];
+    struct rhdDri *Dri = RHDPTR(pScrn)->dri;
     drmDMAReq dma;
     drmBufPtr buf = NULL;
     int indx = 0;
     int size = 0;
     int i;
 
+    /* stock up while the engine is not holding on to anything */
+    if (!Dri->bufPoolCount)
+	RHDDRIBufferPoolFill(pScrn);
+
+    if (Dri->bufPoolCount) {
+	buf = Dri->bufPool[--Dri->bufPoolCount];
+	buf->used = 0;
+	return buf;
+    }
+
+    /* the kernel is short on buffers: wait for one to retire */
+
     /* This is the X server's context */
     dma.context = 0x00000001;
     dma.send_count    = 0;
@@ -126,6 +126,8 @@
 #include "rhd_card.h"
 #include "rhd_randr.h"
 #include "rhd_cs.h"
+#include "rhd_prof.h"
+#include "rhd_swap.h"
 #include "rhd_audio.h"
 #include "rhd_pm.h"
 #include "r5xx_accel.h"
@@ -269,7 +271,11 @@ typedef enum {
     OPTION_HDMI,
     OPTION_COHERENT,
     OPTION_FORCE_LOW_POWER,
-    OPTION_LOW_POWER_CLOCK
+    OPTION_LOW_POWER_CLOCK,
+    OPTION_TILED_PIXMAPS,
+    OPTION_CS_TRACE,     /* only for debugging, don't document in man page! */
+    OPTION_CS_BACKEND,   /* only for testing, don't document in man page! */
+    OPTION_PROFILE       /* only for debugging, don't document in man page! */
 } RHDOpts;
 
 static const OptionInfoRec RHDOptions[] = {
@@ -302,6 +308,10 @@ static const OptionInfoRec RHDOptions[] = {
     { OPTION_COHERENT,             "COHERENT",		   OPTV_ANYSTR,  {0}, FALSE },
     { OPTION_FORCE_LOW_POWER,      "ForceLowPowerMode",    OPTV_BOOLEAN, {0}, FALSE },
     { OPTION_LOW_POWER_CLOCK,      "LowPowerModeEngineClock", OPTV_INTEGER, {0}, FALSE },
+    { OPTION_TILED_PIXMAPS,        "TiledPixmaps",         OPTV_BOOLEAN, {0}, FALSE },
+    { OPTION_CS_TRACE,             "CSTrace",              OPTV_ANYSTR,  {0}, FALSE },
+    { OPTION_CS_BACKEND,           "CSBackend",            OPTV_ANYSTR,  {0}, FALSE },
+    { OPTION_PROFILE,              "Profile",              OPTV_BOOLEAN, {0}, FALSE },
     { -1, NULL, OPTV_NONE,	{0}, FALSE }
 };
 
@@ -1206,6 +1216,9 @@ RHDScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
     if (rhdPtr->CS)
 	RHDCSStart(rhdPtr->CS);
 
+    RHDProfInit(pScrn, pScreen);
+    RHDSwapInit(pScrn);
+
     /* Init 2D after DRI is set up */
     switch (rhdPtr->AccelMethod) {
     case RHD_ACCEL_SHADOWFB:
@@ -1378,9 +1391,13 @@ rhdEngineIdle(ScrnInfoPtr pScrn)
 
     if (rhdPtr->TwoDPrivate) {
 #ifdef USE_DRI
-	if (rhdPtr->ChipSet >= RHD_R600)
+	if (rhdPtr->ChipSet >= RHD_R600) {
+	    R600IBRelease(pScrn);
 	    R6xxIdle(pScrn);
-	else
+	} else if (rhdPtr->AccelMethod == RHD_ACCEL_EXA) {
+	    R5xx2DIdle(pScrn);
+	    R5xxEXAUploadReset(pScrn);
+	} else
 #endif /* USE_DRI */
 	    R5xx2DIdle(pScrn);
     }
@@ -1422,6 +1439,8 @@ RHDCloseScreen(int scrnIndex, ScreenPtr pScreen)
     if ((rhdPtr->ChipSet < RHD_R600) && rhdPtr->ThreeDPrivate)
 	R5xx3DDestroy(pScrn);
 
+    RHDProfCloseScreen(pScreen);
+
     if (rhdPtr->CS)
 	RHDCSStop(rhdPtr->CS);
 
@@ -2877,6 +2896,14 @@ rhdProcessOptions(ScrnInfoPtr pScrn)
                         &rhdPtr->lowPowerMode, FALSE);
     RhdGetOptValInteger(rhdPtr->Options, OPTION_LOW_POWER_CLOCK,
                         &rhdPtr->lowPowerModeEngineClock, 0);
+    RhdGetOptValBool   (rhdPtr->Options, OPTION_TILED_PIXMAPS,
+			&rhdPtr->tiledPixmaps, FALSE);
+    RhdGetOptValString (rhdPtr->Options, OPTION_CS_TRACE,
+			&rhdPtr->csTrace, NULL);
+    RhdGetOptValString (rhdPtr->Options, OPTION_CS_BACKEND,
+			&rhdPtr->csBackend, NULL);
+    RhdGetOptValBool   (rhdPtr->Options, OPTION_PROFILE,
+			&rhdPtr->profile, FALSE);
 
 #ifdef ATOM_BIOS
     RhdGetOptValBool   (rhdPtr->Options, OPTION_USE_ATOMBIOS,
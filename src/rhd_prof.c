@@ -0,0 +1,552 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Per operation profiling of the acceleration code.
+ *
+ * Every operation, from its Prepare to its Done, is accounted to a key made
+ * up of the operation, a sub type (rop, render op, ...) and a format. For
+ * each key, we keep a log2 histogram of the CPU time spent, and, when the
+ * acceleration code provided us with a way to have the engine write out its
+ * clock counter, a log2 histogram of the time the engine spent.
+ *
+ * Engine timestamps are read back lazily, from the BlockHandler or when we
+ * run out of slots. Everything is dumped to the log on SIGUSR2 and when the
+ * screen is closed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+
+#if HAVE_XF86_ANSIC_H
+# include "xf86_ansic.h"
+#else
+# include <string.h>
+#endif
+
+#include <sys/time.h>
+#include <signal.h>
+
+#include "rhd.h"
+#include "rhd_prof.h"
+
+#define RHD_PROF_KEYS     64 /* distinct operation/sub/format combinations */
+#define RHD_PROF_BUCKETS  24 /* bucket n counts times from 2^n to 2^(n+1) - 1 */
+/* a timestamp which has not landed after this long, in usecs, never will */
+#define RHD_PROF_GPU_TIMEOUT 1000000
+
+struct RhdProfKey {
+    enum RhdProfOp Op;
+    CARD32 Sub;
+    CARD32 Format;
+
+    CARD32 Count;
+    CARD64 CPUTotal; /* usecs */
+    CARD32 CPUHist[RHD_PROF_BUCKETS];
+
+    CARD32 GPUCount;
+    CARD64 GPUTotal; /* engine clock counter ticks */
+    CARD32 GPUHist[RHD_PROF_BUCKETS];
+};
+
+struct RhdProf {
+    int scrnIndex;
+
+    struct RhdProfKey Keys[RHD_PROF_KEYS];
+    int KeyCount;
+    CARD32 Untracked; /* operations that found no free key */
+
+    int Current; /* key being timed, -1 if none */
+    int Last; /* for RHDProfResume() */
+    CARD64 Start;
+    int Slot; /* GPU slot of the current operation, -1 if none */
+
+    Bool HaveGPU;
+    struct RhdProfGPU GPU;
+    /* slots are handed out and read back in order */
+    struct {
+	int Key;
+	CARD32 Seq;
+	CARD64 Queued; /* CPU time, for RHD_PROF_GPU_TIMEOUT */
+    } Pending[RHD_PROF_GPU_SLOTS];
+    int PendingHead;
+    int PendingCount;
+    CARD32 Seq;
+    CARD32 GPUDropped;
+
+    int SignalCount;
+    BlockHandlerProcPtr BlockHandler;
+};
+
+static const struct {
+    const char *Name;
+    const char *Sub;
+    const char *Format;
+} ProfOps[RHD_PROF_OP_COUNT] = {
+    { "Solid",     "rop",    "bpp" },
+    { "Copy",      "rop",    "bpp" },
+    { "Composite", "op",     "format" },
+    { "Upload",    NULL,     "bpp" },
+    { "Download",  NULL,     "bpp" },
+    { "Xv",        "fourcc", NULL }
+};
+
+static volatile sig_atomic_t ProfSignalCount;
+static int ProfUsers;
+static struct sigaction ProfSignalSaved;
+
+/*
+ * Only count here: the dump itself happens from the BlockHandler.
+ */
+static void
+ProfSignal(int signal)
+{
+    ProfSignalCount++;
+}
+
+/*
+ *
+ */
+static CARD64
+ProfTime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (CARD64) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*
+ *
+ */
+static void
+ProfAccount(CARD32 *Hist, CARD64 *Total, CARD64 Value)
+{
+    CARD64 tmp = Value;
+    int i = 0;
+
+    while ((tmp >>= 1) && (i < (RHD_PROF_BUCKETS - 1)))
+	i++;
+
+    Hist[i]++;
+    *Total += Value;
+}
+
+/*
+ *
+ */
+static int
+ProfKey(struct RhdProf *Prof, enum RhdProfOp Op, CARD32 Sub, CARD32 Format)
+{
+    struct RhdProfKey *Key;
+    int i;
+
+    /* usually, the same thing gets done over and over again */
+    if (Prof->Last != -1) {
+	Key = &Prof->Keys[Prof->Last];
+	if ((Key->Op == Op) && (Key->Sub == Sub) && (Key->Format == Format))
+	    return Prof->Last;
+    }
+
+    for (i = 0; i < Prof->KeyCount; i++) {
+	Key = &Prof->Keys[i];
+	if ((Key->Op == Op) && (Key->Sub == Sub) && (Key->Format == Format))
+	    return i;
+    }
+
+    if (Prof->KeyCount == RHD_PROF_KEYS) {
+	Prof->Untracked++;
+	return -1;
+    }
+
+    Key = &Prof->Keys[Prof->KeyCount];
+    Key->Op = Op;
+    Key->Sub = Sub;
+    Key->Format = Format;
+
+    return Prof->KeyCount++;
+}
+
+/*
+ * Collect whatever the engine has finished with by now. A slot which does
+ * not land, because its IB was discarded or the engine was reset on a VT
+ * switch, would hold up all after it; it is dropped after a while.
+ */
+static void
+ProfGPURead(ScrnInfoPtr pScrn, struct RhdProf *Prof)
+{
+    struct RhdProfKey *Key;
+    volatile CARD32 *Slot;
+    CARD64 Begin, End, Now;
+
+    if (!Prof->HaveGPU || !Prof->PendingCount)
+	return;
+
+    Prof->GPU.Sync(pScrn);
+    Now = ProfTime();
+
+    while (Prof->PendingCount) {
+	Slot = (volatile CARD32 *) ((CARD8 *) Prof->GPU.Map +
+				    Prof->PendingHead * RHD_PROF_GPU_SLOT_SIZE);
+
+	if (Slot[4] == Prof->Pending[Prof->PendingHead].Seq) {
+	    Begin = Slot[0] | ((CARD64) Slot[1] << 32);
+	    End = Slot[2] | ((CARD64) Slot[3] << 32);
+
+	    Key = &Prof->Keys[Prof->Pending[Prof->PendingHead].Key];
+	    Key->GPUCount++;
+	    ProfAccount(Key->GPUHist, &Key->GPUTotal,
+			(End > Begin) ? (End - Begin) : 0);
+	} else if ((Now - Prof->Pending[Prof->PendingHead].Queued) >
+		   RHD_PROF_GPU_TIMEOUT)
+	    Prof->GPUDropped++;
+	else
+	    break;
+
+	Prof->PendingHead = (Prof->PendingHead + 1) % RHD_PROF_GPU_SLOTS;
+	Prof->PendingCount--;
+    }
+}
+
+/*
+ *
+ */
+static void
+ProfStart(ScrnInfoPtr pScrn, struct RhdProf *Prof, int Key)
+{
+    enum RhdProfOp Op;
+
+    Prof->Current = Key;
+    Prof->Slot = -1;
+
+    if (Key == -1)
+	return;
+
+    Prof->Start = ProfTime();
+
+    /* these wait for the engine anyway, the CPU time says it all */
+    Op = Prof->Keys[Key].Op;
+    if (!Prof->HaveGPU || (Op == RHD_PROF_UPLOAD) || (Op == RHD_PROF_DOWNLOAD))
+	return;
+
+    if (Prof->PendingCount == RHD_PROF_GPU_SLOTS)
+	ProfGPURead(pScrn, Prof);
+
+    if (Prof->PendingCount == RHD_PROF_GPU_SLOTS) {
+	Prof->GPUDropped++;
+	return;
+    }
+
+    Prof->Slot = (Prof->PendingHead + Prof->PendingCount) % RHD_PROF_GPU_SLOTS;
+    if (!Prof->GPU.Write(pScrn, Prof->GPU.Address + Prof->Slot * RHD_PROF_GPU_SLOT_SIZE,
+			 TRUE, 0)) {
+	Prof->GPUDropped++;
+	Prof->Slot = -1;
+    }
+}
+
+/*
+ * Called at the end of a successful Prepare, or whatever starts an
+ * operation.
+ */
+void
+RHDProfBegin(ScrnInfoPtr pScrn, enum RhdProfOp Op, CARD32 Sub, CARD32 Format)
+{
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+
+    if (!Prof)
+	return;
+
+    if (Prof->Current != -1)
+	RHDProfEnd(pScrn);
+
+    Prof->Last = ProfKey(Prof, Op, Sub, Format);
+    ProfStart(pScrn, Prof, Prof->Last);
+}
+
+/*
+ * An operation had to be drawn in several batches: pick up timing the
+ * same operation again after RHDProfEnd().
+ */
+void
+RHDProfResume(ScrnInfoPtr pScrn)
+{
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+
+    if (!Prof || (Prof->Current != -1) || (Prof->Last == -1))
+	return;
+
+    ProfStart(pScrn, Prof, Prof->Last);
+}
+
+/*
+ * Called once the operation has been fully queued up.
+ */
+void
+RHDProfEnd(ScrnInfoPtr pScrn)
+{
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+    struct RhdProfKey *Key;
+    CARD64 Address;
+
+    if (!Prof || (Prof->Current == -1))
+	return;
+
+    Key = &Prof->Keys[Prof->Current];
+    Key->Count++;
+    ProfAccount(Key->CPUHist, &Key->CPUTotal, ProfTime() - Prof->Start);
+
+    if (Prof->Slot != -1) {
+	Address = Prof->GPU.Address + Prof->Slot * RHD_PROF_GPU_SLOT_SIZE;
+
+	/* 0 is what the slots got cleared to */
+	Prof->Seq++;
+	if (!Prof->Seq)
+	    Prof->Seq++;
+
+	/* a sequence number which never lands would hold up all after it */
+	if (Prof->GPU.Write(pScrn, Address + 8, TRUE, 0) &&
+	    Prof->GPU.Write(pScrn, Address + 16, FALSE, Prof->Seq)) {
+	    Prof->Pending[Prof->Slot].Key = Prof->Current;
+	    Prof->Pending[Prof->Slot].Seq = Prof->Seq;
+	    Prof->Pending[Prof->Slot].Queued = ProfTime();
+	    Prof->PendingCount++;
+	} else
+	    Prof->GPUDropped++;
+    }
+
+    Prof->Current = -1;
+    Prof->Slot = -1;
+}
+
+/*
+ *
+ */
+static void
+ProfDumpHist(int scrnIndex, const char *Name, CARD32 *Hist)
+{
+    char Line[RHD_PROF_BUCKETS * 16];
+    int First, Last, i, Length = 0;
+
+    for (First = 0; First < RHD_PROF_BUCKETS; First++)
+	if (Hist[First])
+	    break;
+    if (First == RHD_PROF_BUCKETS)
+	return;
+
+    for (Last = RHD_PROF_BUCKETS - 1; Last > First; Last--)
+	if (Hist[Last])
+	    break;
+
+    for (i = First; i <= Last; i++)
+	Length += snprintf(Line + Length, sizeof(Line) - Length, " %d:%u",
+			   i, (unsigned int) Hist[i]);
+
+    xf86DrvMsg(scrnIndex, X_INFO, "        %s log2:%s\n", Name, Line);
+}
+
+/*
+ *
+ */
+void
+RHDProfDump(ScrnInfoPtr pScrn)
+{
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+    struct RhdProfKey *Key;
+    char Name[64], Engine[64];
+    int i, Length;
+
+    if (!Prof)
+	return;
+
+    if (pScrn->vtSema)
+	ProfGPURead(pScrn, Prof);
+
+    xf86DrvMsg(Prof->scrnIndex, X_INFO, "Acceleration profile: CPU times in "
+	       "usecs%s.\n", Prof->HaveGPU ? ", engine times in clock counter "
+	       "ticks" : "");
+
+    for (i = 0; i < Prof->KeyCount; i++) {
+	Key = &Prof->Keys[i];
+
+	Length = snprintf(Name, sizeof(Name), "%s", ProfOps[Key->Op].Name);
+	if (ProfOps[Key->Op].Sub)
+	    Length += snprintf(Name + Length, sizeof(Name) - Length, " %s %u",
+			       ProfOps[Key->Op].Sub, (unsigned int) Key->Sub);
+	if (ProfOps[Key->Op].Format)
+	    snprintf(Name + Length, sizeof(Name) - Length,
+		     (Key->Op == RHD_PROF_COMPOSITE) ? " %s 0x%08X" : " %s %u",
+		     ProfOps[Key->Op].Format, (unsigned int) Key->Format);
+
+	if (Key->GPUCount)
+	    snprintf(Engine, sizeof(Engine), ", engine %llu avg (%u timed)",
+		     (unsigned long long) (Key->GPUTotal / Key->GPUCount),
+		     (unsigned int) Key->GPUCount);
+	else
+	    Engine[0] = 0;
+
+	xf86DrvMsg(Prof->scrnIndex, X_INFO, "    %s: %u times, CPU %llu avg%s.\n",
+		   Name, (unsigned int) Key->Count, Key->Count ?
+		   (unsigned long long) (Key->CPUTotal / Key->Count) : 0ULL,
+		   Engine);
+
+	ProfDumpHist(Prof->scrnIndex, "CPU   ", Key->CPUHist);
+	ProfDumpHist(Prof->scrnIndex, "engine", Key->GPUHist);
+    }
+
+    if (Prof->Untracked)
+	xf86DrvMsg(Prof->scrnIndex, X_INFO, "    %u operations did not fit in "
+		   "the table.\n", (unsigned int) Prof->Untracked);
+    if (Prof->GPUDropped)
+	xf86DrvMsg(Prof->scrnIndex, X_INFO, "    %u operations were not timed "
+		   "on the engine.\n", (unsigned int) Prof->GPUDropped);
+}
+
+/*
+ * Engine timestamps get collected here, and this is where we act on SIGUSR2.
+ */
+static void
+ProfBlockHandler(int i, pointer blockData, pointer pTimeout, pointer pReadmask)
+{
+    ScreenPtr pScreen = screenInfo.screens[i];
+    ScrnInfoPtr pScrn = xf86Screens[i];
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+
+    pScreen->BlockHandler = Prof->BlockHandler;
+    (*pScreen->BlockHandler) (i, blockData, pTimeout, pReadmask);
+    pScreen->BlockHandler = ProfBlockHandler;
+
+    if (pScrn->vtSema)
+	ProfGPURead(pScrn, Prof);
+
+    if (Prof->SignalCount != ProfSignalCount) {
+	Prof->SignalCount = ProfSignalCount;
+	RHDProfDump(pScrn);
+    }
+}
+
+/*
+ *
+ */
+void
+RHDProfInit(ScrnInfoPtr pScrn, ScreenPtr pScreen)
+{
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct RhdProf *Prof;
+
+    if (!rhdPtr->profile.val.bool)
+	return;
+
+    Prof = xnfcalloc(1, sizeof(struct RhdProf));
+    Prof->scrnIndex = pScrn->scrnIndex;
+    Prof->Current = -1;
+    Prof->Last = -1;
+    Prof->Slot = -1;
+
+    if (!ProfUsers++) {
+	struct sigaction Action;
+
+	memset(&Action, 0, sizeof(Action));
+	Action.sa_handler = ProfSignal;
+	sigemptyset(&Action.sa_mask);
+	Action.sa_flags = SA_RESTART;
+	sigaction(SIGUSR2, &Action, &ProfSignalSaved);
+    }
+    Prof->SignalCount = ProfSignalCount;
+
+    Prof->BlockHandler = pScreen->BlockHandler;
+    pScreen->BlockHandler = ProfBlockHandler;
+
+    rhdPtr->Prof = Prof;
+
+    xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Profiling acceleration. Send "
+	       "SIGUSR2 to have the results logged.\n");
+}
+
+/*
+ * Dump what we have, and go.
+ */
+void
+RHDProfCloseScreen(ScreenPtr pScreen)
+{
+    ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+    RHDPtr rhdPtr = RHDPTR(pScrn);
+    struct RhdProf *Prof = rhdPtr->Prof;
+
+    if (!Prof)
+	return;
+
+    RHDProfDump(pScrn);
+
+    pScreen->BlockHandler = Prof->BlockHandler;
+
+    if (!--ProfUsers)
+	sigaction(SIGUSR2, &ProfSignalSaved, NULL);
+
+    xfree(Prof);
+    rhdPtr->Prof = NULL;
+}
+
+/*
+ * The acceleration code can have the engine time operations too.
+ */
+void
+RHDProfGPUInit(ScrnInfoPtr pScrn, struct RhdProfGPU *GPU)
+{
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+
+    if (!Prof)
+	return;
+
+    Prof->GPU = *GPU;
+
+    /* no stale sequence numbers */
+    memset(Prof->GPU.Map, 0, RHD_PROF_GPU_SIZE);
+    Prof->GPU.Sync(pScrn);
+
+    Prof->PendingHead = 0;
+    Prof->PendingCount = 0;
+    Prof->HaveGPU = TRUE;
+}
+
+/*
+ * Before the timestamp memory goes away. The engine should be idle.
+ */
+void
+RHDProfGPUFini(ScrnInfoPtr pScrn)
+{
+    struct RhdProf *Prof = RHDPTR(pScrn)->Prof;
+
+    if (!Prof || !Prof->HaveGPU)
+	return;
+
+    if (pScrn->vtSema)
+	ProfGPURead(pScrn, Prof);
+
+    Prof->GPUDropped += Prof->PendingCount;
+    Prof->PendingCount = 0;
+    Prof->Slot = -1;
+    Prof->HaveGPU = FALSE;
+}
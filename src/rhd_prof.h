@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Per operation profiling of the acceleration code.
+ */
+#ifndef _HAVE_RHD_PROF_
+#define _HAVE_RHD_PROF_ 1
+
+enum RhdProfOp {
+    RHD_PROF_SOLID = 0,
+    RHD_PROF_COPY,
+    RHD_PROF_COMPOSITE,
+    RHD_PROF_UPLOAD,
+    RHD_PROF_DOWNLOAD,
+    RHD_PROF_XV,
+    RHD_PROF_OP_COUNT
+};
+
+/*
+ * Card memory for the engine to write its timestamps to, handed to
+ * RHDProfGPUInit() by the acceleration code that knows how to do so.
+ */
+#define RHD_PROF_GPU_SLOTS     256
+#define RHD_PROF_GPU_SLOT_SIZE 32
+#define RHD_PROF_GPU_SIZE      (RHD_PROF_GPU_SLOTS * RHD_PROF_GPU_SLOT_SIZE)
+
+struct RhdProfGPU {
+    pointer Map;     /* CPU view */
+    CARD64 Address;  /* card internal address */
+
+    /*
+     * Have the engine write its 64bit clock counter (Timestamp), or the 32bit
+     * Value, to Address, once everything queued up before has drained.
+     * FALSE when this could not be queued up.
+     */
+    Bool (*Write) (ScrnInfoPtr pScrn, CARD64 Address, Bool Timestamp, CARD32 Value);
+    /* make sure what the engine wrote is seen by the CPU */
+    void (*Sync) (ScrnInfoPtr pScrn);
+};
+
+void RHDProfInit(ScrnInfoPtr pScrn, ScreenPtr pScreen);
+void RHDProfCloseScreen(ScreenPtr pScreen);
+void RHDProfGPUInit(ScrnInfoPtr pScrn, struct RhdProfGPU *GPU);
+void RHDProfGPUFini(ScrnInfoPtr pScrn);
+
+void RHDProfBegin(ScrnInfoPtr pScrn, enum RhdProfOp Op, CARD32 Sub, CARD32 Format);
+void RHDProfResume(ScrnInfoPtr pScrn);
+void RHDProfEnd(ScrnInfoPtr pScrn);
+void RHDProfDump(ScrnInfoPtr pScrn);
+
+#endif /* _HAVE_RHD_PROF_ */
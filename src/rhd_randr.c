@@ -1779,6 +1779,22 @@ RHDRRFreeShadow(ScrnInfoPtr pScrn)
 #endif
 }
 
+/*
+ * Rotated CRTCs scan out of a shadow pixmap in offscreen memory.
+ */
+Bool
+RHDRRPixmapIsShadow(ScrnInfoPtr pScrn, PixmapPtr pPixmap)
+{
+    int i;
+    xf86CrtcConfigPtr   CrtcConfig = XF86_CRTC_CONFIG_PTR(pScrn);
+
+    for (i = 0; i < CrtcConfig->num_crtc; i++)
+	if (CrtcConfig->crtc[i]->rotatedPixmap == pPixmap)
+	    return TRUE;
+
+    return FALSE;
+}
+
 static const xf86OutputFuncsRec rhdRROutputFuncs = {
     rhdRROutputCreateResources, rhdRROutputDpms,
     NULL, NULL,						/* Save,Restore */
@@ -2159,6 +2175,10 @@ Bool
 RHDRandrSwitchMode(ScrnInfoPtr pScrn, DisplayModePtr mode)
 { ASSERT(0); return FALSE; }
 
+Bool
+RHDRRPixmapIsShadow(ScrnInfoPtr pScrn, PixmapPtr pPixmap)
+{ ASSERT(0); return FALSE; }
+
 
 #endif /* RANDR_12_SUPPORT */
 
@@ -37,6 +37,7 @@ extern Bool RHDRandrScreenInit(ScreenPtr pScreen);
 extern Bool RHDRandrModeInit(ScrnInfoPtr pScrn);
 extern Bool RHDRandrSwitchMode(ScrnInfoPtr pScrn, DisplayModePtr mode);
 extern void RHDRRFreeShadow(ScrnInfoPtr pScrn);
+extern Bool RHDRRPixmapIsShadow(ScrnInfoPtr pScrn, PixmapPtr pPixmap);
 extern Bool RHDRRInitCursor(ScreenPtr pScreen);
 
 #endif
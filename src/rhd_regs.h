@@ -121,6 +121,7 @@ enum {
     R6XX_HDP_NONSURFACE_BASE       = 0x2C04,
     R6XX_CONFIG_MEMSIZE            = 0x5428,
     R6XX_CONFIG_FB_BASE            = 0x542C, /* AKA CONFIG_F0_BASE */
+    R6XX_SCRATCH_REG1              = 0x8504, /* DRM dma buffer ages */
     /* PCI config space */
     PCI_CONFIG_SPACE_BASE          = 0x5000,
     PCI_CAPABILITIES_PTR           = 0x5034,
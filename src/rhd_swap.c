@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Byte swapping copies, for feeding the engine on big endian hosts.
+ *
+ * The plain C versions work everywhere. When built for a CPU with AltiVec,
+ * RHDSwapInit() switches to versions that do 16 bytes at a time, provided
+ * the CPU we run on actually has it. Those live in rhd_altivec.c.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+
+#include "rhd.h"
+#include "rhd_swap.h"
+
+#if defined(USE_ALTIVEC) && defined(HAVE_GETAUXVAL)
+#include <sys/auxv.h>
+#endif
+
+/*
+ *
+ */
+void
+RHDCopySwap32C(CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    CARD32 *d = (CARD32 *) dst;
+    CARD32 *s = (CARD32 *) src;
+    unsigned int nwords = size >> 2;
+
+    for (; nwords > 0; --nwords, ++d, ++s)
+#ifdef __powerpc__
+	asm volatile("stwbrx %0,0,%1" : : "r" (*s), "r" (d));
+#else
+	*d = ((*s >> 24) & 0xff) | ((*s >> 8) & 0xff00)
+	    | ((*s & 0xff00) << 8) | ((*s & 0xff) << 24);
+#endif
+}
+
+/*
+ *
+ */
+void
+RHDCopySwapHDWC(CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    CARD32 *d = (CARD32 *) dst;
+    CARD32 *s = (CARD32 *) src;
+    unsigned int nwords = size >> 2;
+
+    for (; nwords > 0; --nwords, ++d, ++s)
+	*d = ((*s & 0xffff) << 16) | ((*s >> 16) & 0xffff);
+}
+
+/*
+ *
+ */
+void
+RHDCopySwap16C(CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    CARD16 *d = (CARD16 *) dst;
+    CARD16 *s = (CARD16 *) src;
+    unsigned int nwords = size >> 1;
+
+    for (; nwords > 0; --nwords, ++d, ++s)
+#ifdef __powerpc__
+	asm volatile("sthbrx %0,0,%1" : : "r" (*s), "r" (d));
+#else
+	*d = ((*s >> 8) & 0xff) | ((*s & 0xff) << 8);
+#endif
+}
+
+#ifdef USE_ALTIVEC
+/*
+ * Being built with -maltivec does not mean that we run on a G4 or later.
+ * When we cannot ask, stick to the plain C versions.
+ */
+Bool
+RHDHasAltivec(void)
+{
+#if defined(HAVE_GETAUXVAL) && defined(AT_HWCAP) && defined(PPC_FEATURE_HAS_ALTIVEC)
+    return (getauxval(AT_HWCAP) & PPC_FEATURE_HAS_ALTIVEC) ? TRUE : FALSE;
+#else
+    return FALSE;
+#endif
+}
+#endif /* USE_ALTIVEC */
+
+RHDCopySwapProc RHDCopySwap32 = RHDCopySwap32C;
+RHDCopySwapProc RHDCopySwapHDW = RHDCopySwapHDWC;
+RHDCopySwapProc RHDCopySwap16 = RHDCopySwap16C;
+
+/*
+ *
+ */
+void
+RHDSwapInit(ScrnInfoPtr pScrn)
+{
+#ifdef USE_ALTIVEC
+    if (RHDHasAltivec()) {
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Using AltiVec for byte swapping.\n");
+
+	RHDCopySwap32 = RHDCopySwap32Altivec;
+	RHDCopySwapHDW = RHDCopySwapHDWAltivec;
+	RHDCopySwap16 = RHDCopySwap16Altivec;
+    }
+#endif
+}
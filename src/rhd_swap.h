@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Byte swapping copies, for feeding the engine on big endian hosts.
+ */
+#ifndef _HAVE_RHD_SWAP_
+#define _HAVE_RHD_SWAP_ 1
+
+/*
+ * size is in bytes, only whole words (halfwords for Swap16) get copied.
+ * dst and src may be the same buffer, but must not overlap otherwise.
+ */
+typedef void (*RHDCopySwapProc) (CARD8 *dst, CARD8 *src, unsigned int size);
+
+extern RHDCopySwapProc RHDCopySwap32; /* ABCD -> DCBA */
+extern RHDCopySwapProc RHDCopySwapHDW; /* ABCD -> CDAB */
+extern RHDCopySwapProc RHDCopySwap16; /* ABCD -> BADC */
+
+void RHDSwapInit(ScrnInfoPtr pScrn);
+
+/* the plain C versions, also for what the vector versions leave over */
+void RHDCopySwap32C(CARD8 *dst, CARD8 *src, unsigned int size);
+void RHDCopySwapHDWC(CARD8 *dst, CARD8 *src, unsigned int size);
+void RHDCopySwap16C(CARD8 *dst, CARD8 *src, unsigned int size);
+
+#ifdef USE_ALTIVEC
+Bool RHDHasAltivec(void);
+
+/* rhd_altivec.c */
+void RHDCopySwap32Altivec(CARD8 *dst, CARD8 *src, unsigned int size);
+void RHDCopySwapHDWAltivec(CARD8 *dst, CARD8 *src, unsigned int size);
+void RHDCopySwap16Altivec(CARD8 *dst, CARD8 *src, unsigned int size);
+#endif
+
+#endif /* _HAVE_RHD_SWAP_ */
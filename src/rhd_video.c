@@ -47,6 +47,7 @@
 
 #include "rhd.h"
 #include "rhd_cs.h"
+#include "rhd_swap.h"
 
 #include "r5xx_regs.h"
 
@@ -54,6 +55,7 @@
 #include "r5xx_accel.h"
 
 #include "rhd_video.h"
+#include "rhd_xvpack.h"
 
 #include "xf86.h"
 #include "dixstruct.h"
@@ -311,21 +313,7 @@ rhdQueryImageAttributes(ScrnInfoPtr pScrn, int id, CARD16 *w, CARD16 *h,
  * Buffer swaps for big endian.
  */
 #if X_BYTE_ORDER == X_BIG_ENDIAN
-static inline void
-MemCopySwap32(CARD8 *dst, CARD8 *src, unsigned int size)
-{
-    unsigned int *d = (unsigned int *)dst;
-    unsigned int *s = (unsigned int *)src;
-    unsigned int nwords = size >> 2;
-
-    for (; nwords > 0; --nwords, ++d, ++s)
-#ifdef __powerpc__
-	asm volatile("stwbrx %0,0,%1" : : "r" (*s), "r" (d));
-#else
-        *d = ((*s >> 24) & 0xff) | ((*s >> 8) & 0xff00)
-	    | ((*s & 0xff00) << 8) | ((*s & 0xff) << 24);
-#endif
-}
+#define MemCopySwap32 RHDCopySwap32
 #else
 #define MemCopySwap32 memcpy
 #endif /* X_BYTE_ORDER */
@@ -415,6 +403,28 @@ R5xxXvCopyPacked(RHDPtr rhdPtr, CARD8 *src, CARD8 *dst,
 #endif
 }
 
+static R5xxXvPackLineProc R5xxXvPackLine = R5xxXvPackLineC;
+
+/*
+ *
+ */
+static void
+R5xxXvPackLineInit(ScrnInfoPtr pScrn)
+{
+#if defined(__SSE2__)
+    R5xxXvPackLine = R5xxXvPackLineSSE2;
+    xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Xv: Using SSE2 for YV12 packing.\n");
+#elif defined(RHD_XV_NEON)
+    R5xxXvPackLine = R5xxXvPackLineNEON;
+    xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Xv: Using NEON for YV12 packing.\n");
+#elif defined(USE_ALTIVEC)
+    if (RHDHasAltivec()) {
+	R5xxXvPackLine = R5xxXvPackLineAltivec;
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Xv: Using AltiVec for YV12 packing.\n");
+    }
+#endif
+}
+
 /*
  *
  */
@@ -424,32 +434,10 @@ R5xxXvCopyPlanarToPacked(CARD8 *dst, CARD16 dstPitch,
 			 CARD8 *src2, CARD16 src2Pitch,
 			 CARD8 *src3, CARD16 width, CARD16 height)
 {
-    int i, j;
+    int i;
 
     for (i = 0; i < height; i++) {
-	CARD32 *d = (CARD32 *) dst;
-	CARD8 *s1 = src1;
-	CARD8 *s2 = src2;
-	CARD8 *s3 = src3;
-
-	for (j = width / 2; j > 4; j -= 4) {
-	    d[0] = s1[0] | (s1[1] << 16) | (s3[0] << 8) | (s2[0] << 24);
-	    d[1] = s1[2] | (s1[3] << 16) | (s3[1] << 8) | (s2[1] << 24);
-	    d[2] = s1[4] | (s1[5] << 16) | (s3[2] << 8) | (s2[2] << 24);
-	    d[3] = s1[6] | (s1[7] << 16) | (s3[3] << 8) | (s2[3] << 24);
-	    d += 4;
-	    s2 += 4;
-	    s3 += 4;
-	    s1 += 8;
-	}
-
-	for (; j; j--) {
-	    d[0] = s1[0] | (s1[1] << 16) | (s3[0] << 8) | (s2[0] << 24);
-	    d++;
-	    s2++;
-	    s3++;
-	    s1 += 2;
-	}
+	R5xxXvPackLine((CARD32 *) dst, src1, src2, src3, width / 2);
 
 	dst += dstPitch;
 	src1 += src1Pitch;
@@ -683,6 +671,8 @@ rhdPutImageTextured(ScrnInfoPtr pScrn,
     RHDPtr rhdPtr = RHDPTR(pScrn);
     struct RHDPortPriv *pPriv = data;
     CARD8 *FBBuf;
+    Bool Planar;
+    int size;
 
     /*
      * First, make sure we can render to the drawable.
@@ -715,22 +705,48 @@ rhdPutImageTextured(ScrnInfoPtr pScrn,
 
     pPriv->pDraw = pDraw;
 
+    /*
+     * R500 3D engines sample the three 4:2:0 planes separately and convert
+     * in the fragment program. The R300 class IGPs still get packed YUY2.
+     */
+    Planar = (rhdPtr->ChipSet < RHD_R600) &&
+	(rhdPtr->ChipSet != RHD_RS600) && (rhdPtr->ChipSet != RHD_RS690) &&
+	(rhdPtr->ChipSet != RHD_RS740) &&
+	((id == FOURCC_YV12) || (id == FOURCC_I420));
+
     if (rhdPtr->ChipSet >= RHD_R600)
 	pPriv->BufferPitch = ALIGN(2 * width, 256);
+    else if (Planar)
+	pPriv->BufferPitch = ALIGN(width, 128);
     else
 	pPriv->BufferPitch = ALIGN(2 * width, 64);
 
+    if (Planar) {
+	int pitch2 = pPriv->BufferPitch >> 1;
+
+	/* hostdata blits need 1kB aligned destinations. Heights are even,
+	 * rhdQueryImageAttributes() sees to that, but do not rely on it. */
+	pPriv->BufferOffsetV = ALIGN(pPriv->BufferPitch * height, 1024);
+	pPriv->BufferOffsetU = pPriv->BufferOffsetV +
+	    ALIGN(pitch2 * ((height + 1) >> 1), 1024);
+	size = pPriv->BufferOffsetU + pitch2 * ((height + 1) >> 1);
+    } else {
+	pPriv->BufferOffsetU = 0;
+	pPriv->BufferOffsetV = 0;
+	size = 2 * pPriv->BufferPitch * height;
+    }
+
     /*
      * Now, find out whether we have enough memory available.
      */
     switch (rhdPtr->AccelMethod) {
 #ifdef USE_EXA
     case RHD_ACCEL_EXA:
-	rhdXvAllocateEXA(pScrn, pPriv, 2 * pPriv->BufferPitch * height);
+	rhdXvAllocateEXA(pScrn, pPriv, size);
 	break;
 #endif /* USE_EXA */
     case RHD_ACCEL_XAA:
-	rhdXvAllocateXAA(pScrn, pPriv, 2 * pPriv->BufferPitch * height);
+	rhdXvAllocateXAA(pScrn, pPriv, size);
 	break;
     default:
 	pPriv->BufferHandle = NULL;
@@ -764,7 +780,37 @@ rhdPutImageTextured(ScrnInfoPtr pScrn,
 	    int s2offset = srcPitch * height;
 	    int s3offset = s2offset + srcPitch2 * (height >> 1);
 
-	    if (id == FOURCC_YV12) {
+	    if (Planar) {
+		CARD8 *Ubuf, *Vbuf;
+
+		if (id == FOURCC_YV12) {
+		    Vbuf = buf + s2offset;
+		    Ubuf = buf + s3offset;
+		} else {
+		    Ubuf = buf + s2offset;
+		    Vbuf = buf + s3offset;
+		}
+
+		if (rhdPtr->CS->Type == RHD_CS_CPDMA) {
+		    R5xxXvCopyPackedDMA(rhdPtr, buf, FBBuf, srcPitch,
+					pPriv->BufferPitch, height);
+		    R5xxXvCopyPackedDMA(rhdPtr, Vbuf,
+					FBBuf + pPriv->BufferOffsetV, srcPitch2,
+					pPriv->BufferPitch >> 1, (height + 1) >> 1);
+		    R5xxXvCopyPackedDMA(rhdPtr, Ubuf,
+					FBBuf + pPriv->BufferOffsetU, srcPitch2,
+					pPriv->BufferPitch >> 1, (height + 1) >> 1);
+		} else {
+		    R5xxXvCopyPacked(rhdPtr, buf, FBBuf, srcPitch,
+				     pPriv->BufferPitch, height);
+		    R5xxXvCopyPacked(rhdPtr, Vbuf, FBBuf + pPriv->BufferOffsetV,
+				     srcPitch2, pPriv->BufferPitch >> 1,
+				     (height + 1) >> 1);
+		    R5xxXvCopyPacked(rhdPtr, Ubuf, FBBuf + pPriv->BufferOffsetU,
+				     srcPitch2, pPriv->BufferPitch >> 1,
+				     (height + 1) >> 1);
+		}
+	    } else if (id == FOURCC_YV12) {
 		if (rhdPtr->ChipSet >= RHD_R600) {
 		    pPriv->BufferPitch = ALIGN(width, 256);
 		    if (rhdPtr->cardType != RHD_CARD_AGP)
@@ -998,6 +1044,8 @@ RHDInitVideo(ScreenPtr pScreen)
 
     RHDFUNC(pScrn);
 
+    R5xxXvPackLineInit(pScrn);
+
     num_adaptors = xf86XVListGenericAdaptors(pScrn, &adaptors);
     newAdaptors = xalloc((num_adaptors + 2) * sizeof(XF86VideoAdaptorPtr *));
     if (newAdaptors == NULL)
@@ -1008,7 +1056,8 @@ RHDInitVideo(ScreenPtr pScreen)
 
     if (rhdPtr->TwoDPrivate && rhdPtr->CS &&
 	((rhdPtr->CS->Type == RHD_CS_CP) ||
-	 (rhdPtr->CS->Type == RHD_CS_CPDMA))) {
+	 (rhdPtr->CS->Type == RHD_CS_CPDMA) ||
+	 (rhdPtr->CS->Type == RHD_CS_NULL))) {
 
 	texturedAdaptor = rhdSetupImageTexturedVideo(pScreen);
 
@@ -47,6 +47,9 @@ struct RHDPortPriv {
     void *BufferHandle;
     CARD32 BufferOffset;
     CARD32 BufferPitch;
+    /* R500 planar 4:2:0: chroma planes, relative to BufferOffset */
+    CARD32 BufferOffsetU;
+    CARD32 BufferOffsetV;
 
     int id;
     int src_w;
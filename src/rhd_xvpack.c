@@ -0,0 +1,133 @@
+/*
+ * Copyright 2008  Luc Verhaegen <libv@exsuse.de>
+ * Copyright 2008  Matthias Hopf <mhopf@novell.com>
+ * Copyright 2008  Egbert Eich   <eich@novell.com>
+ * Copyright 2008  Alex Deucher <alexander.deucher@amd.com>
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * The Xv YV12 to YUY2 packing of a single line: the C version and the SSE2
+ * and NEON versions. These are kept apart from rhd_video.c so that
+ * utils/vectest can check them against each other. The AltiVec version
+ * lives in rhd_altivec.c.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+
+#include "rhd_xvpack.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(RHD_XV_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Packs a single line of luma (s1) and the two chroma planes (s2, s3) into
+ * YUY2, one dword per pair of pixels.
+ */
+void
+R5xxXvPackLineC(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs)
+{
+    for (; pairs > 4; pairs -= 4) {
+	d[0] = s1[0] | (s1[1] << 16) | (s3[0] << 8) | (s2[0] << 24);
+	d[1] = s1[2] | (s1[3] << 16) | (s3[1] << 8) | (s2[1] << 24);
+	d[2] = s1[4] | (s1[5] << 16) | (s3[2] << 8) | (s2[2] << 24);
+	d[3] = s1[6] | (s1[7] << 16) | (s3[3] << 8) | (s2[3] << 24);
+	d += 4;
+	s2 += 4;
+	s3 += 4;
+	s1 += 8;
+    }
+
+    for (; pairs; pairs--) {
+	d[0] = s1[0] | (s1[1] << 16) | (s3[0] << 8) | (s2[0] << 24);
+	d++;
+	s2++;
+	s3++;
+	s1 += 2;
+    }
+}
+
+/*
+ * The vector versions below do 16 pairs at a time and leave the rest of the
+ * line to the C version. They produce the very same bytes in memory as the
+ * C version does on the same host.
+ */
+#ifdef __SSE2__
+void
+R5xxXvPackLineSSE2(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs)
+{
+    for (; pairs >= 16; pairs -= 16) {
+	__m128i y0 = _mm_loadu_si128((__m128i *) s1);
+	__m128i y1 = _mm_loadu_si128((__m128i *) (s1 + 16));
+	__m128i c = _mm_loadu_si128((__m128i *) s3);
+	__m128i c2 = _mm_loadu_si128((__m128i *) s2);
+	__m128i uv0 = _mm_unpacklo_epi8(c, c2);
+	__m128i uv1 = _mm_unpackhi_epi8(c, c2);
+
+	_mm_storeu_si128((__m128i *) d, _mm_unpacklo_epi8(y0, uv0));
+	_mm_storeu_si128((__m128i *) (d + 4), _mm_unpackhi_epi8(y0, uv0));
+	_mm_storeu_si128((__m128i *) (d + 8), _mm_unpacklo_epi8(y1, uv1));
+	_mm_storeu_si128((__m128i *) (d + 12), _mm_unpackhi_epi8(y1, uv1));
+
+	d += 16;
+	s2 += 16;
+	s3 += 16;
+	s1 += 32;
+    }
+
+    R5xxXvPackLineC(d, s1, s2, s3, pairs);
+}
+#endif /* __SSE2__ */
+
+#ifdef RHD_XV_NEON
+void
+R5xxXvPackLineNEON(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs)
+{
+    for (; pairs >= 16; pairs -= 16) {
+	uint8x16x2_t uv = vzipq_u8(vld1q_u8(s3), vld1q_u8(s2));
+	uint8x16x2_t yuv;
+
+	/* vst2 interleaves luma and chroma bytes for us */
+	yuv.val[0] = vld1q_u8(s1);
+	yuv.val[1] = uv.val[0];
+	vst2q_u8((uint8_t *) d, yuv);
+
+	yuv.val[0] = vld1q_u8(s1 + 16);
+	yuv.val[1] = uv.val[1];
+	vst2q_u8((uint8_t *) (d + 8), yuv);
+
+	d += 16;
+	s2 += 16;
+	s3 += 16;
+	s1 += 32;
+    }
+
+    R5xxXvPackLineC(d, s1, s2, s3, pairs);
+}
+#endif /* RHD_XV_NEON */
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2008  Luc Verhaegen <libv@exsuse.de>
+ * Copyright 2008  Matthias Hopf <mhopf@novell.com>
+ * Copyright 2008  Egbert Eich   <eich@novell.com>
+ * Copyright 2008  Alex Deucher <alexander.deucher@amd.com>
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * YV12 to YUY2, one line of pairs of pixels, see rhd_xvpack.c.
+ */
+#ifndef _RHD_XVPACK_H
+#define _RHD_XVPACK_H 1
+
+#if !defined(__SSE2__) && (defined(__ARM_NEON__) || defined(__ARM_NEON)) && \
+    !defined(__ARMEB__) && !defined(__AARCH64EB__)
+/* vst2 interleaves in memory order, which only matches the C version on little endian */
+#define RHD_XV_NEON 1
+#endif
+
+typedef void (*R5xxXvPackLineProc) (CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3,
+				    int pairs);
+
+void R5xxXvPackLineC(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs);
+#ifdef __SSE2__
+void R5xxXvPackLineSSE2(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs);
+#endif
+#ifdef RHD_XV_NEON
+void R5xxXvPackLineNEON(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs);
+#endif
+#ifdef USE_ALTIVEC
+void R5xxXvPackLineAltivec(CARD32 *d, CARD8 *s1, CARD8 *s2, CARD8 *s3, int pairs); /* rhd_altivec.c */
+#endif
+
+#endif /* _RHD_XVPACK_H */
@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# Register runs of every length have to come out of the MMIO backend the
+# same, however few FIFO entries it gets at a time.
+#
+
+TRACE=register_runs.trace
+OUT=register_runs.out
+
+./cstrace_test -r $TRACE || exit 1
+
+for FIFO in 64 7 1; do
+    ./rhd_csreplay -f $FIFO $TRACE > $OUT || { cat $OUT; exit 1; }
+    grep -q "860 register writes to 46 registers" $OUT || { cat $OUT; exit 1; }
+    grep -q "Registers match" $OUT || { cat $OUT; exit 1; }
+done
+
+rm -f $TRACE $OUT
+exit 0
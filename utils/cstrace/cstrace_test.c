@@ -0,0 +1,234 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Drives the command stream recorder of src/rhd_cs.c through RHDCSGrab,
+ * RHDCSWrite and RHDCSFlush, with a backend which pads R6xx flushes up to
+ * 16 dwords the way the DRM backend does. Two flushes go out: 12 dwords,
+ * padded with 4, and 3 dwords, padded with 13. cstrace_test.sh then checks
+ * that rhd_cstrace finds each of them once, and none of the padding.
+ *
+ * With -r, an R5xx stream of register runs gets recorded instead, for
+ * csreplay_test.sh to push through the MMIO backend with rhd_csreplay.
+ *
+ * rhd_cs.c is built right into this test, without the DRM backend, so that
+ * no X server is needed. The few server functions it links against are
+ * stubbed out at the bottom.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#undef USE_DRI
+
+#include "xf86.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+/* keep the allocations away from the server */
+#undef xnfcalloc
+#define xnfcalloc(Num, Size) calloc((Num), (Size))
+#undef xfree
+#define xfree(Ptr) free(Ptr)
+
+#include "rhd_cs.c"
+
+#define TEST_BUFFER_SIZE 256
+#define TEST_RUN_MAX     40
+
+static CARD32 TestBuffer[TEST_BUFFER_SIZE];
+
+/*
+ *
+ */
+static void
+TestGrab(struct RhdCS *CS, CARD32 Count)
+{
+    if ((CS->Size - CS->Wptr) < Count) {
+	fprintf(stderr, "ERROR: %s: test buffer overflow.\n", __func__);
+	exit(1);
+    }
+}
+
+/*
+ * Pads like DRMCPFlush() does on R6xx, then hands the buffer over.
+ */
+static void
+TestFlush(struct RhdCS *CS)
+{
+    if (CS->Wptr & 0xF) {
+	CARD32 Pad = 0x10 - (CS->Wptr & 0xF);
+
+	RHDCSGrab(CS, Pad);
+	while (Pad--)
+	    RHDCSWrite(CS, CP_PACKET2());
+    }
+
+    /* make sure we are quadword aligned */
+    if (CS->Wptr & 1)
+	CS->Wptr++;
+
+    CS->Flushed = CS->Wptr;
+}
+
+/*
+ * The MMIO backend takes the whole buffer each time.
+ */
+static void
+TestRunsFlush(struct RhdCS *CS)
+{
+    CS->Wptr = 0;
+    CS->Flushed = 0;
+}
+
+/*
+ * Runs of every length up to TEST_RUN_MAX, over registers which overlap
+ * from one run to the next, so the order of the writes matters. Single
+ * registers and padding in between, and a flush every few runs.
+ */
+static void
+TestRuns(struct RhdCS *CS)
+{
+    CARD32 Run, i;
+
+    for (Run = 1; Run <= TEST_RUN_MAX; Run++) {
+	RHDCSGrab(CS, Run + 4);
+	RHDCSRegWriteRun(CS, R5XX_DST_PITCH_OFFSET + 4 * (Run & 7), Run);
+	for (i = 0; i < Run; i++)
+	    RHDCSWrite(CS, (Run << 16) | i);
+	RHDCSRegWrite(CS, R5XX_DP_GUI_MASTER_CNTL, Run);
+	if (Run & 1)
+	    RHDCSWrite(CS, CP_PACKET2());
+
+	if (!(Run & 3))
+	    RHDCSFlush(CS);
+    }
+
+    RHDCSFlush(CS);
+}
+
+/* SET_CONFIG_REG WAIT_UNTIL */
+static void
+TestWaitUntil(struct RhdCS *CS, CARD32 Value)
+{
+    RHDCSWrite(CS, CP_PACKET3(IT_SET_CONFIG_REG << 8, 1));
+    RHDCSWrite(CS, (WAIT_UNTIL - SET_CONFIG_REG_offset) >> 2);
+    RHDCSWrite(CS, Value);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct RhdCS *CS;
+    Bool Runs = FALSE;
+
+    if ((argc == 3) && !strcmp(argv[1], "-r")) {
+	Runs = TRUE;
+	argv++;
+    } else if (argc != 2) {
+	fprintf(stderr, "Usage: %s [-r] tracefile\n", argv[0]);
+	return 1;
+    }
+
+    CS = calloc(1, sizeof(struct RhdCS));
+    CS->Type = RHD_CS_CPDMA;
+    CS->Active = TRUE;
+    CS->Clean = RHD_CS_CLEAN_UNTOUCHED;
+    CS->Buffer = TestBuffer;
+    CS->Size = TEST_BUFFER_SIZE;
+    CS->Grab = TestGrab;
+    CS->Flush = TestFlush;
+
+    if (Runs) {
+	CS->Flush = TestRunsFlush;
+
+	CSTraceOpen(CS, argv[1], RHD_CS_TRACE_R5XX);
+	if (!CS->Trace)
+	    return 1;
+
+	TestRuns(CS);
+
+	if (!CS->Trace)
+	    return 1;
+	CSTraceClose(CS);
+
+	free(CS);
+	return 0;
+    }
+
+    CSTraceOpen(CS, argv[1], RHD_CS_TRACE_R6XX);
+    if (!CS->Trace)
+	return 1;
+
+    RHDCSGrab(CS, 12);
+    TestWaitUntil(CS, 0x00008000);
+    TestWaitUntil(CS, 0x00010000);
+    TestWaitUntil(CS, 0x00020000);
+    TestWaitUntil(CS, 0x00040000);
+    RHDCSFlush(CS);
+
+    RHDCSGrab(CS, 3);
+    TestWaitUntil(CS, 0x00080000);
+    RHDCSFlush(CS);
+
+    /* the backend did pad, or this test tells us nothing */
+    if ((CS->Wptr != 32) || (TestBuffer[31] != CP_PACKET2())) {
+	fprintf(stderr, "ERROR: flushes were not padded.\n");
+	return 1;
+    }
+
+    if (!CS->Trace)
+	return 1;
+    CSTraceClose(CS);
+
+    free(CS);
+    return 0;
+}
+
+/*
+ * What rhd_cs.c needs from the X server and from the rest of the driver.
+ */
+ScrnInfoPtr *xf86Screens;
+
+CARD32
+GetTimeInMillis(void)
+{
+    return 0;
+}
+
+void
+xf86DrvMsg(int scrnIndex, MessageType type, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+void
+RHDDebug(int scrnIndex, const char *format, ...)
+{
+}
@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+# Padded R6xx flushes have to show up exactly once in the trace, and without
+# the PACKET2 padding.
+#
+
+TRACE=padded_flush.trace
+OUT=padded_flush.out
+
+./cstrace_test $TRACE || exit 1
+./rhd_cstrace -d $TRACE > $OUT || exit 1
+
+grep -q "2 records, 15 dwords" $OUT || { cat $OUT; exit 1; }
+grep -q "PACKET3 .* 5 packets .* 15 dwords" $OUT || { cat $OUT; exit 1; }
+if grep -q "PACKET2" $OUT; then
+    cat $OUT
+    exit 1
+fi
+
+rm -f $TRACE $OUT
+exit 0
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Replays a recorded R5xx command stream through the MMIO backend of
+ * src/rhd_cs.c, with the registers in plain memory instead of on the card.
+ * The RBBM status always claims the same number of free FIFO entries, so
+ * runs of registers get split up the way a busy engine would have them.
+ *
+ * Afterwards, the register file has to hold exactly what a plain walk over
+ * the PACKET0s of the trace leaves behind. The replay is timed, which makes
+ * this a benchmark for the CPU side of the MMIO path; the bus is not in it.
+ *
+ * rhd_cs.c is built right in, the same way as in cstrace_test.c.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#undef USE_DRI
+
+#include "xf86.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+/* keep the allocations away from the server */
+#undef xnfcalloc
+#define xnfcalloc(Num, Size) calloc((Num), (Size))
+#undef xfree
+#define xfree(Ptr) free(Ptr)
+
+#include "rhd_cs.c"
+
+#define REPLAY_MMIO_SIZE 0x10000 /* all that a PACKET0 can reach */
+#define REPLAY_FIFO      64 /* free RBBM entries, by default */
+
+struct ReplayRecord {
+    struct ReplayRecord *Next;
+    CARD32 Count;
+    CARD32 Data[1];
+};
+
+static struct ReplayRecord *Records, **RecordsLast = &Records;
+static unsigned long RecordCount, DwordCount;
+static unsigned long SkippedPackets, SkippedDwords, SkippedIBs;
+
+static CARD32 Registers[REPLAY_MMIO_SIZE / 4]; /* what the trace asks for */
+static unsigned long RegisterWrites[REPLAY_MMIO_SIZE / 4];
+static CARD32 Sink[REPLAY_MMIO_SIZE / 4]; /* what the backend did */
+
+/*
+ *
+ */
+static void
+print_help(const char* progname, const char* message, const char* msgarg)
+{
+	if (message != NULL)
+	    fprintf(stderr, "%s %s\n", message, msgarg);
+	fprintf(stderr, "Usage: %s [-d] [-f entries] [-n loops] tracefile\n"
+			"       -d: dump the registers afterwards\n"
+			"       -f: free RBBM FIFO entries to report (%d)\n"
+			"       -n: replay the whole trace this often (1)\n\n",
+		progname, REPLAY_FIFO);
+}
+
+/*
+ * Only PACKET0s and the PACKET2 padding go through the MMIO backend. A
+ * trace recorded with the CP backend also holds PACKET3s, those get dropped.
+ */
+static void
+RecordAdd(CARD32 *Data, CARD32 Count)
+{
+    struct ReplayRecord *Record;
+    CARD32 i = 0, Length;
+
+    Record = malloc(sizeof(struct ReplayRecord) + Count * sizeof(CARD32));
+    Record->Next = NULL;
+    Record->Count = 0;
+
+    while (i < Count) {
+	switch (Data[i] >> 30) {
+	case 0:
+	    Length = ((Data[i] >> 16) & 0x3FFF) + 2;
+	    if (((Data[i] & 0x3FFF) + Length - 1) > (REPLAY_MMIO_SIZE / 4)) {
+		fprintf(stderr, "Warning: PACKET0 0x%08X runs past the "
+			"registers.\n", (unsigned int) Data[i]);
+		SkippedPackets++;
+		SkippedDwords += Length;
+		i += Length;
+		continue;
+	    }
+	    break;
+	case 2:
+	    Length = 1;
+	    if (Data[i] != CP_PACKET2()) {
+		SkippedPackets++;
+		SkippedDwords += Length;
+		i += Length;
+		continue;
+	    }
+	    break;
+	case 3:
+	    Length = ((Data[i] >> 16) & 0x3FFF) + 2;
+	    SkippedPackets++;
+	    SkippedDwords += Length;
+	    i += Length;
+	    continue;
+	default: /* PACKET1: two registers, never emitted by the driver */
+	    Length = 3;
+	    SkippedPackets++;
+	    SkippedDwords += Length;
+	    i += Length;
+	    continue;
+	}
+
+	if ((i + Length) > Count) {
+	    fprintf(stderr, "Warning: packet 0x%08X runs past the end of its"
+		    " record.\n", (unsigned int) Data[i]);
+	    break;
+	}
+
+	memcpy(&Record->Data[Record->Count], &Data[i], Length * sizeof(CARD32));
+	Record->Count += Length;
+	i += Length;
+    }
+
+    if (!Record->Count) {
+	free(Record);
+	return;
+    }
+
+    *RecordsLast = Record;
+    RecordsLast = &Record->Next;
+
+    RecordCount++;
+    DwordCount += Record->Count;
+}
+
+/*
+ *
+ */
+static Bool
+TraceRead(const char *TraceFile)
+{
+    char Magic[8], Name[RHD_CS_TRACE_NAME_MAX + 4];
+    CARD32 Header[4], *Data = NULL, Size = 0;
+    FILE *f;
+
+    f = fopen(TraceFile, "r");
+    if (!f) {
+	fprintf(stderr, "ERROR: Unable to open %s.\n", TraceFile);
+	return FALSE;
+    }
+
+    if ((fread(Magic, 8, 1, f) != 1) ||
+	memcmp(Magic, RHD_CS_TRACE_MAGIC, 8) ||
+	(fread(Header, 4, 2, f) != 2)) {
+	fprintf(stderr, "ERROR: %s is not a command stream trace.\n",
+		TraceFile);
+	fclose(f);
+	return FALSE;
+    }
+
+    if (Header[0] != RHD_CS_TRACE_VERSION) {
+	fprintf(stderr, "ERROR: %s: unsupported version %u (or wrong byte"
+		" order).\n", TraceFile, (unsigned int) Header[0]);
+	fclose(f);
+	return FALSE;
+    }
+
+    if (Header[1] != RHD_CS_TRACE_R5XX) {
+	fprintf(stderr, "ERROR: %s: only R5xx command streams go through the"
+		" MMIO backend.\n", TraceFile);
+	fclose(f);
+	return FALSE;
+    }
+
+    while (fread(Header, 4, 4, f) == 4) {
+	if (Header[3] > RHD_CS_TRACE_NAME_MAX) {
+	    fprintf(stderr, "ERROR: Corrupt record after %lu records.\n",
+		    RecordCount);
+	    break;
+	}
+
+	if (fread(Name, (Header[3] + 3) & ~3, 1, f) != (Header[3] ? 1 : 0))
+	    break;
+
+	if (Header[2] > Size) {
+	    Size = Header[2];
+	    Data = realloc(Data, Size * sizeof(CARD32));
+	}
+	if (fread(Data, 4, Header[2], f) != Header[2]) {
+	    fprintf(stderr, "Warning: last record is truncated.\n");
+	    break;
+	}
+
+	if (Header[0] == RHD_CS_TRACE_IB)
+	    SkippedIBs++;
+	else
+	    RecordAdd(Data, Header[2]);
+    }
+
+    free(Data);
+    fclose(f);
+
+    return TRUE;
+}
+
+/*
+ * Plain walk over the PACKET0s: what the registers should end up as.
+ */
+static void
+ReplayReference(void)
+{
+    struct ReplayRecord *Record;
+    CARD32 i, j, Reg, Count;
+
+    for (Record = Records; Record; Record = Record->Next)
+	for (i = 0; i < Record->Count; i += Count + 1) {
+	    if (Record->Data[i] == CP_PACKET2()) {
+		Count = 0;
+		continue;
+	    }
+
+	    Reg = Record->Data[i] & 0x3FFF;
+	    Count = ((Record->Data[i] >> 16) & 0x3FFF) + 1;
+
+	    for (j = 0; j < Count; j++) {
+		Registers[Reg + j] = Record->Data[i + 1 + j];
+		RegisterWrites[Reg + j]++;
+	    }
+	}
+}
+
+/*
+ * Each record gets grabbed, written and flushed on its own, as it was
+ * recorded between two grabs or flushes in the driver.
+ */
+static void
+Replay(struct RhdCS *CS)
+{
+    struct ReplayRecord *Record;
+    CARD32 i;
+
+    for (Record = Records; Record; Record = Record->Next) {
+	RHDCSGrab(CS, Record->Count);
+	for (i = 0; i < Record->Count; i++)
+	    RHDCSWrite(CS, Record->Data[i]);
+	RHDCSFlush(CS);
+    }
+}
+
+/*
+ *
+ */
+static CARD64
+ReplayTime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (CARD64) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static ScrnInfoRec ReplayScreen;
+static RHDRec ReplayRhd;
+static ScrnInfoPtr ReplayScreens[1] = { &ReplayScreen };
+
+int
+main(int argc, char *argv[])
+{
+    const char *TraceFile = NULL;
+    CARD32 Fifo = REPLAY_FIFO;
+    unsigned long Writes = 0, Touched = 0, Mismatches = 0;
+    int Loops = 1, i;
+    Bool Dump = FALSE;
+    struct RhdCS *CS;
+    CARD64 Start, Time;
+
+    for (i = 1; i < argc; i++) {
+	if (!strcmp("-d", argv[i]))
+	    Dump = TRUE;
+	else if (!strcmp("-f", argv[i])) {
+	    if (++i >= argc) {
+		print_help(argv[0], "Missing argument to", "-f");
+		return 1;
+	    }
+	    Fifo = strtoul(argv[i], NULL, 0);
+	    if (!Fifo || (Fifo > R5XX_RBBM_FIFOCNT_MASK)) {
+		print_help(argv[0], "Not a valid FIFO size:", argv[i]);
+		return 1;
+	    }
+	} else if (!strcmp("-n", argv[i])) {
+	    if (++i >= argc) {
+		print_help(argv[0], "Missing argument to", "-n");
+		return 1;
+	    }
+	    Loops = atoi(argv[i]);
+	    if (Loops < 1) {
+		print_help(argv[0], "Not a valid loop count:", argv[i]);
+		return 1;
+	    }
+	} else if (!TraceFile)
+	    TraceFile = argv[i];
+	else {
+	    print_help(argv[0], "Unknown argument:", argv[i]);
+	    return 1;
+	}
+    }
+
+    if (!TraceFile) {
+	print_help(argv[0], "Missing argument: please provide a trace file",
+		   "");
+	return 1;
+    }
+
+    if (!TraceRead(TraceFile))
+	return 1;
+
+    printf("%s: %lu records, %lu dwords to replay; skipped %lu packets "
+	   "(%lu dwords) and %lu indirect buffers.\n", TraceFile, RecordCount,
+	   DwordCount, SkippedPackets, SkippedDwords, SkippedIBs);
+
+    /* point the MMIO backend at our registers */
+    xf86Screens = ReplayScreens;
+    ReplayScreen.driverPrivate = &ReplayRhd;
+    ReplayRhd.MMIOBase = (pointer) Sink;
+
+    CS = calloc(1, sizeof(struct RhdCS));
+    CS->scrnIndex = 0;
+    CSMMIOInit(CS);
+    CS->Active = TRUE;
+
+    /* RBBM_STATUS sits in the sink as well, the stream does not touch it */
+    MMIO_OUT32(Sink, R5XX_RBBM_STATUS, Fifo);
+
+    Start = ReplayTime();
+    for (i = 0; i < Loops; i++)
+	Replay(CS);
+    Time = ReplayTime() - Start;
+
+    ReplayReference();
+    Registers[R5XX_RBBM_STATUS >> 2] = Fifo;
+
+    for (i = 0; i < (REPLAY_MMIO_SIZE / 4); i++) {
+	CARD32 Value = MMIO_IN32(Sink, i << 2);
+
+	if (RegisterWrites[i]) {
+	    Writes += RegisterWrites[i];
+	    Touched++;
+	    if (Dump)
+		printf("0x%04X: 0x%08X (%lu writes)\n", i << 2,
+		       (unsigned int) Value, RegisterWrites[i]);
+	}
+
+	if (Value != Registers[i]) {
+	    if (!Mismatches)
+		fprintf(stderr, "ERROR: register 0x%04X is 0x%08X instead of"
+			" 0x%08X.\n", i << 2, (unsigned int) Value,
+			(unsigned int) Registers[i]);
+	    Mismatches++;
+	}
+    }
+
+    printf("%lu register writes to %lu registers, with %u free FIFO "
+	   "entries.\n", Writes, Touched, (unsigned int) Fifo);
+    printf("Replayed %d times in %.3fms: %.1f ns per register write.\n",
+	   Loops, Time / 1000.0,
+	   Writes ? (Time * 1000.0) / ((double) Writes * Loops) : 0.0);
+
+    CS->Destroy(CS);
+    free(CS);
+
+    if (Mismatches) {
+	fprintf(stderr, "ERROR: %lu registers differ.\n", Mismatches);
+	return 1;
+    }
+
+    printf("Registers match.\n");
+    return 0;
+}
+
+/*
+ * What rhd_cs.c needs from the X server and from the rest of the driver.
+ */
+ScrnInfoPtr *xf86Screens;
+
+CARD32
+GetTimeInMillis(void)
+{
+    return ReplayTime() / 1000;
+}
+
+void
+xf86DrvMsg(int scrnIndex, MessageType type, const char *format, ...)
+{
+    va_list ap;
+
+    if (type == X_INFO)
+	return;
+
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+void
+RHDDebug(int scrnIndex, const char *format, ...)
+{
+}
@@ -0,0 +1,510 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Offline decoder for the command stream traces that the driver writes when
+ * Option "CSTrace" is set.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "git_version.h"
+
+#include "rhd_cs_trace.h"
+#include "r600_reg.h"
+
+#ifndef RHD_REG_DIR
+# define RHD_REG_DIR "."
+#endif
+
+typedef int Bool;
+#define FALSE 0
+#define TRUE 1
+typedef unsigned int CARD32;
+
+#define REG_MAX 0x10000 /* in dwords, covers all of the R6xx SET_* ranges */
+
+static char *RegNames[REG_MAX];
+static unsigned long RegCount[REG_MAX];
+
+static char *Packet3Names[0x100];
+static unsigned long Packet3Count[0x100];
+static unsigned long Packet3Dwords[0x100];
+
+static unsigned long PacketCount[4];
+static unsigned long PacketDwords[4];
+static unsigned long PacketBroken;
+
+struct Origin {
+    struct Origin *Next;
+    char *Name;
+    unsigned long Records;
+    unsigned long Dwords;
+};
+
+static struct Origin *Origins;
+
+static Bool Dump;
+
+/*
+ *
+ */
+static void
+print_help(const char* progname, const char* message, const char* msgarg)
+{
+	if (message != NULL)
+	    fprintf(stderr, "%s %s\n", message, msgarg);
+	fprintf(stderr, "Usage: %s [-d] [-r dir] tracefile\n"
+			"       -d: decode every packet\n"
+			"       -r: directory holding r5xx_regs.h and r600_reg*.h"
+			" (%s)\n\n",
+		progname, RHD_REG_DIR);
+}
+
+/*
+ * Pick register and packet3 names straight out of the driver headers.
+ *
+ * r5xx_regs.h: "#define R5XX_FOO  0x1234", fields are "#    define".
+ * r600_reg*.h: "    FOO = 0x00001234,", fields are indented with a tab.
+ */
+static void
+NamesAdd(char *Name, CARD32 Value)
+{
+    CARD32 Index;
+
+    if (!strncmp(Name, "IT_", 3)) {
+	if ((Value < 0x100) && !Packet3Names[Value])
+	    Packet3Names[Value] = strdup(Name);
+	return;
+    }
+
+    if (strstr(Name, "_PACKET3_")) {
+	Index = (Value >> 8) & 0xFF;
+	if (!Packet3Names[Index])
+	    Packet3Names[Index] = strdup(Name);
+	return;
+    }
+
+    /* SET_*_offset/end markers, fields */
+    if (strstr(Name, "_offset") || strstr(Name, "_end") || (Value & 0x03))
+	return;
+
+    Index = Value >> 2;
+    if ((Index < REG_MAX) && !RegNames[Index])
+	RegNames[Index] = strdup(Name);
+}
+
+/*
+ *
+ */
+static Bool
+NamesRead(const char *Dir, const char *File)
+{
+    char Path[1024], Line[256], Name[128], Value[32];
+    FILE *f;
+
+    snprintf(Path, sizeof(Path), "%s/%s", Dir, File);
+
+    f = fopen(Path, "r");
+    if (!f) {
+	fprintf(stderr, "Warning: unable to open %s: no register names.\n",
+		Path);
+	return FALSE;
+    }
+
+    while (fgets(Line, sizeof(Line), f)) {
+	if (!strncmp(Line, "#define", 7)) {
+	    if ((sscanf(Line, "#define %127s %31s", Name, Value) != 2))
+		continue;
+	} else if (!strncmp(Line, "    ", 4) && isupper(Line[4])) {
+	    if ((sscanf(Line, " %127[A-Za-z0-9_] = %31[0-9a-fA-FxX]",
+			Name, Value) != 2))
+		continue;
+	} else
+	    continue;
+
+	if (strncmp(Value, "0x", 2) && strncmp(Value, "0X", 2))
+	    continue;
+
+	NamesAdd(Name, strtoul(Value, NULL, 16));
+    }
+
+    fclose(f);
+    return TRUE;
+}
+
+/*
+ *
+ */
+static const char *
+RegName(CARD32 Reg)
+{
+    static char Unknown[16];
+
+    if (((Reg >> 2) < REG_MAX) && RegNames[Reg >> 2])
+	return RegNames[Reg >> 2];
+
+    snprintf(Unknown, sizeof(Unknown), "0x%05X", Reg);
+    return Unknown;
+}
+
+/*
+ *
+ */
+static void
+RegWrite(CARD32 Reg, CARD32 Value)
+{
+    if ((Reg >> 2) < REG_MAX)
+	RegCount[Reg >> 2]++;
+
+    if (Dump)
+	printf("\t\t%-40s (0x%05X) <- 0x%08X\n", RegName(Reg), Reg, Value);
+}
+
+/*
+ * R6xx SET_*_REG packets: first dword is the offset into the range.
+ */
+static CARD32
+Packet3RegBase(int Opcode)
+{
+    switch (Opcode) {
+    case IT_SET_CONFIG_REG:
+	return SET_CONFIG_REG_offset;
+    case IT_SET_CONTEXT_REG:
+	return SET_CONTEXT_REG_offset;
+    case IT_SET_ALU_CONST:
+	return SET_ALU_CONST_offset;
+    case IT_SET_RESOURCE:
+	return SET_RESOURCE_offset;
+    case IT_SET_SAMPLER:
+	return SET_SAMPLER_offset;
+    case IT_SET_CTL_CONST:
+	return SET_CTL_CONST_offset;
+    case IT_SET_LOOP_CONST:
+	return SET_LOOP_CONST_offset;
+    case IT_SET_BOOL_CONST:
+	return SET_BOOL_CONST_offset;
+    default:
+	return 0;
+    }
+}
+
+/*
+ *
+ */
+static void
+Decode(CARD32 Family, CARD32 *Data, CARD32 Count)
+{
+    CARD32 i = 0, j, Header, Length, Reg, Base;
+    int Type, Opcode;
+
+    while (i < Count) {
+	Header = Data[i];
+	Type = Header >> 30;
+
+	switch (Type) {
+	case 0:
+	    Length = ((Header >> 16) & 0x3FFF) + 1;
+	    break;
+	case 1:
+	    Length = 2;
+	    break;
+	case 2:
+	    Length = 0;
+	    break;
+	default:
+	    Length = ((Header >> 16) & 0x3FFF) + 1;
+	    break;
+	}
+
+	if ((i + 1 + Length) > Count) {
+	    printf("\tBroken packet 0x%08X at %u: %u dwords, %u left.\n",
+		   Header, i, Length, Count - i - 1);
+	    PacketBroken++;
+	    return;
+	}
+
+	PacketCount[Type]++;
+	PacketDwords[Type] += Length + 1;
+
+	switch (Type) {
+	case 0:
+	    Reg = (Header & 0x7FFF) << 2;
+	    if (Dump)
+		printf("\tPACKET0 %s, %u\n", RegName(Reg), Length);
+	    for (j = 0; j < Length; j++)
+		/* bit 15: all of them go to the same register */
+		RegWrite((Header & 0x8000) ? Reg : (Reg + 4 * j),
+			 Data[i + 1 + j]);
+	    break;
+	case 1:
+	    if (Dump)
+		printf("\tPACKET1\n");
+	    RegWrite((Header & 0x7FF) << 2, Data[i + 1]);
+	    RegWrite(((Header >> 11) & 0x7FF) << 2, Data[i + 2]);
+	    break;
+	case 2:
+	    if (Dump)
+		printf("\tPACKET2\n");
+	    break;
+	default:
+	    Opcode = (Header >> 8) & 0xFF;
+	    Packet3Count[Opcode]++;
+	    Packet3Dwords[Opcode] += Length + 1;
+
+	    if (Dump) {
+		if (Packet3Names[Opcode])
+		    printf("\tPACKET3 %s, %u\n", Packet3Names[Opcode], Length);
+		else
+		    printf("\tPACKET3 0x%02X, %u\n", Opcode, Length);
+	    }
+
+	    Base = 0;
+	    if (Family == RHD_CS_TRACE_R6XX)
+		Base = Packet3RegBase(Opcode);
+
+	    if (Base) {
+		Reg = Base + (Data[i + 1] << 2);
+		for (j = 1; j < Length; j++)
+		    RegWrite(Reg + 4 * (j - 1), Data[i + 1 + j]);
+	    } else if (Dump)
+		for (j = 0; j < Length; j++)
+		    printf("\t\t0x%08X\n", Data[i + 1 + j]);
+	    break;
+	}
+
+	i += 1 + Length;
+    }
+}
+
+/*
+ *
+ */
+static void
+OriginAdd(const char *Name, CARD32 Count)
+{
+    struct Origin *Origin;
+
+    for (Origin = Origins; Origin; Origin = Origin->Next)
+	if (!strcmp(Origin->Name, Name))
+	    break;
+
+    if (!Origin) {
+	Origin = calloc(1, sizeof(struct Origin));
+	Origin->Name = strdup(Name);
+	Origin->Next = Origins;
+	Origins = Origin;
+    }
+
+    Origin->Records++;
+    Origin->Dwords += Count;
+}
+
+/*
+ *
+ */
+static int
+RegCompare(const void *a, const void *b)
+{
+    CARD32 A = *(const CARD32 *) a, B = *(const CARD32 *) b;
+
+    if (RegCount[A] != RegCount[B])
+	return (RegCount[A] < RegCount[B]) ? 1 : -1;
+    return (A < B) ? -1 : 1;
+}
+
+/*
+ *
+ */
+static void
+Histograms(void)
+{
+    static const char *TypeNames[4] = {
+	"PACKET0", "PACKET1", "PACKET2", "PACKET3"
+    };
+    struct Origin *Origin;
+    CARD32 *Regs;
+    int i, Num = 0;
+
+    printf("\nPackets:\n");
+    for (i = 0; i < 4; i++)
+	if (PacketCount[i])
+	    printf("  %-40s %10lu packets %10lu dwords\n", TypeNames[i],
+		   PacketCount[i], PacketDwords[i]);
+    if (PacketBroken)
+	printf("  %-40s %10lu\n", "Broken", PacketBroken);
+
+    printf("\nPACKET3 opcodes:\n");
+    for (i = 0; i < 0x100; i++)
+	if (Packet3Count[i]) {
+	    if (Packet3Names[i])
+		printf("  %-40s", Packet3Names[i]);
+	    else
+		printf("  0x%02X%36s", i, "");
+	    printf(" %10lu packets %10lu dwords\n", Packet3Count[i],
+		   Packet3Dwords[i]);
+	}
+
+    Regs = malloc(REG_MAX * sizeof(CARD32));
+    for (i = 0; i < REG_MAX; i++)
+	if (RegCount[i])
+	    Regs[Num++] = i;
+    qsort(Regs, Num, sizeof(CARD32), RegCompare);
+
+    printf("\nRegisters:\n");
+    for (i = 0; i < Num; i++)
+	printf("  %-40s (0x%05X) %10lu writes\n", RegName(Regs[i] << 2),
+	       Regs[i] << 2, RegCount[Regs[i]]);
+    free(Regs);
+
+    if (Origins) {
+	printf("\nOrigins:\n");
+	for (Origin = Origins; Origin; Origin = Origin->Next)
+	    printf("  %-40s %10lu records %10lu dwords\n", Origin->Name,
+		   Origin->Records, Origin->Dwords);
+    }
+}
+
+/*
+ *
+ */
+int
+main(int argc, char *argv[])
+{
+    const char *RegDir = RHD_REG_DIR;
+    const char *TraceFile = NULL;
+    char Magic[8], Name[RHD_CS_TRACE_NAME_MAX + 4];
+    CARD32 Header[4], *Data = NULL, Size = 0;
+    CARD32 Family, Start = 0, Last = 0;
+    unsigned long Records = 0, Dwords = 0;
+    FILE *f;
+    int i;
+
+    printf("%s: v%s, %s\n",
+	   "rhd_cstrace", PACKAGE_VERSION, GIT_MESSAGE);
+
+    for (i = 1; i < argc; i++) {
+	if (!strcmp("-d", argv[i]))
+	    Dump = TRUE;
+	else if (!strcmp("-r", argv[i])) {
+	    if (++i >= argc) {
+		print_help(argv[0], "Missing argument to", "-r");
+		return 1;
+	    }
+	    RegDir = argv[i];
+	} else if (!TraceFile)
+	    TraceFile = argv[i];
+	else {
+	    print_help(argv[0], "Unknown argument:", argv[i]);
+	    return 1;
+	}
+    }
+
+    if (!TraceFile) {
+	print_help(argv[0], "Missing argument: please provide a trace file",
+		   "");
+	return 1;
+    }
+
+    f = fopen(TraceFile, "r");
+    if (!f) {
+	fprintf(stderr, "ERROR: Unable to open %s.\n", TraceFile);
+	return 1;
+    }
+
+    if ((fread(Magic, 8, 1, f) != 1) ||
+	memcmp(Magic, RHD_CS_TRACE_MAGIC, 8) ||
+	(fread(Header, 4, 2, f) != 2)) {
+	fprintf(stderr, "ERROR: %s is not a command stream trace.\n",
+		TraceFile);
+	return 1;
+    }
+
+    if (Header[0] != RHD_CS_TRACE_VERSION) {
+	fprintf(stderr, "ERROR: %s: unsupported version %u (or wrong byte"
+		" order).\n", TraceFile, Header[0]);
+	return 1;
+    }
+    Family = Header[1];
+
+    if (Family == RHD_CS_TRACE_R6XX) {
+	NamesRead(RegDir, "r600_reg.h");
+	NamesRead(RegDir, "r600_reg_auto_r6xx.h");
+	NamesRead(RegDir, "r600_reg_r6xx.h");
+	NamesRead(RegDir, "r600_reg_r7xx.h");
+    } else
+	NamesRead(RegDir, "r5xx_regs.h");
+    NamesRead(RegDir, "rhd_cs.h");
+
+    while (fread(Header, 4, 4, f) == 4) {
+	if (Header[3] > RHD_CS_TRACE_NAME_MAX) {
+	    fprintf(stderr, "ERROR: Corrupt record after %lu records.\n",
+		    Records);
+	    break;
+	}
+
+	if (fread(Name, (Header[3] + 3) & ~3, 1, f) != (Header[3] ? 1 : 0))
+	    break;
+	Name[Header[3]] = 0;
+
+	if (Header[2] > Size) {
+	    Size = Header[2];
+	    Data = realloc(Data, Size * sizeof(CARD32));
+	}
+	if (fread(Data, 4, Header[2], f) != Header[2]) {
+	    fprintf(stderr, "Warning: last record is truncated.\n");
+	    break;
+	}
+
+	if (!Records)
+	    Start = Header[1];
+	Last = Header[1];
+	Records++;
+	Dwords += Header[2];
+
+	if (Header[3])
+	    OriginAdd(Name, Header[2]);
+
+	if (Dump)
+	    printf("%8u: %s %u dwords%s%s\n", Header[1],
+		   (Header[0] == RHD_CS_TRACE_IB) ? "IB" : "CS", Header[2],
+		   Header[3] ? " from " : "", Name);
+
+	Decode(Family, Data, Header[2]);
+    }
+
+    fclose(f);
+
+    printf("\n%s: %s, %lu records, %lu dwords, over %ums.\n", TraceFile,
+	   (Family == RHD_CS_TRACE_R6XX) ? "R6xx" : "R5xx", Records, Dwords,
+	   Last - Start);
+
+    Histograms();
+
+    return 0;
+}
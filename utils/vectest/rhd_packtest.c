@@ -0,0 +1,245 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the vector versions of the Xv YV12 to YUY2 line packing against
+ * R5xxXvPackLineC(), on random lines of random length and alignment, and
+ * times them all when asked to.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "rhd_swap.h"
+#include "rhd_xvpack.h"
+
+#define PACK_PAIRS_MAX 256 /* longest random line */
+#define PACK_LINES     20000 /* random lines per kernel */
+#define PACK_GUARD     64 /* bytes around each buffer which must stay as they are */
+
+#define TIME_PAIRS     960 /* a 1920 wide line */
+#define TIME_LINES     200000
+
+struct PackKernel {
+    const char *Name;
+    R5xxXvPackLineProc Proc;
+};
+
+/*
+ * The kernels which this build of the driver could pick, and which this
+ * CPU can run. The C version always comes first.
+ */
+static int
+PackKernels(struct PackKernel *Kernels)
+{
+    int Count = 0;
+
+    Kernels[Count].Name = "C";
+    Kernels[Count++].Proc = R5xxXvPackLineC;
+#ifdef __SSE2__
+    Kernels[Count].Name = "SSE2";
+    Kernels[Count++].Proc = R5xxXvPackLineSSE2;
+#endif
+#ifdef RHD_XV_NEON
+    Kernels[Count].Name = "NEON";
+    Kernels[Count++].Proc = R5xxXvPackLineNEON;
+#endif
+#ifdef USE_ALTIVEC
+    if (RHDHasAltivec()) {
+	Kernels[Count].Name = "AltiVec";
+	Kernels[Count++].Proc = R5xxXvPackLineAltivec;
+    } else
+	fprintf(stderr, "Built with AltiVec, but this CPU does not have it.\n");
+#endif
+
+    return Count;
+}
+
+/*
+ *
+ */
+static void
+PackFill(CARD8 *Buffer, int Size)
+{
+    int i;
+
+    for (i = 0; i < Size; i++)
+	Buffer[i] = random() & 0xFF;
+}
+
+/*
+ *
+ */
+static CARD64
+PackTime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (CARD64) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*
+ * dst is only ever dword aligned in the driver, the sources can be anywhere.
+ */
+static int
+PackCheck(struct PackKernel *Kernel)
+{
+    static CARD8 Luma[2 * PACK_PAIRS_MAX + 2 * PACK_GUARD];
+    static CARD8 Chroma2[PACK_PAIRS_MAX + 2 * PACK_GUARD];
+    static CARD8 Chroma3[PACK_PAIRS_MAX + 2 * PACK_GUARD];
+    static CARD32 Reference[PACK_PAIRS_MAX + 2 * PACK_GUARD / 4];
+    static CARD32 Result[PACK_PAIRS_MAX + 2 * PACK_GUARD / 4];
+    CARD8 *s1, *s2, *s3;
+    CARD32 *d;
+    int Line, Pairs, Offset, i;
+
+    for (Line = 0; Line < PACK_LINES; Line++) {
+	/* mostly short ones, where the head and tail handling is */
+	if (Line & 1)
+	    Pairs = random() % 48;
+	else
+	    Pairs = random() % (PACK_PAIRS_MAX + 1);
+
+	s1 = Luma + PACK_GUARD + (random() % 16);
+	s2 = Chroma2 + PACK_GUARD + (random() % 16);
+	s3 = Chroma3 + PACK_GUARD + (random() % 16);
+	Offset = PACK_GUARD / 4 - 4 + (random() % 4);
+
+	PackFill(s1, 2 * Pairs);
+	PackFill(s2, Pairs);
+	PackFill(s3, Pairs);
+
+	memset(Reference, 0xA5, sizeof(Reference));
+	memset(Result, 0xA5, sizeof(Result));
+
+	R5xxXvPackLineC(Reference + Offset, s1, s2, s3, Pairs);
+	Kernel->Proc(Result + Offset, s1, s2, s3, Pairs);
+
+	if (!memcmp(Reference, Result, sizeof(Result)))
+	    continue;
+
+	for (i = 0; Reference[i] == Result[i]; i++)
+	    ;
+
+	d = Result + Offset;
+	fprintf(stderr, "%s: FAILED: %d pairs, dst at +%d, sources at +%d, +%d, "
+		"+%d: dword %d is 0x%08X instead of 0x%08X.\n", Kernel->Name,
+		Pairs, (int) (((unsigned long) d) & 15),
+		(int) (s1 - Luma - PACK_GUARD), (int) (s2 - Chroma2 - PACK_GUARD),
+		(int) (s3 - Chroma3 - PACK_GUARD), i - Offset,
+		(unsigned int) Result[i], (unsigned int) Reference[i]);
+	return 1;
+    }
+
+    printf("%s: %d lines OK.\n", Kernel->Name, PACK_LINES);
+    return 0;
+}
+
+/*
+ * One full HD line over and over: once with everything aligned, once with
+ * the sources off by one.
+ */
+static void
+PackBench(struct PackKernel *Kernel)
+{
+    static CARD8 Luma[2 * TIME_PAIRS + 16] __attribute__ ((aligned (16)));
+    static CARD8 Chroma2[TIME_PAIRS + 16] __attribute__ ((aligned (16)));
+    static CARD8 Chroma3[TIME_PAIRS + 16] __attribute__ ((aligned (16)));
+    static CARD32 Dst[TIME_PAIRS] __attribute__ ((aligned (16)));
+    CARD64 Start, Aligned, Unaligned;
+    int i;
+
+    PackFill(Luma, sizeof(Luma));
+    PackFill(Chroma2, sizeof(Chroma2));
+    PackFill(Chroma3, sizeof(Chroma3));
+
+    Start = PackTime();
+    for (i = 0; i < TIME_LINES; i++)
+	Kernel->Proc(Dst, Luma, Chroma2, Chroma3, TIME_PAIRS);
+    Aligned = PackTime() - Start;
+
+    Start = PackTime();
+    for (i = 0; i < TIME_LINES; i++)
+	Kernel->Proc(Dst, Luma + 1, Chroma2 + 1, Chroma3 + 1, TIME_PAIRS);
+    Unaligned = PackTime() - Start;
+
+    printf("%-8s %8.1f ns/line aligned, %8.1f ns/line unaligned"
+	   " (%.0f MB/s)\n", Kernel->Name,
+	   (Aligned * 1000.0) / TIME_LINES, (Unaligned * 1000.0) / TIME_LINES,
+	   (4.0 * TIME_PAIRS * TIME_LINES) / (Aligned ? Aligned : 1));
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct PackKernel Kernels[4];
+    unsigned int Seed = 1;
+    Bool Bench = FALSE;
+    int Count, i, c, ret = 0;
+
+    while ((c = getopt(argc, argv, "s:t")) != -1) {
+	switch (c) {
+	case 's':
+	    Seed = strtoul(optarg, NULL, 0);
+	    break;
+	case 't':
+	    Bench = TRUE;
+	    break;
+	default:
+	    fprintf(stderr, "Usage: %s [-t] [-s seed]\n", argv[0]);
+	    return 1;
+	}
+    }
+
+    srandom(Seed);
+
+    Count = PackKernels(Kernels);
+    if (Count == 1)
+	printf("No vector versions in this build, checking nothing.\n");
+
+    for (i = 1; i < Count; i++)
+	ret |= PackCheck(&Kernels[i]);
+
+    if (Bench)
+	for (i = 0; i < Count; i++)
+	    PackBench(&Kernels[i]);
+
+    return ret;
+}
+
+/*
+ * rhd_swap.c, for RHDHasAltivec(), logs through this.
+ */
+void
+xf86DrvMsg(int scrnIndex, MessageType type, const char *format, ...)
+{
+}
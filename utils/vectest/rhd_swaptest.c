@@ -0,0 +1,289 @@
+/*
+ * Copyright 2026  The radeonhd contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the byte swapping copies of rhd_swap.c: the C versions against a
+ * byte by byte swap, and the AltiVec versions against the C ones. Random
+ * sizes, with heads and tails off the 16 byte alignment the vector loops
+ * need, copies in place included. Times them all when asked to.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "rhd_swap.h"
+
+#define SWAP_SIZE_MAX  1024 /* largest random copy, in bytes */
+#define SWAP_COPIES    20000 /* random copies per kernel */
+#define SWAP_GUARD     64 /* bytes around each buffer which must stay as they are */
+
+#define TIME_SIZE      (64 << 10) /* one upload buffer */
+#define TIME_COPIES    20000
+
+struct SwapKernel {
+    const char *Name;
+    unsigned int Unit; /* bytes per swapped word */
+    const unsigned char *Order; /* where each byte of a word comes from */
+    RHDCopySwapProc Proc; /* what is checked */
+    RHDCopySwapProc Reference; /* what it is checked against, or NULL */
+};
+
+static const unsigned char Order32[4] = { 3, 2, 1, 0 };
+static const unsigned char OrderHDW[4] = { 2, 3, 0, 1 };
+static const unsigned char Order16[2] = { 1, 0 };
+
+/*
+ * The C versions always, the AltiVec ones when built and when this CPU has
+ * it.
+ */
+static int
+SwapKernels(struct SwapKernel *Kernels)
+{
+    int Count = 0;
+
+    Kernels[Count].Name = "Swap32 C";
+    Kernels[Count].Unit = 4;
+    Kernels[Count].Order = Order32;
+    Kernels[Count].Proc = RHDCopySwap32C;
+    Kernels[Count++].Reference = NULL;
+
+    Kernels[Count].Name = "SwapHDW C";
+    Kernels[Count].Unit = 4;
+    Kernels[Count].Order = OrderHDW;
+    Kernels[Count].Proc = RHDCopySwapHDWC;
+    Kernels[Count++].Reference = NULL;
+
+    Kernels[Count].Name = "Swap16 C";
+    Kernels[Count].Unit = 2;
+    Kernels[Count].Order = Order16;
+    Kernels[Count].Proc = RHDCopySwap16C;
+    Kernels[Count++].Reference = NULL;
+
+#ifdef USE_ALTIVEC
+    if (RHDHasAltivec()) {
+	Kernels[Count].Name = "Swap32 AltiVec";
+	Kernels[Count].Unit = 4;
+	Kernels[Count].Order = Order32;
+	Kernels[Count].Proc = RHDCopySwap32Altivec;
+	Kernels[Count++].Reference = RHDCopySwap32C;
+
+	Kernels[Count].Name = "SwapHDW AltiVec";
+	Kernels[Count].Unit = 4;
+	Kernels[Count].Order = OrderHDW;
+	Kernels[Count].Proc = RHDCopySwapHDWAltivec;
+	Kernels[Count++].Reference = RHDCopySwapHDWC;
+
+	Kernels[Count].Name = "Swap16 AltiVec";
+	Kernels[Count].Unit = 2;
+	Kernels[Count].Order = Order16;
+	Kernels[Count].Proc = RHDCopySwap16Altivec;
+	Kernels[Count++].Reference = RHDCopySwap16C;
+    } else
+	fprintf(stderr, "Built with AltiVec, but this CPU does not have it.\n");
+#endif
+
+    return Count;
+}
+
+/*
+ *
+ */
+static void
+SwapFill(CARD8 *Buffer, int Size)
+{
+    int i;
+
+    for (i = 0; i < Size; i++)
+	Buffer[i] = random() & 0xFF;
+}
+
+/*
+ *
+ */
+static CARD64
+SwapTime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (CARD64) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*
+ * Byte by byte, for checking the C versions. Only whole words get copied.
+ */
+static void
+SwapBytes(struct SwapKernel *Kernel, CARD8 *dst, CARD8 *src, unsigned int size)
+{
+    unsigned int i, j;
+
+    for (i = 0; (i + Kernel->Unit) <= size; i += Kernel->Unit)
+	for (j = 0; j < Kernel->Unit; j++)
+	    dst[i + j] = src[i + Kernel->Order[j]];
+}
+
+/*
+ * The driver only hands over buffers aligned to the word size, so the
+ * offsets are random multiples of that. The copy in place goes through a
+ * second source buffer, so both results can be compared.
+ */
+static int
+SwapCheck(struct SwapKernel *Kernel)
+{
+    static CARD8 Src[SWAP_SIZE_MAX + 16 + 2 * SWAP_GUARD] __attribute__ ((aligned (16)));
+    static CARD8 Reference[SWAP_SIZE_MAX + 16 + 2 * SWAP_GUARD] __attribute__ ((aligned (16)));
+    static CARD8 Result[SWAP_SIZE_MAX + 16 + 2 * SWAP_GUARD] __attribute__ ((aligned (16)));
+    unsigned int Size, SrcOffset, DstOffset, i;
+    Bool InPlace;
+    int Copy;
+
+    for (Copy = 0; Copy < SWAP_COPIES; Copy++) {
+	/* mostly short ones, where the head and tail handling is */
+	if (Copy & 1)
+	    Size = random() % 64;
+	else
+	    Size = random() % (SWAP_SIZE_MAX + 1);
+
+	InPlace = !(random() % 4);
+	SrcOffset = SWAP_GUARD + (random() % 16) / Kernel->Unit * Kernel->Unit;
+	if (InPlace)
+	    DstOffset = SrcOffset;
+	else
+	    DstOffset = SWAP_GUARD + (random() % 16) / Kernel->Unit * Kernel->Unit;
+
+	SwapFill(Src, sizeof(Src));
+	memset(Reference, 0xA5, sizeof(Reference));
+	memset(Result, 0xA5, sizeof(Result));
+
+	if (InPlace) {
+	    memcpy(Reference, Src, sizeof(Src));
+	    memcpy(Result, Src, sizeof(Src));
+	}
+
+	if (Kernel->Reference)
+	    Kernel->Reference(Reference + DstOffset,
+			      (InPlace ? Reference : Src) + SrcOffset, Size);
+	else
+	    SwapBytes(Kernel, Reference + DstOffset, Src + SrcOffset, Size);
+
+	Kernel->Proc(Result + DstOffset, (InPlace ? Result : Src) + SrcOffset,
+		     Size);
+
+	if (!memcmp(Reference, Result, sizeof(Result)))
+	    continue;
+
+	for (i = 0; Reference[i] == Result[i]; i++)
+	    ;
+
+	fprintf(stderr, "%s: FAILED: %u bytes%s, dst at +%u, src at +%u: "
+		"byte %d is 0x%02X instead of 0x%02X.\n", Kernel->Name, Size,
+		InPlace ? " in place" : "", (DstOffset - SWAP_GUARD) & 15,
+		(SrcOffset - SWAP_GUARD) & 15, (int) i - (int) DstOffset,
+		Result[i], Reference[i]);
+	return 1;
+    }
+
+    printf("%s: %d copies OK.\n", Kernel->Name, SWAP_COPIES);
+    return 0;
+}
+
+/*
+ * A full upload buffer over and over: once with everything aligned, once
+ * with dst and src a word off.
+ */
+static void
+SwapBench(struct SwapKernel *Kernel)
+{
+    static CARD8 Src[TIME_SIZE + 16] __attribute__ ((aligned (16)));
+    static CARD8 Dst[TIME_SIZE + 16] __attribute__ ((aligned (16)));
+    CARD64 Start, Aligned, Unaligned;
+    int i;
+
+    SwapFill(Src, sizeof(Src));
+
+    Start = SwapTime();
+    for (i = 0; i < TIME_COPIES; i++)
+	Kernel->Proc(Dst, Src, TIME_SIZE);
+    Aligned = SwapTime() - Start;
+
+    Start = SwapTime();
+    for (i = 0; i < TIME_COPIES; i++)
+	Kernel->Proc(Dst + 4, Src + 4, TIME_SIZE);
+    Unaligned = SwapTime() - Start;
+
+    printf("%-16s %8.0f MB/s aligned, %8.0f MB/s unaligned\n", Kernel->Name,
+	   ((double) TIME_SIZE * TIME_COPIES) / (Aligned ? Aligned : 1),
+	   ((double) TIME_SIZE * TIME_COPIES) / (Unaligned ? Unaligned : 1));
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct SwapKernel Kernels[6];
+    unsigned int Seed = 1;
+    Bool Bench = FALSE;
+    int Count, i, c, ret = 0;
+
+    while ((c = getopt(argc, argv, "s:t")) != -1) {
+	switch (c) {
+	case 's':
+	    Seed = strtoul(optarg, NULL, 0);
+	    break;
+	case 't':
+	    Bench = TRUE;
+	    break;
+	default:
+	    fprintf(stderr, "Usage: %s [-t] [-s seed]\n", argv[0]);
+	    return 1;
+	}
+    }
+
+    srandom(Seed);
+
+    Count = SwapKernels(Kernels);
+
+    for (i = 0; i < Count; i++)
+	ret |= SwapCheck(&Kernels[i]);
+
+    if (Bench)
+	for (i = 0; i < Count; i++)
+	    SwapBench(&Kernels[i]);
+
+    return ret;
+}
+
+/*
+ * rhd_swap.c logs through this.
+ */
+void
+xf86DrvMsg(int scrnIndex, MessageType type, const char *format, ...)
+{
+}